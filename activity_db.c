@@ -0,0 +1,182 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sqlite3.h>
+#include "activity_db.h"
+
+// synchronous=NORMAL: in WAL mode commits are not synced one by one, so a
+// power cut can roll back the last few, but never corrupts the database;
+// the day files stay the record
+static const char schema[] =
+    "PRAGMA journal_mode = WAL;"
+    "PRAGMA synchronous = NORMAL;"
+    "CREATE TABLE IF NOT EXISTS events ("
+    "  id INTEGER PRIMARY KEY,"
+    "  timestamp INTEGER NOT NULL,"
+    "  day TEXT NOT NULL,"
+    "  hour INTEGER NOT NULL,"
+    "  event_type TEXT NOT NULL,"
+    "  group_id INTEGER,"
+    "  event_data TEXT NOT NULL,"
+    "  is_paused INTEGER NOT NULL,"
+    "  in_deep_work_session INTEGER NOT NULL,"
+    "  next_break_in_minutes INTEGER NOT NULL,"
+    "  total_breaks_today INTEGER NOT NULL,"
+    "  total_work_minutes_today INTEGER NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS events_timestamp ON events (timestamp, hour);"
+    "CREATE INDEX IF NOT EXISTS events_type ON events (event_type, timestamp, day);"
+    "PRAGMA user_version = 1;";
+
+// The type name and event_data come out of the JSON line, so the database
+// and the log cannot disagree on them
+static const char insert_sql[] =
+    "INSERT INTO events (timestamp, day, hour, event_type, group_id, event_data, is_paused,"
+    "  in_deep_work_session, next_break_in_minutes, total_breaks_today, total_work_minutes_today)"
+    " VALUES (?1, ?2, ?3, json_extract(?4, '$.event_type'), ?5, json_extract(?4, '$.event_data'),"
+    "  ?6, ?7, ?8, ?9, ?10)";
+
+// A batch takes the write lock at BEGIN IMMEDIATE, so only it and COMMIT
+// can find the database locked; each waits out busy_timeout up to
+// DB_BUSY_TRIES times. Any other error rolls the batch back and closes the
+// database, which the next batch opens again once DB_RETRY_SECONDS have
+// passed; events in between are dropped and counted.
+#define DB_BUSY_TRIES 3
+#define DB_RETRY_SECONDS 60
+
+static sqlite3* db = NULL;
+static sqlite3_stmt* insert_event = NULL;
+static sqlite3_stmt* begin_batch = NULL;
+static sqlite3_stmt* commit_batch = NULL;
+static bool in_batch = false;
+static char db_path[512];           // empty once closed for good
+static time_t retry_at = 0;
+static unsigned long batch_events = 0;
+static unsigned long events_dropped = 0;
+static int db_is_open = 0;
+
+static void close_db(void) {
+    if (!db) {
+        return;
+    }
+    // Finalizing first lets sqlite3_close roll back an open transaction
+    sqlite3_finalize(insert_event);
+    sqlite3_finalize(begin_batch);
+    sqlite3_finalize(commit_batch);
+    insert_event = begin_batch = commit_batch = NULL;
+    in_batch = false;
+    sqlite3_close(db);
+    db = NULL;
+    __atomic_store_n(&db_is_open, 0, __ATOMIC_RELAXED);
+}
+
+static void fail(const char* what) {
+    fprintf(stderr, "Activity database %s failed: %s; retrying in %d s\n",
+            what, db ? sqlite3_errmsg(db) : "out of memory", DB_RETRY_SECONDS);
+    __atomic_add_fetch(&events_dropped, batch_events, __ATOMIC_RELAXED);
+    batch_events = 0;
+    close_db();
+    retry_at = time(NULL) + DB_RETRY_SECONDS;
+}
+
+static bool step(sqlite3_stmt* statement) {
+    int result;
+    for (int tries = 1; (result = sqlite3_step(statement)) == SQLITE_BUSY && tries < DB_BUSY_TRIES; tries++) {
+        sqlite3_reset(statement);
+    }
+    sqlite3_reset(statement);
+    return result == SQLITE_DONE;
+}
+
+static bool open_db(void) {
+    if (sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        fail("open");
+        return false;
+    }
+    sqlite3_busy_timeout(db, 1000);
+    if (sqlite3_exec(db, schema, NULL, NULL, NULL) != SQLITE_OK
+        || sqlite3_prepare_v3(db, insert_sql, -1, SQLITE_PREPARE_PERSISTENT, &insert_event, NULL) != SQLITE_OK
+        || sqlite3_prepare_v3(db, "BEGIN IMMEDIATE", -1, SQLITE_PREPARE_PERSISTENT, &begin_batch, NULL) != SQLITE_OK
+        || sqlite3_prepare_v3(db, "COMMIT", -1, SQLITE_PREPARE_PERSISTENT, &commit_batch, NULL) != SQLITE_OK) {
+        fail("setup");
+        return false;
+    }
+    __atomic_store_n(&db_is_open, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool activity_db_open(const char* path) {
+    snprintf(db_path, sizeof(db_path), "%s", path);
+    return open_db();
+}
+
+void activity_db_add(const ActivityEvent* event) {
+    if (!db) {
+        if (db_path[0] == '\0') {
+            return;
+        }
+        // Not before the retry time, unless the clock was set back past it
+        time_t now = time(NULL);
+        if ((now < retry_at && retry_at - now <= DB_RETRY_SECONDS) || !open_db()) {
+            __atomic_add_fetch(&events_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    batch_events++;
+    if (!in_batch) {
+        if (!step(begin_batch)) {
+            fail("begin");
+            return;
+        }
+        in_batch = true;
+    }
+
+    char json[2048], day[16];
+    size_t len = activity_event_to_json(event, json, sizeof(json));
+    struct tm local_time;
+    localtime_r(&event->timestamp, &local_time);
+    strftime(day, sizeof(day), "%Y-%m-%d", &local_time);
+
+    sqlite3_bind_int64(insert_event, 1, (sqlite3_int64)event->timestamp);
+    sqlite3_bind_text(insert_event, 2, day, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(insert_event, 3, local_time.tm_hour);
+    sqlite3_bind_text(insert_event, 4, json, (int)len, SQLITE_TRANSIENT);
+    if (event->group_id != 0) {
+        sqlite3_bind_int64(insert_event, 5, event->group_id);
+    } else {
+        sqlite3_bind_null(insert_event, 5);
+    }
+    sqlite3_bind_int(insert_event, 6, event->system_state.is_paused);
+    sqlite3_bind_int(insert_event, 7, event->system_state.in_deep_work_session);
+    sqlite3_bind_int(insert_event, 8, event->system_state.next_break_in_minutes);
+    sqlite3_bind_int(insert_event, 9, event->system_state.total_breaks_today);
+    sqlite3_bind_int(insert_event, 10, event->system_state.total_work_minutes_today);
+    if (!step(insert_event)) {
+        fail("insert");
+    }
+}
+
+void activity_db_commit(void) {
+    if (!db || !in_batch) {
+        return;
+    }
+    in_batch = false;
+    if (!step(commit_batch)) {
+        fail("commit");
+        return;
+    }
+    batch_events = 0;
+}
+
+void activity_db_close(void) {
+    close_db();
+    db_path[0] = '\0';
+}
+
+unsigned long activity_db_dropped(void) {
+    return __atomic_load_n(&events_dropped, __ATOMIC_RELAXED);
+}
+
+bool activity_db_is_open(void) {
+    return __atomic_load_n(&db_is_open, __ATOMIC_RELAXED);
+}
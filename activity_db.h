@@ -0,0 +1,36 @@
+#ifndef ACTIVITY_DB_H
+#define ACTIVITY_DB_H
+
+#include <stdbool.h>
+#include "activity_log.h"
+
+// Optional SQLite copy of the activity log (--activity-db) for ad-hoc
+// queries over months of history: activity/activity.db, in WAL mode so
+// readers never hold up the logger, which inserts each batch of events
+// in one transaction through a prepared statement.
+//
+//   events(id INTEGER PRIMARY KEY, timestamp, day, hour, event_type,
+//          group_id, event_data, is_paused, in_deep_work_session,
+//          next_break_in_minutes, total_breaks_today, total_work_minutes_today)
+//
+// timestamp is Unix seconds; day ("YYYY-MM-DD") and hour are local;
+// event_data is the JSON object of the log line, group_id NULL outside a
+// group. Indexed on (timestamp, hour) and (event_type, timestamp, day), so
+// hourly activity and per-type counts by time or day read only an index.
+bool activity_db_open(const char* path);
+
+// Insert event, opening a transaction if none is. An error rolls the batch
+// back and closes the database; a later batch opens it again.
+void activity_db_add(const ActivityEvent* event);
+
+// Commit what activity_db_add inserted, if anything
+void activity_db_commit(void);
+
+void activity_db_close(void);
+
+// Events that did not reach the database: those of batches an error rolled
+// back, and those logged while it was closed after one. Safe from any thread.
+unsigned long activity_db_dropped(void);
+bool activity_db_is_open(void);
+
+#endif
@@ -0,0 +1,292 @@
+// JSON form of an activity event: the format of activity_DATE.jsonl and of
+// `restly-log cat --json`
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "activity_log.h"
+#include "crc32c.h"
+
+// The last field of every line is the CRC32C of the line before it, so a
+// reader can tell a whole record from a torn or overwritten one
+#define CRC_FIELD ",\"crc32c\":\""
+#define CRC_FIELD_LEN (sizeof(CRC_FIELD) - 1)
+#define CRC_TAIL_LEN (CRC_FIELD_LEN + 8 + 2)    // field, hex digits, then "}
+
+static const char* event_type_to_string(ActivityEventType type) {
+    switch (type) {
+        case EVENT_BREAK_SHOWN: return "break_shown";
+        case EVENT_BREAK_COMPLETED: return "break_completed";
+        case EVENT_SESSION_STARTED: return "session_started";
+        case EVENT_SESSION_ENDED: return "session_ended";
+        case EVENT_PAUSE_TOGGLED: return "pause_toggled";
+        case EVENT_BREAK_RESCHEDULED: return "break_rescheduled";
+        case EVENT_COMMAND_RECEIVED: return "command_received";
+        case EVENT_APP_STARTED: return "app_started";
+        case EVENT_APP_STOPPED: return "app_stopped";
+        case EVENT_COMMAND_CORRECTED: return "command_corrected";
+        case EVENT_POPUP_SHOWN: return "popup_shown";
+        default: return "unknown";
+    }
+}
+
+static const char* break_type_to_string(BreakType type) {
+    switch (type) {
+        case BREAK_TYPE_EYE_CARE: return "eye_care";
+        case BREAK_TYPE_CUSTOM_MESSAGE: return "custom_message";
+        default: return "unknown";
+    }
+}
+
+static const char* session_type_to_string(SessionType type) {
+    switch (type) {
+        case SESSION_TYPE_DEEP_WORK: return "deep_work";
+        case SESSION_TYPE_REGULAR: return "regular";
+        default: return "unknown";
+    }
+}
+
+// JSON object fields written into a fixed buffer; commas go before every
+// field but the first of each object, so nothing has to be taken back
+typedef struct {
+    char* buf;
+    size_t len;
+    size_t size;
+    bool first;
+} Record;
+
+static void put(Record* r, const char* format, ...) {
+    if (r->len >= r->size) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(r->buf + r->len, r->size - r->len, format, args);
+    va_end(args);
+    if (n > 0) {
+        r->len = r->len + n < r->size ? r->len + n : r->size;
+    }
+}
+
+static void put_key(Record* r, const char* key) {
+    put(r, r->first ? "\"%s\":" : ",\"%s\":", key);
+    r->first = false;
+}
+
+static void open_object(Record* r, const char* key) {
+    if (key) {
+        put_key(r, key);
+    }
+    put(r, "{");
+    r->first = true;
+}
+
+static void close_object(Record* r) {
+    put(r, "}");
+    r->first = false;
+}
+
+static void put_string(Record* r, const char* key, const char* value) {
+    put_key(r, key);
+    put(r, "\"");
+    for (const unsigned char* p = (const unsigned char*)value; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            put(r, "\\%c", *p);
+        } else if (*p < 0x20) {
+            put(r, "\\u%04x", *p);
+        } else if (r->len + 1 < r->size) {
+            r->buf[r->len++] = (char)*p;
+            r->buf[r->len] = '\0';
+        }
+    }
+    put(r, "\"");
+}
+
+static void put_int(Record* r, const char* key, int value) {
+    put_key(r, key);
+    put(r, "%d", value);
+}
+
+static void put_bool(Record* r, const char* key, bool value) {
+    put_key(r, key);
+    put(r, value ? "true" : "false");
+}
+
+size_t activity_event_to_json(const ActivityEvent* event, char* buf, size_t size) {
+    Record r = { buf, 0, size - 1, true };  // room kept for the newline
+    buf[0] = '\0';
+
+    // Convert timestamp to ISO 8601 format
+    struct tm utc_time;
+    char timestamp_str[32];
+    gmtime_r(&event->timestamp, &utc_time);
+    strftime(timestamp_str, sizeof(timestamp_str), "%Y-%m-%dT%H:%M:%SZ", &utc_time);
+
+    open_object(&r, NULL);
+    put_string(&r, "timestamp", timestamp_str);
+    put_string(&r, "event_type", event_type_to_string(event->event_type));
+    if (event->group_id != 0) {
+        put_key(&r, "group");
+        put(&r, "%u", event->group_id);
+    }
+
+    // Event-specific data
+    open_object(&r, "event_data");
+    switch (event->event_type) {
+        case EVENT_BREAK_SHOWN:
+        case EVENT_BREAK_COMPLETED:
+            put_string(&r, "break_type", break_type_to_string(event->event_data.break_event.break_type));
+            put_int(&r, "duration_seconds", event->event_data.break_event.duration_seconds);
+            if (event->event_type == EVENT_BREAK_COMPLETED) {
+                put_bool(&r, "user_dismissed", event->event_data.break_event.user_dismissed);
+            }
+            break;
+            
+        case EVENT_SESSION_STARTED:
+        case EVENT_SESSION_ENDED:
+            put_string(&r, "session_type", session_type_to_string(event->event_data.session_event.session_type));
+            put_int(&r, "duration_minutes", event->event_data.session_event.duration_minutes);
+            break;
+            
+        case EVENT_PAUSE_TOGGLED:
+            put_bool(&r, "is_paused", event->event_data.pause_event.is_paused);
+            break;
+            
+        case EVENT_BREAK_RESCHEDULED:
+            put_int(&r, "delay_minutes", event->event_data.reschedule_event.delay_minutes);
+            break;
+            
+        case EVENT_COMMAND_RECEIVED:
+            put_string(&r, "command_text", event->event_data.command_event.command_text);
+            put_string(&r, "intent", event->event_data.command_event.intent);
+            put_string(&r, "intent_source", event->event_data.command_event.intent_source);
+            put_key(&r, "confidence");
+            put(&r, "%.3f", event->event_data.command_event.confidence);
+            break;
+            
+        case EVENT_COMMAND_CORRECTED:
+            put_string(&r, "typo", event->event_data.correction_event.typo);
+            put_string(&r, "correction", event->event_data.correction_event.correction);
+            put_int(&r, "distance", event->event_data.correction_event.distance);
+            break;
+            
+        case EVENT_POPUP_SHOWN:
+            put_string(&r, "kind", event->event_data.popup_event.kind);
+            put_int(&r, "latency_ms", event->event_data.popup_event.latency_ms);
+            put_bool(&r, "mapped", event->event_data.popup_event.mapped);
+            break;
+            
+        default:
+            break;
+    }
+    close_object(&r);
+    
+    // System state
+    open_object(&r, "system_state");
+    put_bool(&r, "is_paused", event->system_state.is_paused);
+    put_bool(&r, "in_deep_work_session", event->system_state.in_deep_work_session);
+    put_int(&r, "next_break_in_minutes", event->system_state.next_break_in_minutes);
+    put_int(&r, "total_breaks_today", event->system_state.total_breaks_today);
+    put_int(&r, "total_work_minutes_today", event->system_state.total_work_minutes_today);
+    close_object(&r);
+    if (r.len < r.size) {
+        put(&r, CRC_FIELD "%08x\"", (unsigned)crc32c(buf, r.len));
+    }
+    close_object(&r);
+
+    // A record cut short by the buffer would not parse; drop it instead
+    if (r.len >= r.size) {
+        return 0;
+    }
+    buf[r.len++] = '\n';
+    return r.len;
+}
+
+bool activity_json_line_ok(const char* line, size_t len) {
+    if (len > 0 && line[len - 1] == '\n') {
+        len--;
+    }
+    if (len < 2 || line[0] != '{' || line[len - 1] != '}' || memchr(line, '\0', len)) {
+        return false;
+    }
+    if (len < CRC_TAIL_LEN || memcmp(line + len - CRC_TAIL_LEN, CRC_FIELD, CRC_FIELD_LEN) != 0) {
+        // Written before lines carried a CRC: whole if it closes its object
+        return true;
+    }
+    uint32_t crc = 0;
+    for (const char* p = line + len - CRC_TAIL_LEN + CRC_FIELD_LEN; p < line + len - 2; p++) {
+        int digit = *p >= '0' && *p <= '9' ? *p - '0' : *p >= 'a' && *p <= 'f' ? *p - 'a' + 10 : -1;
+        if (digit < 0) {
+            return false;
+        }
+        crc = crc << 4 | (uint32_t)digit;
+    }
+    return line[len - 2] == '"' && crc == crc32c(line, len - CRC_TAIL_LEN);
+}
+
+// Value after the first "key": of a line, NULL if it has none. Every quote
+// inside a JSON string is escaped, so a string cannot pass for a key.
+static const char* json_value(const char* line, const char* key) {
+    char pattern[40];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char* p = strstr(line, pattern);
+    return p ? p + strlen(pattern) : NULL;
+}
+
+static bool json_string_is(const char* value, const char* text) {
+    size_t n = strlen(text);
+    return value && value[0] == '"' && strncmp(value + 1, text, n) == 0 && value[n + 1] == '"';
+}
+
+bool activity_event_from_json(const char* line, ActivityEvent* event) {
+    memset(event, 0, sizeof(*event));
+    const char* value = json_value(line, "timestamp");
+    struct tm utc_time = {0};
+    if (!value || sscanf(value, "\"%d-%d-%dT%d:%d:%dZ\"", &utc_time.tm_year, &utc_time.tm_mon,
+                         &utc_time.tm_mday, &utc_time.tm_hour, &utc_time.tm_min, &utc_time.tm_sec) != 6) {
+        return false;
+    }
+    utc_time.tm_year -= 1900;
+    utc_time.tm_mon--;
+    event->timestamp = timegm(&utc_time);
+
+    value = json_value(line, "event_type");
+    ActivityEventType type = EVENT_BREAK_SHOWN;
+    while (!json_string_is(value, event_type_to_string(type))) {
+        if (type == EVENT_POPUP_SHOWN) {
+            return false;
+        }
+        type++;
+    }
+    event->event_type = type;
+    if ((value = json_value(line, "group")) != NULL) {
+        event->group_id = (unsigned int)strtoul(value, NULL, 10);
+    }
+
+    switch (type) {
+        case EVENT_BREAK_SHOWN:
+        case EVENT_BREAK_COMPLETED:
+            event->event_data.break_event.break_type =
+                json_string_is(json_value(line, "break_type"), break_type_to_string(BREAK_TYPE_EYE_CARE))
+                    ? BREAK_TYPE_EYE_CARE : BREAK_TYPE_CUSTOM_MESSAGE;
+            break;
+        case EVENT_SESSION_STARTED:
+        case EVENT_SESSION_ENDED:
+            event->event_data.session_event.session_type =
+                json_string_is(json_value(line, "session_type"), session_type_to_string(SESSION_TYPE_DEEP_WORK))
+                    ? SESSION_TYPE_DEEP_WORK : SESSION_TYPE_REGULAR;
+            break;
+        default:
+            break;
+    }
+
+    if ((value = json_value(line, "total_breaks_today")) != NULL) {
+        event->system_state.total_breaks_today = atoi(value);
+    }
+    if ((value = json_value(line, "total_work_minutes_today")) != NULL) {
+        event->system_state.total_work_minutes_today = atoi(value);
+    }
+    return true;
+}
@@ -1,88 +1,279 @@
+#define _DEFAULT_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/eventfd.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <zlib.h>
 #include "activity_log.h"
+#include "activity_db.h"
+#include "rlog.h"
+#include "rollup.h"
+
+// One JSON line per event (or one binary record, see rlog.h), appended to
+// the day's file, which stays open until the date changes. O_APPEND makes
+// each write land whole at the end, even with other writers.
+#define RECORD_MAX 2048
+
+// Events are handed to a logger thread through a bounded lock-free ring
+// (Vyukov's MPSC queue: a sequence number per slot, producers claim slots
+// with a CAS), so a slow disk never holds up the scheduler. A full ring
+// drops the event and counts it. The thread formats what is queued into one
+// buffer of whole records and writes it with a single write().
+#define LOG_RING_SIZE 256           // power of two, about 100 KB of events
+#define LOG_BATCH_BYTES (16 * RECORD_MAX)
+#define LOG_BATCH_RECORDS 1024
+
+// Each day's log has a sidecar index, activity_DATE.jsonl.idx (or .rlog.idx),
+// so readers can count and find events without parsing the log:
+//
+//   header   'R' 'I' 'D' 'X' version format(ActivityLogFormat) 0 0
+//   entry    u32 offset, u16 length, u8 event_type, u8 local hour,
+//            i64 timestamp (little-endian, 16 bytes, one per record)
+//
+// Entries are appended, in log order, after the records they describe are
+// written. An index that does not end where its log ends is stale.
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 8
+#define INDEX_ENTRY_SIZE 16
+
+// The day's counters as of the last event written, so a restart carries on
+// from them instead of from zero: activity/counters holds one fixed-width
+// line, "YYYY-MM-DD breaks work_minutes", rewritten in place when it changes
+#define COUNTERS_LINE "%-10s %10d %10d\n"
+#define COUNTERS_LINE_SIZE 33
+
+// Per-day and per-hour totals (see rollup.h), counted by the logger as it
+// takes events. The file is saved a minute after the first event it lacks,
+// or once that many have piled up, and on shutdown; if it is missing or
+// damaged at startup it is counted again from the logs of its days.
+#define ROLLUP_SAVE_SECONDS 60
+#define ROLLUP_SAVE_EVENTS 256
+static Rollup rollup;
+static int rollup_unsaved = 0;          // events counted since the file was saved
+static time_t rollup_unsaved_since = 0;
+
+// With --activity-db every event also goes to activity/activity.db, a
+// transaction per batch (see activity_db.h)
+static bool db_enabled = false;
+
+typedef struct {
+    size_t offset;                  // in the batch until written, then in the file
+    size_t length;
+    ActivityEventType event_type;
+    time_t timestamp;
+} IndexEntry;
+
+typedef struct {
+    unsigned long sequence;         // == position: free for it; position + 1: filled
+    ActivityEvent event;
+} LogSlot;
+
+static LogSlot log_ring[LOG_RING_SIZE];
+static unsigned long enqueue_position;  // shared by producers
+static unsigned long dequeue_position;  // logger thread only
+static unsigned long flushed_position;  // dequeue_position once its batch is written
+static unsigned long events_written;
+static unsigned long events_dropped;
+
+static pthread_t logger_thread;
+static bool logger_running = false;
+static int logger_wake_fd = -1;         // eventfd, written when the thread may be asleep
+static int logger_sleeping = 0;
+static int logger_stopping = 0;
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flush_done = PTHREAD_COND_INITIALIZER;
+
+// Days before today are gzipped in the background, one archiver thread at
+// a time; a rollover while it runs makes it scan again when done
+#define ARCHIVE_GRACE_SECONDS 60    // for events stamped just before midnight
+#define ARCHIVE_CHUNK 65536
+static pthread_t archiver_thread;
+static bool archiver_joinable = false;
+static bool archiver_running = false;
+static bool archiver_again = false;
+static int archiver_stopping = 0;
+static pthread_mutex_t archive_lock = PTHREAD_MUTEX_INITIALIZER;
 
 // Global variables for activity tracking
-static FILE* log_file = NULL;
+static int log_fd = -1;
+static int index_fd = -1;           // -1 also while the day's index is not kept
+static int counters_fd = -1;
+static char log_day[16];            // date of the open file, "YYYY-MM-DD"
+static char activity_dir[256];
 static char log_file_path[512];
+static char rollup_path[sizeof(activity_dir) + 16];
+static ActivityLogFormat log_format = ACTIVITY_LOG_JSONL;
+static const char* const log_extensions[] = { ".jsonl", ".rlog" };    // by ActivityLogFormat
+static RlogContext rlog_context;
+static time_t rlog_segment_time = 0;    // an event of the open binary segment's day, 0 for none
+static int rlog_segment_records = 0;
 static int daily_break_count = 0;
 static int daily_work_minutes = 0;
 static time_t session_start_time = 0;
+static unsigned int current_group = 0;
+static unsigned int last_group = 0;
+static int counters_day = -1;       // tm_year * 1000 + tm_yday the counters are for
 
 // External variables from timer.c (we'll need to expose these)
 extern bool is_paused;
 extern bool in_deep_work_session;
 extern time_t next_break_time;
 
+static void* logger_main(void* arg);
+static void start_archiver(void);
+static void day_of(time_t timestamp, char* day);
+static void rebuild_rollup(time_t now);
+
+static void start_logger(void) {
+    for (unsigned long i = 0; i < LOG_RING_SIZE; i++) {
+        log_ring[i].sequence = i;
+    }
+    enqueue_position = dequeue_position = flushed_position = 0;
+    logger_stopping = 0;
+
+    logger_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (logger_wake_fd < 0) {
+        return;
+    }
+    if (pthread_create(&logger_thread, NULL, logger_main, NULL) != 0) {
+        // Events are then written from the caller, as before
+        close(logger_wake_fd);
+        logger_wake_fd = -1;
+        return;
+    }
+    logger_running = true;
+}
+
+static void restore_counters(time_t now) {
+    char path[sizeof(activity_dir) + 16];
+    snprintf(path, sizeof(path), "%s/counters", activity_dir);
+    counters_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (counters_fd < 0) {
+        return;
+    }
+    char line[COUNTERS_LINE_SIZE + 1];
+    ssize_t n = pread(counters_fd, line, COUNTERS_LINE_SIZE, 0);
+    if (n != COUNTERS_LINE_SIZE) {
+        return;
+    }
+    line[n] = '\0';
+    char day[sizeof(log_day)], today[sizeof(log_day)];
+    int breaks, minutes;
+    day_of(now, today);
+    if (sscanf(line, "%10s %d %d", day, &breaks, &minutes) == 3 && strcmp(day, today) == 0
+        && breaks >= 0 && minutes >= 0) {
+        daily_break_count = breaks;
+        daily_work_minutes = minutes;
+    }
+}
+
+// Called with the last event of each batch once it is written; only
+// touches the file when the line changes, about once a minute at most
+static void save_counters(time_t timestamp, int breaks, int minutes) {
+    static char saved[64];
+    char day[sizeof(log_day)], line[sizeof(saved)];
+    if (counters_fd < 0) {
+        return;
+    }
+    day_of(timestamp, day);
+    if (snprintf(line, sizeof(line), COUNTERS_LINE, day, breaks, minutes) != COUNTERS_LINE_SIZE
+        || strcmp(line, saved) == 0) {
+        return;
+    }
+    if (pwrite(counters_fd, line, COUNTERS_LINE_SIZE, 0) == COUNTERS_LINE_SIZE) {
+        memcpy(saved, line, sizeof(saved));
+    }
+}
+
+bool activity_log_format_from_name(const char* name, ActivityLogFormat* format) {
+    if (strcmp(name, "jsonl") == 0) {
+        *format = ACTIVITY_LOG_JSONL;
+    } else if (strcmp(name, "binary") == 0) {
+        *format = ACTIVITY_LOG_BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void activity_log_set_format(ActivityLogFormat format) {
+    log_format = format;
+}
+
+void activity_log_set_db(bool enabled) {
+    db_enabled = enabled;
+}
+
 void init_activity_logging(void) {
     // Create ~/.config/restly/activity/ directory
     char config_dir[256];
     snprintf(config_dir, sizeof(config_dir), "%s/.config/restly", getenv("HOME"));
     mkdir(config_dir, 0755);
     
-    char activity_dir[256];
     snprintf(activity_dir, sizeof(activity_dir), "%s/activity", config_dir);
     mkdir(activity_dir, 0755);
     
-    // Create daily log file with current date
+    // The daily log file is opened with the first event
     time_t now = time(NULL);
-    struct tm* local_time = localtime(&now);
-    char date_str[16];
-    strftime(date_str, sizeof(date_str), "%Y-%m-%d", local_time);
-    
-    snprintf(log_file_path, sizeof(log_file_path), 
-             "%s/activity_%s.jsonl", activity_dir, date_str);
     
-    // Reset daily counters (in case app restarted same day)
+    // Carry on from today's counters if the app restarted the same day
     daily_break_count = 0;
     daily_work_minutes = 0;
     session_start_time = now;
+    restore_counters(now);
+    snprintf(rollup_path, sizeof(rollup_path), "%s/rollup", activity_dir);
+    rollup_unsaved = 0;
+    if (!rollup_load(&rollup, rollup_path)) {
+        rebuild_rollup(now);
+    }
+    if (db_enabled) {
+        char db_path[sizeof(activity_dir) + 16];
+        snprintf(db_path, sizeof(db_path), "%s/activity.db", activity_dir);
+        activity_db_open(db_path);
+    }
     
+    start_logger();
     log_app_started();
+    start_archiver();
 }
 
 const char* get_activity_log_path(void) {
     return log_file_path;
 }
 
-const char* event_type_to_string(ActivityEventType type) {
-    switch (type) {
-        case EVENT_BREAK_SHOWN: return "break_shown";
-        case EVENT_BREAK_COMPLETED: return "break_completed";
-        case EVENT_SESSION_STARTED: return "session_started";
-        case EVENT_SESSION_ENDED: return "session_ended";
-        case EVENT_PAUSE_TOGGLED: return "pause_toggled";
-        case EVENT_BREAK_RESCHEDULED: return "break_rescheduled";
-        case EVENT_COMMAND_RECEIVED: return "command_received";
-        case EVENT_APP_STARTED: return "app_started";
-        case EVENT_APP_STOPPED: return "app_stopped";
-        default: return "unknown";
-    }
-}
-
-const char* break_type_to_string(BreakType type) {
-    switch (type) {
-        case BREAK_TYPE_EYE_CARE: return "eye_care";
-        case BREAK_TYPE_CUSTOM_MESSAGE: return "custom_message";
-        default: return "unknown";
+// The "today" counters start over at local midnight
+static void roll_daily_counters(time_t now) {
+    struct tm local_time;
+    localtime_r(&now, &local_time);
+    int day = local_time.tm_year * 1000 + local_time.tm_yday;
+    if (day == counters_day) {
+        return;
     }
-}
-
-const char* session_type_to_string(SessionType type) {
-    switch (type) {
-        case SESSION_TYPE_DEEP_WORK: return "deep_work";
-        case SESSION_TYPE_REGULAR: return "regular";
-        default: return "unknown";
+    if (counters_day >= 0) {
+        daily_break_count = 0;
+        daily_work_minutes = 0;
+        local_time.tm_hour = local_time.tm_min = local_time.tm_sec = 0;
+        local_time.tm_isdst = -1;
+        time_t midnight = mktime(&local_time);
+        if (session_start_time < midnight) {
+            session_start_time = midnight;
+        }
     }
+    counters_day = day;
 }
 
 void get_current_system_state(ActivityEvent* event) {
     time_t current_time = time(NULL);
+    roll_daily_counters(current_time);
     
     // Note: These extern variables need to be exposed from timer.c
     event->system_state.is_paused = is_paused;
@@ -92,105 +283,708 @@ void get_current_system_state(ActivityEvent* event) {
     event->system_state.total_work_minutes_today = daily_work_minutes + ((current_time - session_start_time) / 60);
 }
 
-void log_activity_event(ActivityEvent* event) {
-    FILE* file = fopen(log_file_path, "a");
-    if (!file) {
-        fprintf(stderr, "Failed to open activity log file: %s\n", strerror(errno));
-        return;
+static void day_of(time_t timestamp, char* day) {
+    struct tm local_time;
+    localtime_r(&timestamp, &local_time);
+    strftime(day, sizeof(log_day), "%Y-%m-%d", &local_time);
+}
+
+static void close_log(void) {
+    if (log_fd >= 0) {
+        close(log_fd);
+        log_fd = -1;
     }
-    
-    // Convert timestamp to ISO 8601 format
-    struct tm* utc_time = gmtime(&event->timestamp);
-    char timestamp_str[32];
-    strftime(timestamp_str, sizeof(timestamp_str), "%Y-%m-%dT%H:%M:%SZ", utc_time);
-    
-    // Write JSON event
-    fprintf(file, "{");
-    fprintf(file, "\"timestamp\":\"%s\",", timestamp_str);
-    fprintf(file, "\"event_type\":\"%s\",", event_type_to_string(event->event_type));
-    
-    // Event-specific data
-    fprintf(file, "\"event_data\":{");
-    switch (event->event_type) {
-        case EVENT_BREAK_SHOWN:
-        case EVENT_BREAK_COMPLETED:
-            fprintf(file, "\"break_type\":\"%s\",", 
-                   break_type_to_string(event->event_data.break_event.break_type));
-            fprintf(file, "\"duration_seconds\":%d,", 
-                   event->event_data.break_event.duration_seconds);
-            if (event->event_type == EVENT_BREAK_COMPLETED) {
-                fprintf(file, "\"user_dismissed\":%s,", 
-                       event->event_data.break_event.user_dismissed ? "true" : "false");
+    if (index_fd >= 0) {
+        close(index_fd);
+        index_fd = -1;
+    }
+}
+
+static bool write_all(int fd, const void* buf, size_t len) {
+    ssize_t written;
+    do {
+        written = write(fd, buf, len);
+    } while (written < 0 && errno == EINTR);
+    return written == (ssize_t)len;
+}
+
+// Where the last record an index lists ends in its log, 0 if it lists none
+static off_t index_end(int fd) {
+    struct stat st;
+    uint8_t last[INDEX_ENTRY_SIZE];
+    if (fstat(fd, &st) < 0 || st.st_size <= INDEX_HEADER_SIZE
+        || (st.st_size - INDEX_HEADER_SIZE) % INDEX_ENTRY_SIZE != 0
+        || pread(fd, last, sizeof(last), st.st_size - INDEX_ENTRY_SIZE) != (ssize_t)sizeof(last)) {
+        return 0;
+    }
+    return (off_t)(last[0] | last[1] << 8 | last[2] << 16 | (uint32_t)last[3] << 24) + (last[4] | last[5] << 8);
+}
+
+// A crash or power cut can leave the log ending partway through a record,
+// or in zeros or stale blocks where the file grew but its data never
+// reached the disk; records carry a CRC32C to catch the latter.
+// The index is written after the records it lists, so everything up to
+// the end of its last one is whole and only what follows is checked;
+// without an index the whole log is. Returns where the log ends once the
+// torn tail is cut off, -1 if it cannot be read.
+static off_t recover_log(int fd, off_t start, off_t size) {
+    if (start >= size) {
+        return size;
+    }
+    // A binary tail is read in the segment it continues, so the read
+    // starts far enough back to take in that segment's header: a segment
+    // is at most RLOG_SEGMENT_RECORDS records, except version 1 ones,
+    // which may need the whole file
+    off_t from = start;
+    if (log_format == ACTIVITY_LOG_BINARY) {
+        from = start > RLOG_SEGMENT_MAX ? start - RLOG_SEGMENT_MAX : 0;
+    }
+    size_t tail = (size_t)(size - start);
+    uint8_t* data = NULL;
+    size_t whole;
+    for (;;) {
+        size_t len = (size_t)(size - from);
+        free(data);
+        data = malloc(len);
+        if (!data || pread(fd, data, len, from) != (ssize_t)len) {
+            free(data);
+            return -1;
+        }
+        if (log_format == ACTIVITY_LOG_JSONL) {
+            // Whole lines with a matching CRC, up to the first that is not
+            whole = 0;
+            const uint8_t* newline;
+            while ((newline = memchr(data + whole, '\n', tail - whole)) != NULL
+                   && activity_json_line_ok((const char*)data + whole, (size_t)(newline - data) + 1 - whole)) {
+                whole = (size_t)(newline - data) + 1;
             }
             break;
-            
-        case EVENT_SESSION_STARTED:
-        case EVENT_SESSION_ENDED:
-            fprintf(file, "\"session_type\":\"%s\",", 
-                   session_type_to_string(event->event_data.session_event.session_type));
-            fprintf(file, "\"duration_minutes\":%d,", 
-                   event->event_data.session_event.duration_minutes);
-            break;
-            
-        case EVENT_PAUSE_TOGGLED:
-            fprintf(file, "\"is_paused\":%s,", 
-                   event->event_data.pause_event.is_paused ? "true" : "false");
+        }
+        size_t before = (size_t)(start - from);
+        int version = start > 0 ? rlog_version_at_end(data, before) : 0;
+        if (version == 0 && from > 0) {
+            from = 0;
+            continue;
+        }
+        whole = rlog_whole_records(data + before, tail, version);
+        break;
+    }
+    free(data);
+    if (whole < tail) {
+        fprintf(stderr, "Activity log %s: cutting off %zu bytes of torn records at its end\n",
+                log_file_path, tail - whole);
+        if (ftruncate(fd, start + (off_t)whole) < 0) {
+            return -1;
+        }
+    }
+    return start + (off_t)whole;
+}
+
+// The index goes with the log; a log started afresh (a day written again
+// after it was archived) starts its index afresh too. One that does not
+// end where the recovered log does (missing, or left behind or ahead by a
+// crash) is dropped for the day: entries added to it would make a partial
+// index look whole.
+static void open_index(off_t log_size) {
+    char index_path[sizeof(log_file_path) + 4];
+    snprintf(index_path, sizeof(index_path), "%s.idx", log_file_path);
+    index_fd = open(index_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC | (log_size == 0 ? O_TRUNC : 0), 0644);
+    if (index_fd < 0) {
+        return;
+    }
+    off_t start = index_end(index_fd);
+    off_t end = log_size > 0 ? recover_log(log_fd, start <= log_size ? start : 0, log_size) : 0;
+    struct stat st;
+    uint8_t header[INDEX_HEADER_SIZE] = { 'R', 'I', 'D', 'X', INDEX_VERSION, (uint8_t)log_format, 0, 0 };
+    if (end != start || fstat(index_fd, &st) < 0
+        || (st.st_size == 0 && !write_all(index_fd, header, sizeof(header)))) {
+        if (end != start) {
+            unlink(index_path);
+        }
+        close(index_fd);
+        index_fd = -1;
+    }
+}
+
+// Keeps log_fd on the file for the local date of timestamp
+static bool open_log_for(time_t timestamp) {
+    char day[sizeof(log_day)];
+    day_of(timestamp, day);
+    if (log_fd >= 0 && strcmp(day, log_day) == 0) {
+        return true;
+    }
+
+    close_log();
+    snprintf(log_file_path, sizeof(log_file_path), "%s/activity_%s%s", activity_dir, day,
+             log_extensions[log_format]);
+    log_fd = open(log_file_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd < 0) {
+        fprintf(stderr, "Failed to open activity log file: %s\n", strerror(errno));
+        return false;
+    }
+    struct stat st;
+    open_index(fstat(log_fd, &st) == 0 ? st.st_size : -1);
+    memcpy(log_day, day, sizeof(log_day));
+    return true;
+}
+
+static bool same_day(time_t a, time_t b) {
+    struct tm day_a, day_b;
+    localtime_r(&a, &day_a);
+    localtime_r(&b, &day_b);
+    return day_a.tm_yday == day_b.tm_yday && day_a.tm_year == day_b.tm_year;
+}
+
+// Binary records are deltas from the previous one in the file, so a
+// segment header starts every day and every run; a failed write starts
+// another, as the reader never saw what the next record refers to. One
+// also starts every RLOG_SEGMENT_RECORDS records, which bounds what a
+// damaged record costs a reader.
+// *header is set to the length of a segment header put before the record.
+static size_t encode_event(const ActivityEvent* event, char* buf, size_t size, size_t* header) {
+    *header = 0;
+    if (log_format == ACTIVITY_LOG_JSONL) {
+        return activity_event_to_json(event, buf, size);
+    }
+    size_t len = 0;
+    if (rlog_segment_time == 0 || !same_day(event->timestamp, rlog_segment_time)
+        || rlog_segment_records >= RLOG_SEGMENT_RECORDS) {
+        len = rlog_write_header(&rlog_context, event->timestamp, (uint8_t*)buf, size);
+        rlog_segment_time = event->timestamp;
+        rlog_segment_records = 0;
+    }
+    size_t n = rlog_write_event(&rlog_context, event, (uint8_t*)buf + len, size - len);
+    if (n == 0) {
+        rlog_segment_time = 0;
+        return 0;
+    }
+    rlog_segment_records++;
+    *header = len;
+    return len + n;
+}
+
+static void put_le(uint8_t* p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Entries for records just written at start; a failed write drops the
+// index for the rest of the day rather than leave a gap in it
+static void index_records(off_t start, const IndexEntry* entries, size_t count) {
+    static uint8_t buf[LOG_BATCH_RECORDS * INDEX_ENTRY_SIZE];
+    if (index_fd < 0) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        struct tm local_time;
+        localtime_r(&entries[i].timestamp, &local_time);
+        uint8_t* p = buf + i * INDEX_ENTRY_SIZE;
+        put_le(p, (uint64_t)(start + entries[i].offset), 4);
+        put_le(p + 4, entries[i].length, 2);
+        p[6] = (uint8_t)entries[i].event_type;
+        p[7] = (uint8_t)local_time.tm_hour;
+        put_le(p + 8, (uint64_t)(int64_t)entries[i].timestamp, 8);
+    }
+    if (!write_all(index_fd, buf, count * INDEX_ENTRY_SIZE)) {
+        char index_path[sizeof(log_file_path) + 4];
+        snprintf(index_path, sizeof(index_path), "%s.idx", log_file_path);
+        unlink(index_path);
+        close(index_fd);
+        index_fd = -1;
+    }
+}
+
+static bool write_records(const char* buf, size_t len, time_t timestamp,
+                          const IndexEntry* entries, size_t count) {
+    if (!open_log_for(timestamp)) {
+        rlog_segment_time = 0;
+        return false;
+    }
+    if (!write_all(log_fd, buf, len)) {
+        fprintf(stderr, "Failed to write activity log: %s\n", strerror(errno));
+        rlog_segment_time = 0;
+        return false;
+    }
+    // O_APPEND left the offset at the end of what was just written
+    off_t end = lseek(log_fd, 0, SEEK_CUR);
+    if (end >= (off_t)len) {
+        index_records(end - (off_t)len, entries, count);
+    }
+    return true;
+}
+
+// "activity_YYYY-MM-DD" and a log extension, then ".gz" if archived
+static bool parse_log_name(const char* name, char* day, const char** extension, bool* gz) {
+    if (strncmp(name, "activity_", 9) != 0 || strlen(name) < 19) {
+        return false;
+    }
+    const char* rest = name + 19;
+    for (size_t i = 0; i < sizeof(log_extensions) / sizeof(log_extensions[0]); i++) {
+        size_t n = strlen(log_extensions[i]);
+        if (strncmp(rest, log_extensions[i], n) == 0 && (rest[n] == '\0' || strcmp(rest + n, ".gz") == 0)) {
+            memcpy(day, name + 9, 10);
+            day[10] = '\0';
+            *extension = log_extensions[i];
+            *gz = rest[n] != '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+// An archived day keeps its index (offsets into the uncompressed log) only
+// if it still ends where the log does; one whose log is appended to an
+// existing archive would need its offsets moved, and is dropped
+static void check_index(const char* plain, bool keep) {
+    char index_path[sizeof(log_file_path) + 4];
+    snprintf(index_path, sizeof(index_path), "%s.idx", plain);
+    int fd = open(index_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat log_st;
+    off_t end = index_end(fd);
+    keep = keep && end > 0 && stat(plain, &log_st) == 0 && end == log_st.st_size;
+    close(fd);
+    if (!keep) {
+        unlink(index_path);
+    }
+}
+
+// Compresses one day's log next to it and removes the original. A new
+// archive is written under a temporary name and renamed into place; a day
+// that already has one (an event that came in late) gets another gzip
+// member appended, which gzip readers take as one stream.
+static bool archive_day(const char* day, const char* extension) {
+    char plain[512], archive[520], partial[528];
+    snprintf(plain, sizeof(plain), "%s/activity_%s%s", activity_dir, day, extension);
+    snprintf(archive, sizeof(archive), "%s.gz", plain);
+    snprintf(partial, sizeof(partial), "%s.tmp", archive);
+    bool append = access(archive, F_OK) == 0;
+    check_index(plain, !append);
+
+    int in = open(plain, O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+    gzFile out = gzopen(append ? archive : partial, append ? "ab" : "wb");
+    if (!out) {
+        close(in);
+        return false;
+    }
+    static char chunk[ARCHIVE_CHUNK];
+    ssize_t n;
+    bool ok = true;
+    while ((n = read(in, chunk, sizeof(chunk))) != 0) {
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 || gzwrite(out, chunk, (unsigned)n) != (int)n) {
+            ok = false;
             break;
-            
-        case EVENT_BREAK_RESCHEDULED:
-            fprintf(file, "\"delay_minutes\":%d,", 
-                   event->event_data.reschedule_event.delay_minutes);
+        }
+        // Shutdown abandons a fresh archive; an append is finished so the
+        // existing one stays readable
+        if (!append && __atomic_load_n(&archiver_stopping, __ATOMIC_RELAXED)) {
+            ok = false;
             break;
-            
-        case EVENT_COMMAND_RECEIVED:
-            // Escape quotes in command text
-            fprintf(file, "\"command_text\":\"");
-            for (int i = 0; event->event_data.command_event.command_text[i]; i++) {
-                char c = event->event_data.command_event.command_text[i];
-                if (c == '"' || c == '\\') {
-                    fprintf(file, "\\%c", c);
-                } else {
-                    fprintf(file, "%c", c);
+        }
+    }
+    close(in);
+    ok = gzclose(out) == Z_OK && ok;
+    if (!append) {
+        ok = ok && rename(partial, archive) == 0;
+        if (!ok) {
+            unlink(partial);
+        }
+    }
+    if (!ok) {
+        if (!__atomic_load_n(&archiver_stopping, __ATOMIC_RELAXED)) {
+            fprintf(stderr, "Failed to archive activity log %s\n", plain);
+        }
+        return false;
+    }
+    unlink(plain);
+    return true;
+}
+
+// Plain logs of days before today; the open file is never among them, as
+// the logger has moved on by the time this runs
+static void archive_closed_days(void) {
+    char today[sizeof(log_day)], day[sizeof(log_day)];
+    day_of(time(NULL) - ARCHIVE_GRACE_SECONDS, today);
+    DIR* dir = opendir(activity_dir);
+    if (!dir) {
+        return;
+    }
+    struct dirent* entry;
+    const char* extension;
+    bool gz;
+    while ((entry = readdir(dir)) && !__atomic_load_n(&archiver_stopping, __ATOMIC_RELAXED)) {
+        if (parse_log_name(entry->d_name, day, &extension, &gz) && !gz && strcmp(day, today) < 0) {
+            archive_day(day, extension);
+        }
+    }
+    closedir(dir);
+}
+
+// Events of one day's log, plain or gzipped, counted into the rollup;
+// reading stops at a torn or damaged tail as recovery would cut it
+static void rollup_log(const char* path, const char* extension) {
+    size_t len;
+    unsigned char* data = rlog_load_file(path, &len);
+    if (!data) {
+        return;
+    }
+    ActivityEvent event;
+    if (strcmp(extension, ".rlog") == 0) {
+        RlogReader reader;
+        rlog_reader_init(&reader, data, len);
+        while (rlog_read_event(&reader, &event) == RLOG_EVENT) {
+            rollup_add(&rollup, &event);
+        }
+    } else {
+        char line[RECORD_MAX + 1];
+        const unsigned char* start = data;
+        const unsigned char* newline;
+        while ((newline = memchr(start, '\n', len - (size_t)(start - data))) != NULL) {
+            size_t n = (size_t)(newline - start) + 1;
+            if (!activity_json_line_ok((const char*)start, n) || n > sizeof(line)) {
+                break;
+            }
+            memcpy(line, start, n - 1);
+            line[n - 1] = '\0';
+            if (activity_event_from_json(line, &event)) {
+                rollup_add(&rollup, &event);
+            }
+            start = newline + 1;
+        }
+    }
+    free(data);
+}
+
+// The days a rollup holds are today and the ROLLUP_DAYS - 1 before it;
+// their logs, plain or archived, in either format, are counted afresh
+static void rebuild_rollup(time_t now) {
+    char first[sizeof(log_day)], today[sizeof(log_day)], day[sizeof(log_day)];
+    struct tm local_time;
+    localtime_r(&now, &local_time);
+    local_time.tm_mday -= ROLLUP_DAYS - 1;
+    local_time.tm_hour = 12;                // clear of DST changes
+    local_time.tm_isdst = -1;
+    day_of(mktime(&local_time), first);
+    day_of(now, today);
+
+    bool damaged = access(rollup_path, F_OK) == 0;
+    memset(&rollup, 0, sizeof(rollup));
+    DIR* dir = opendir(activity_dir);
+    if (!dir) {
+        return;
+    }
+    struct dirent* entry;
+    const char* extension;
+    bool gz;
+    int files = 0;
+    while ((entry = readdir(dir))) {
+        if (parse_log_name(entry->d_name, day, &extension, &gz)
+            && strcmp(day, first) >= 0 && strcmp(day, today) <= 0) {
+            char path[sizeof(activity_dir) + sizeof(entry->d_name)];
+            snprintf(path, sizeof(path), "%s/%s", activity_dir, entry->d_name);
+            rollup_log(path, extension);
+            files++;
+        }
+    }
+    closedir(dir);
+    if (damaged || files > 0) {
+        if (damaged) {
+            fprintf(stderr, "Activity rollup %s was damaged; counted again from %d logs\n", rollup_path, files);
+        }
+        rollup_save(&rollup, rollup_path, now);
+    }
+}
+
+static void* archiver_main(void* arg) {
+    (void)arg;
+    for (;;) {
+        archive_closed_days();
+        pthread_mutex_lock(&archive_lock);
+        if (!archiver_again || archiver_stopping) {
+            archiver_running = false;
+            pthread_mutex_unlock(&archive_lock);
+            return NULL;
+        }
+        archiver_again = false;
+        pthread_mutex_unlock(&archive_lock);
+    }
+}
+
+static void start_archiver(void) {
+    pthread_mutex_lock(&archive_lock);
+    if (archiver_running) {
+        archiver_again = true;
+    } else if (!archiver_stopping) {
+        if (archiver_joinable) {
+            pthread_join(archiver_thread, NULL);    // it has already returned
+        }
+        archiver_running = pthread_create(&archiver_thread, NULL, archiver_main, NULL) == 0;
+        archiver_joinable = archiver_running;
+    }
+    pthread_mutex_unlock(&archive_lock);
+}
+
+static void stop_archiver(void) {
+    pthread_mutex_lock(&archive_lock);
+    __atomic_store_n(&archiver_stopping, 1, __ATOMIC_RELAXED);
+    bool joinable = archiver_joinable;
+    archiver_joinable = false;
+    pthread_mutex_unlock(&archive_lock);
+    if (joinable) {
+        pthread_join(archiver_thread, NULL);
+    }
+}
+
+// When the logger next closes the previous day's file and starts the
+// archiver: a little after local midnight
+static time_t next_rollover(time_t now) {
+    struct tm local_time;
+    localtime_r(&now, &local_time);
+    local_time.tm_mday++;
+    local_time.tm_hour = local_time.tm_min = local_time.tm_sec = 0;
+    local_time.tm_isdst = -1;
+    return mktime(&local_time) + ARCHIVE_GRACE_SECONDS;
+}
+
+static void roll_over(void) {
+    char today[sizeof(log_day)];
+    day_of(time(NULL), today);
+    if (log_fd >= 0 && strcmp(log_day, today) != 0) {
+        close_log();
+    }
+    start_archiver();
+}
+
+static bool ring_push(const ActivityEvent* event) {
+    unsigned long position = __atomic_load_n(&enqueue_position, __ATOMIC_RELAXED);
+    for (;;) {
+        LogSlot* slot = &log_ring[position & (LOG_RING_SIZE - 1)];
+        unsigned long sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        long diff = (long)(sequence - position);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&enqueue_position, &position, position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot->event = *event;
+                __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;   // the logger is a whole ring behind
+        } else {
+            position = __atomic_load_n(&enqueue_position, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static bool ring_pop(ActivityEvent* event) {
+    LogSlot* slot = &log_ring[dequeue_position & (LOG_RING_SIZE - 1)];
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != dequeue_position + 1) {
+        return false;
+    }
+    *event = slot->event;
+    __atomic_store_n(&slot->sequence, dequeue_position + LOG_RING_SIZE, __ATOMIC_RELEASE);
+    dequeue_position++;
+    return true;
+}
+
+static void count_rollup(const ActivityEvent* event) {
+    if (rollup_unsaved++ == 0) {
+        rollup_unsaved_since = time(NULL);
+    }
+    rollup_add(&rollup, event);
+}
+
+// Save the rollup if it is due, or at all with force
+static void save_rollup(bool force) {
+    time_t now = time(NULL);
+    if (rollup_unsaved > 0 && (force || rollup_unsaved >= ROLLUP_SAVE_EVENTS
+                               || now - rollup_unsaved_since >= ROLLUP_SAVE_SECONDS
+                               || now < rollup_unsaved_since)) {
+        rollup_save(&rollup, rollup_path, now);
+        rollup_unsaved = 0;
+    }
+}
+
+static void wake_logger(void) {
+    uint64_t one = 1;
+    if (write(logger_wake_fd, &one, sizeof(one)) < 0) {
+        // EAGAIN: the counter is already non-zero, a wakeup is pending
+    }
+}
+
+static void* logger_main(void* arg) {
+    (void)arg;
+    static char batch[LOG_BATCH_BYTES];
+    static IndexEntry entries[LOG_BATCH_RECORDS];
+    ActivityEvent event;
+    time_t rollover_at = next_rollover(time(NULL));
+
+    for (;;) {
+        // Whole records of one day per write
+        size_t len = 0, count = 0;
+        time_t batch_time = 0;
+        int breaks = 0, minutes = 0;    // of the batch's last event
+        while (ring_pop(&event)) {
+            if (len > 0 && (len + RECORD_MAX > sizeof(batch) || count == LOG_BATCH_RECORDS
+                            || !same_day(event.timestamp, batch_time))) {
+                if (write_records(batch, len, batch_time, entries, count)) {
+                    save_counters(batch_time, breaks, minutes);
                 }
+                len = count = 0;
             }
-            fprintf(file, "\",");
-            break;
-            
-        default:
-            break;
+            size_t header;
+            size_t n = encode_event(&event, batch + len, RECORD_MAX, &header);
+            if (n == 0) {
+                fprintf(stderr, "Activity event too large to log\n");
+            } else {
+                if (len == 0) {
+                    batch_time = event.timestamp;
+                }
+                entries[count++] = (IndexEntry){ len + header, n - header, event.event_type, event.timestamp };
+                breaks = event.system_state.total_breaks_today;
+                minutes = event.system_state.total_work_minutes_today;
+                count_rollup(&event);
+                activity_db_add(&event);
+            }
+            len += n;
+            __atomic_add_fetch(&events_written, 1, __ATOMIC_RELAXED);
+        }
+        if (len > 0 && write_records(batch, len, batch_time, entries, count)) {
+            save_counters(batch_time, breaks, minutes);
+        }
+        save_rollup(false);
+        activity_db_commit();
+
+        __atomic_store_n(&flushed_position, dequeue_position, __ATOMIC_SEQ_CST);
+        pthread_mutex_lock(&flush_lock);
+        pthread_cond_broadcast(&flush_done);
+        pthread_mutex_unlock(&flush_lock);
+
+        // Announce the nap, then look once more: a producer either sees the
+        // flag and wakes us, or pushed before we looked
+        __atomic_store_n(&logger_sleeping, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&log_ring[dequeue_position & (LOG_RING_SIZE - 1)].sequence, __ATOMIC_SEQ_CST)
+            == dequeue_position + 1) {
+            __atomic_store_n(&logger_sleeping, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+        if (__atomic_load_n(&logger_stopping, __ATOMIC_SEQ_CST)) {
+            save_rollup(true);
+            return NULL;
+        }
+        uint64_t wakeups;
+        struct pollfd wait = { .fd = logger_wake_fd, .events = POLLIN };
+        time_t now = time(NULL);
+        time_t wait_s = rollover_at > now ? rollover_at - now : 0;
+        if (rollup_unsaved > 0) {
+            time_t save_at = rollup_unsaved_since + ROLLUP_SAVE_SECONDS;
+            wait_s = save_at > now ? (save_at - now < wait_s ? save_at - now : wait_s) : 0;
+        }
+        poll(&wait, 1, (int)(wait_s < 3600 ? wait_s : 3600) * 1000);
+        if (read(logger_wake_fd, &wakeups, sizeof(wakeups)) < 0) {
+            // EAGAIN after a timeout or a spurious wakeup
+        }
+        __atomic_store_n(&logger_sleeping, 0, __ATOMIC_SEQ_CST);
+
+        // Checked on every wakeup and at least hourly: poll's clock stops
+        // during suspend, and the wall clock may be set back
+        now = time(NULL);
+        if (now >= rollover_at || rollover_at - now > 2 * 86400) {
+            roll_over();
+            rollover_at = next_rollover(now);
+        }
     }
-    
-    // Remove trailing comma if any event data was written
-    long pos = ftell(file);
-    if (pos > 0) {
-        fseek(file, -1, SEEK_CUR);
-        char last_char;
-        fread(&last_char, 1, 1, file);
-        if (last_char == ',') {
-            fseek(file, -1, SEEK_CUR);
+}
+
+void log_activity_event(ActivityEvent* event) {
+    if (event->group_id == 0) {
+        event->group_id = current_group;
+    }
+
+    if (logger_running) {
+        if (!ring_push(event)) {
+            __atomic_add_fetch(&events_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        if (__atomic_exchange_n(&logger_sleeping, 0, __ATOMIC_SEQ_CST)) {
+            wake_logger();
+        }
+        return;
+    }
+
+    char record[RECORD_MAX];
+    size_t header;
+    size_t len = encode_event(event, record, sizeof(record), &header);
+    if (len == 0) {
+        fprintf(stderr, "Activity event too large to log\n");
+        return;
+    }
+    IndexEntry entry = { header, len - header, event->event_type, event->timestamp };
+    if (write_records(record, len, event->timestamp, &entry, 1)) {
+        save_counters(event->timestamp, event->system_state.total_breaks_today,
+                      event->system_state.total_work_minutes_today);
+    }
+    count_rollup(event);
+    save_rollup(true);
+    activity_db_add(event);
+    activity_db_commit();
+    __atomic_add_fetch(&events_written, 1, __ATOMIC_RELAXED);
+}
+
+void activity_log_flush(void) {
+    if (!logger_running) {
+        return;
+    }
+    unsigned long target = __atomic_load_n(&enqueue_position, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&flush_lock);
+    while ((long)(__atomic_load_n(&flushed_position, __ATOMIC_SEQ_CST) - target) < 0) {
+        wake_logger();
+        pthread_cond_wait(&flush_done, &flush_lock);
+    }
+    pthread_mutex_unlock(&flush_lock);
+}
+
+void activity_log_get_stats(ActivityLogStats* out) {
+    out->written = __atomic_load_n(&events_written, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&events_dropped, __ATOMIC_RELAXED);
+    out->plain_days = out->archived_days = 0;
+    out->plain_bytes = out->archived_bytes = 0;
+    out->db_enabled = db_enabled;
+    out->db_open = activity_db_is_open();
+    out->db_dropped = activity_db_dropped();
+
+    DIR* dir = opendir(activity_dir);
+    if (!dir) {
+        return;
+    }
+    struct dirent* entry;
+    char day[sizeof(log_day)];
+    const char* extension;
+    bool gz;
+    while ((entry = readdir(dir))) {
+        struct stat st;
+        if (!parse_log_name(entry->d_name, day, &extension, &gz)
+            || fstatat(dirfd(dir), entry->d_name, &st, 0) < 0) {
+            continue;
+        }
+        if (gz) {
+            out->archived_days++;
+            out->archived_bytes += st.st_size;
         } else {
-            fseek(file, 0, SEEK_END);
+            out->plain_days++;
+            out->plain_bytes += st.st_size;
         }
     }
-    
-    fprintf(file, "},");
-    
-    // System state
-    fprintf(file, "\"system_state\":{");
-    fprintf(file, "\"is_paused\":%s,", 
-           event->system_state.is_paused ? "true" : "false");
-    fprintf(file, "\"in_deep_work_session\":%s,", 
-           event->system_state.in_deep_work_session ? "true" : "false");
-    fprintf(file, "\"next_break_in_minutes\":%d,", 
-           event->system_state.next_break_in_minutes);
-    fprintf(file, "\"total_breaks_today\":%d,", 
-           event->system_state.total_breaks_today);
-    fprintf(file, "\"total_work_minutes_today\":%d", 
-           event->system_state.total_work_minutes_today);
-    fprintf(file, "}");
-    
-    fprintf(file, "}\n");
-    fclose(file);
+    closedir(dir);
 }
 
 // Convenience functions for logging specific events
@@ -214,6 +1008,7 @@ void log_break_completed(BreakType break_type, int duration_seconds, bool user_d
     event.event_data.break_event.duration_seconds = duration_seconds;
     event.event_data.break_event.user_dismissed = user_dismissed;
     
+    roll_daily_counters(event.timestamp);
     daily_break_count++;
     get_current_system_state(&event);
     log_activity_event(&event);
@@ -237,6 +1032,7 @@ void log_session_ended(SessionType session_type, int actual_duration_minutes) {
     event.event_data.session_event.session_type = session_type;
     event.event_data.session_event.duration_minutes = actual_duration_minutes;
     
+    roll_daily_counters(event.timestamp);
     daily_work_minutes += actual_duration_minutes;
     get_current_system_state(&event);
     log_activity_event(&event);
@@ -262,12 +1058,45 @@ void log_break_rescheduled(int delay_minutes) {
     log_activity_event(&event);
 }
 
-void log_command_received(const char* command_text) {
+void log_command_received(const char* command_text, const char* intent,
+                          const char* intent_source, float confidence) {
     ActivityEvent event = {0};
     event.timestamp = time(NULL);
     event.event_type = EVENT_COMMAND_RECEIVED;
     strncpy(event.event_data.command_event.command_text, command_text, 
             sizeof(event.event_data.command_event.command_text) - 1);
+    strncpy(event.event_data.command_event.intent, intent,
+            sizeof(event.event_data.command_event.intent) - 1);
+    strncpy(event.event_data.command_event.intent_source, intent_source,
+            sizeof(event.event_data.command_event.intent_source) - 1);
+    event.event_data.command_event.confidence = confidence;
+    
+    get_current_system_state(&event);
+    log_activity_event(&event);
+}
+
+void log_command_corrected(const char* typo, const char* correction, int distance) {
+    ActivityEvent event = {0};
+    event.timestamp = time(NULL);
+    event.event_type = EVENT_COMMAND_CORRECTED;
+    strncpy(event.event_data.correction_event.typo, typo,
+            sizeof(event.event_data.correction_event.typo) - 1);
+    strncpy(event.event_data.correction_event.correction, correction,
+            sizeof(event.event_data.correction_event.correction) - 1);
+    event.event_data.correction_event.distance = distance;
+    
+    get_current_system_state(&event);
+    log_activity_event(&event);
+}
+
+void log_popup_shown(const char* kind, int latency_ms, bool mapped) {
+    ActivityEvent event = {0};
+    event.timestamp = time(NULL);
+    event.event_type = EVENT_POPUP_SHOWN;
+    strncpy(event.event_data.popup_event.kind, kind,
+            sizeof(event.event_data.popup_event.kind) - 1);
+    event.event_data.popup_event.latency_ms = latency_ms;
+    event.event_data.popup_event.mapped = mapped;
     
     get_current_system_state(&event);
     log_activity_event(&event);
@@ -291,10 +1120,37 @@ void log_app_stopped(void) {
     log_activity_event(&event);
 }
 
+unsigned int log_group_begin(void) {
+    // Seeded from the clock so ids stay unique across restarts
+    unsigned int id = (unsigned int)time(NULL);
+    if (id <= last_group) {
+        id = last_group + 1;
+    }
+    last_group = id;
+    current_group = id;
+    return id;
+}
+
+void log_group_end(void) {
+    current_group = 0;
+}
+
 void cleanup_activity_logging(void) {
     log_app_stopped();
-    if (log_file) {
-        fclose(log_file);
-        log_file = NULL;
+    if (logger_running) {
+        // The thread drains the ring before it returns
+        __atomic_store_n(&logger_stopping, 1, __ATOMIC_SEQ_CST);
+        wake_logger();
+        pthread_join(logger_thread, NULL);
+        logger_running = false;
+        close(logger_wake_fd);
+        logger_wake_fd = -1;
+    }
+    stop_archiver();
+    close_log();
+    activity_db_close();
+    if (counters_fd >= 0) {
+        close(counters_fd);
+        counters_fd = -1;
     }
 }
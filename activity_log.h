@@ -2,6 +2,7 @@
 #define ACTIVITY_LOG_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <time.h>
 
 // Event types for activity logging
@@ -14,7 +15,9 @@ typedef enum {
     EVENT_BREAK_RESCHEDULED,
     EVENT_COMMAND_RECEIVED,
     EVENT_APP_STARTED,
-    EVENT_APP_STOPPED
+    EVENT_APP_STOPPED,
+    EVENT_COMMAND_CORRECTED,
+    EVENT_POPUP_SHOWN
 } ActivityEventType;
 
 // Break types
@@ -33,6 +36,7 @@ typedef enum {
 typedef struct {
     time_t timestamp;
     ActivityEventType event_type;
+    unsigned int group_id;  // shared by events from one command transaction, 0 if none
     
     // Event-specific data
     union {
@@ -57,7 +61,22 @@ typedef struct {
         
         struct {
             char command_text[256];
+            char intent[16];        // intent picked by the NL parser
+            char intent_source[16]; // "classifier", "rules" or "none"
+            float confidence;
         } command_event;
+        
+        struct {
+            char typo[32];
+            char correction[32];
+            int distance;
+        } correction_event;
+        
+        struct {
+            char kind[16];          // "status", "confirmation" or "routine"
+            int latency_ms;         // request to first draw
+            bool mapped;
+        } popup_event;
     } event_data;
     
     // System state at time of event
@@ -70,7 +89,17 @@ typedef struct {
     } system_state;
 } ActivityEvent;
 
+// On-disk format of the daily log: JSON lines, or the compact binary
+// records of rlog.h, which `restly-log cat --json` turns back into JSON lines
+typedef enum {
+    ACTIVITY_LOG_JSONL,
+    ACTIVITY_LOG_BINARY
+} ActivityLogFormat;
+
 // Function declarations
+bool activity_log_format_from_name(const char* name, ActivityLogFormat* format);
+void activity_log_set_format(ActivityLogFormat format);     // before init_activity_logging
+void activity_log_set_db(bool enabled);                     // the same; see activity_db.h
 void init_activity_logging(void);
 void log_activity_event(ActivityEvent* event);
 void log_break_shown(BreakType break_type, int duration_seconds);
@@ -79,11 +108,52 @@ void log_session_started(SessionType session_type, int duration_minutes);
 void log_session_ended(SessionType session_type, int actual_duration_minutes);
 void log_pause_toggled(bool is_paused);
 void log_break_rescheduled(int delay_minutes);
-void log_command_received(const char* command_text);
+void log_command_received(const char* command_text, const char* intent,
+                          const char* intent_source, float confidence);
+void log_command_corrected(const char* typo, const char* correction, int distance);
+void log_popup_shown(const char* kind, int latency_ms, bool mapped);
 void log_app_started(void);
 void log_app_stopped(void);
 void cleanup_activity_logging(void);
 
+// Logging never blocks: events are queued for a logger thread, and dropped
+// (and counted) if it has fallen a whole queue behind. Days before today
+// are gzipped in the background; the rest describes the files on disk.
+typedef struct {
+    unsigned long written;
+    unsigned long dropped;
+    unsigned int plain_days;            // activity_DATE.jsonl or .rlog
+    unsigned int archived_days;         // the same with .gz
+    unsigned long long plain_bytes;
+    unsigned long long archived_bytes;
+    bool db_enabled;                    // --activity-db
+    bool db_open;                       // false after an error until it is reopened
+    unsigned long db_dropped;           // events the database did not keep
+} ActivityLogStats;
+
+void activity_log_get_stats(ActivityLogStats* stats);
+// Wait until everything logged so far is written; cleanup_activity_logging does this too
+void activity_log_flush(void);
+
+// Events logged between begin and end share a "group" id
+unsigned int log_group_begin(void);
+void log_group_end(void);
+
+// Serialize event as one JSON line into buf; returns its length, newline
+// included, or 0 if it does not fit. The last field, "crc32c", is the
+// CRC32C (8 hex digits) of the line up to the comma before it.
+size_t activity_event_to_json(const ActivityEvent* event, char* buf, size_t size);
+
+// True if line (len bytes, a trailing newline allowed) is a whole JSON line
+// whose crc32c matches; lines written before the field existed only need to
+// be one closed object
+bool activity_json_line_ok(const char* line, size_t len);
+
+// Read back a NUL-terminated line written by activity_event_to_json: its
+// timestamp, type, group, break or session type and the day's totals, what
+// the rollup counts; other fields are left zero. False if it is not one.
+bool activity_event_from_json(const char* line, ActivityEvent* event);
+
 // Utility functions
 const char* get_activity_log_path(void);
 void get_current_system_state(ActivityEvent* event);
@@ -0,0 +1,334 @@
+// SQLite activity store against JSONL day files: write cost and query latency.
+// Usage: bench_db [days] [batch]
+//
+// Writes a synthetic year (by default) of workdays (bench_events.h) into a
+// scratch directory both ways, batch events at a time; 1, the default, is
+// what the logger mostly sees, as events come minutes apart. JSONL goes to
+// one O_APPEND file per day with a write() per batch, as the logger writes
+// it; SQLite through activity_db.c, a transaction per batch. Then times the
+// summary's two queries on each: the hourly activity of a day (every
+// seventh day in turn) and break compliance per day over all of them. On
+// JSONL that is reading and scanning the day files with a line scanner (no
+// JSON parser, so a lower bound for the Python analyzer), on SQLite an
+// indexed SELECT. Checks both give the same counts. Prints one JSON object
+// per store.
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sqlite3.h>
+#include "activity_log.h"
+#include "activity_db.h"
+#include "bench_events.h"
+
+#define MAX_DAYS 4000
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void day_of(time_t timestamp, char* day) {
+    struct tm local_time;
+    localtime_r(&timestamp, &local_time);
+    strftime(day, 16, "%Y-%m-%d", &local_time);
+}
+
+static time_t local_midnight(time_t timestamp, int days_later) {
+    struct tm local_time;
+    localtime_r(&timestamp, &local_time);
+    local_time.tm_mday += days_later;
+    local_time.tm_hour = local_time.tm_min = local_time.tm_sec = 0;
+    local_time.tm_isdst = -1;
+    return mktime(&local_time);
+}
+
+static off_t file_size(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : 0;
+}
+
+// Writing
+
+static const char* dir;
+static char days_seen[MAX_DAYS][16];
+static int day_count = 0;
+
+static void jsonl_path(const char* day, char* path, size_t size) {
+    if (snprintf(path, size, "%s/activity_%s.jsonl", dir, day) >= (int)size) {
+        path[0] = '\0';
+    }
+}
+
+static void write_batch(int fd, const char* buf, size_t len) {
+    if (fd >= 0 && write(fd, buf, len) != (ssize_t)len) {
+        perror("write");
+        exit(1);
+    }
+}
+
+static double write_jsonl(const ActivityEvent* events, int count, int batch, off_t* bytes) {
+    static char buf[64 * 2048];
+    char day[16] = "", path[512];
+    int fd = -1;
+    size_t len = 0;
+    int in_batch = 0;
+    double started = now_s();
+    for (int i = 0; i < count; i++) {
+        char event_day[16];
+        day_of(events[i].timestamp, event_day);
+        if (strcmp(event_day, day) != 0) {
+            write_batch(fd, buf, len);
+            len = in_batch = 0;
+            if (fd >= 0) {
+                close(fd);
+            }
+            memcpy(day, event_day, sizeof(day));
+            jsonl_path(day, path, sizeof(path));
+            fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (day_count < MAX_DAYS) {
+                memcpy(days_seen[day_count++], day, sizeof(day));
+            }
+        }
+        len += activity_event_to_json(&events[i], buf + len, sizeof(buf) - len);
+        if (++in_batch == batch || len + 2048 > sizeof(buf)) {
+            write_batch(fd, buf, len);
+            len = in_batch = 0;
+        }
+    }
+    write_batch(fd, buf, len);
+    if (fd >= 0) {
+        close(fd);
+    }
+    double seconds = now_s() - started;
+
+    *bytes = 0;
+    for (int i = 0; i < day_count; i++) {
+        jsonl_path(days_seen[i], path, sizeof(path));
+        *bytes += file_size(path);
+    }
+    return seconds;
+}
+
+static double write_db(const char* path, const ActivityEvent* events, int count, int batch) {
+    double started = now_s();
+    if (!activity_db_open(path)) {
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        activity_db_add(&events[i]);
+        if ((i + 1) % batch == 0) {
+            activity_db_commit();
+        }
+    }
+    activity_db_commit();
+    double seconds = now_s() - started;
+    activity_db_close();
+    return seconds;
+}
+
+// Queries, JSONL: the day files scanned line by line
+
+static char* read_file(const char* path, size_t* len) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = malloc(size + 1);
+    *len = data ? fread(data, 1, size, file) : 0;
+    if (data) {
+        data[*len] = '\0';
+    }
+    fclose(file);
+    return data;
+}
+
+static time_t scan_timestamp(const char* line) {
+    const char* p = strstr(line, "\"timestamp\":\"");
+    struct tm utc = {0};
+    if (!p || sscanf(p + 13, "%4d-%2d-%2dT%2d:%2d:%2d", &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+                     &utc.tm_hour, &utc.tm_min, &utc.tm_sec) != 6) {
+        return 0;
+    }
+    utc.tm_year -= 1900;
+    utc.tm_mon -= 1;
+    return timegm(&utc);
+}
+
+static const char* scan_type(const char* line) {
+    const char* p = strstr(line, "\"event_type\":\"");
+    return p ? p + 14 : "";
+}
+
+static void jsonl_hourly(const char* day, long hours[24]) {
+    char path[512];
+    size_t len;
+    jsonl_path(day, path, sizeof(path));
+    char* data = read_file(path, &len);
+    memset(hours, 0, 24 * sizeof(long));
+    for (char* line = data; line && *line; ) {
+        char* end = strchr(line, '\n');
+        if (end) {
+            *end = '\0';
+        }
+        time_t timestamp = scan_timestamp(line);
+        struct tm local_time;
+        localtime_r(&timestamp, &local_time);
+        hours[local_time.tm_hour]++;
+        line = end ? end + 1 : line + strlen(line);
+    }
+    free(data);
+}
+
+static void jsonl_compliance(long* shown, long* completed) {
+    *shown = *completed = 0;
+    for (int i = 0; i < day_count; i++) {
+        char path[512];
+        size_t len;
+        jsonl_path(days_seen[i], path, sizeof(path));
+        char* data = read_file(path, &len);
+        for (char* line = data; line && *line; ) {
+            char* end = strchr(line, '\n');
+            const char* type = scan_type(line);
+            if (strncmp(type, "break_shown\"", 12) == 0) {
+                (*shown)++;
+            } else if (strncmp(type, "break_completed\"", 16) == 0) {
+                (*completed)++;
+            }
+            line = end ? end + 1 : line + strlen(line);
+        }
+        free(data);
+    }
+}
+
+// Queries, SQLite
+
+static void db_hourly(sqlite3_stmt* query, time_t start, long hours[24]) {
+    memset(hours, 0, 24 * sizeof(long));
+    sqlite3_bind_int64(query, 1, start);
+    sqlite3_bind_int64(query, 2, local_midnight(start, 1));
+    while (sqlite3_step(query) == SQLITE_ROW) {
+        hours[sqlite3_column_int(query, 0) % 24] = sqlite3_column_int64(query, 1);
+    }
+    sqlite3_reset(query);
+}
+
+static void db_compliance(sqlite3_stmt* query, long* shown, long* completed) {
+    *shown = *completed = 0;
+    while (sqlite3_step(query) == SQLITE_ROW) {
+        *completed += sqlite3_column_int64(query, 1);
+        *shown += sqlite3_column_int64(query, 2);
+    }
+    sqlite3_reset(query);
+}
+
+static int remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+int main(int argc, char* argv[]) {
+    int days = argc > 1 ? atoi(argv[1]) : 365;
+    int batch = argc > 2 ? atoi(argv[2]) : 1;
+    if (days < 1) days = 1;
+    if (days > MAX_DAYS) days = MAX_DAYS;
+    if (batch < 1) batch = 1;
+
+    ActivityEvent* events = malloc(sizeof(ActivityEvent) * BENCH_MAX_EVENTS);
+    if (!events) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    int count = bench_generate_days(events, days);
+
+    char scratch[] = "/tmp/restly-bench-db-XXXXXX";
+    if (!mkdtemp(scratch)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    dir = scratch;
+    char db_path[sizeof(scratch) + 16];
+    snprintf(db_path, sizeof(db_path), "%s/activity.db", scratch);
+
+    off_t jsonl_bytes;
+    double jsonl_write_s = write_jsonl(events, count, batch, &jsonl_bytes);
+    double db_write_s = write_db(db_path, events, count, batch);
+
+    sqlite3* db;
+    sqlite3_stmt *hourly, *compliance;
+    if (sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(db, "SELECT hour, count(*) FROM events"
+                                  " WHERE timestamp >= ?1 AND timestamp < ?2 GROUP BY hour",
+                              -1, &hourly, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(db, "SELECT day, sum(event_type = 'break_completed'),"
+                                  " sum(event_type = 'break_shown') FROM events"
+                                  " WHERE event_type IN ('break_shown', 'break_completed') GROUP BY day",
+                              -1, &compliance, NULL) != SQLITE_OK) {
+        fprintf(stderr, "sqlite: %s\n", sqlite3_errmsg(db));
+        return 1;
+    }
+
+    // Every seventh day, each store in turn
+    int queries = 0;
+    bool same = true;
+    double jsonl_hourly_s = 0, db_hourly_s = 0;
+    for (int i = 0; i < day_count; i += 7, queries++) {
+        long from_jsonl[24], from_db[24];
+        struct tm noon = {0};
+        sscanf(days_seen[i], "%d-%d-%d", &noon.tm_year, &noon.tm_mon, &noon.tm_mday);
+        noon.tm_year -= 1900;
+        noon.tm_mon -= 1;
+        noon.tm_hour = 12;
+        noon.tm_isdst = -1;
+        time_t midnight = local_midnight(mktime(&noon), 0);
+
+        double started = now_s();
+        jsonl_hourly(days_seen[i], from_jsonl);
+        jsonl_hourly_s += now_s() - started;
+        started = now_s();
+        db_hourly(hourly, midnight, from_db);
+        db_hourly_s += now_s() - started;
+        same = same && memcmp(from_jsonl, from_db, sizeof(from_db)) == 0;
+    }
+
+    long jsonl_shown, jsonl_completed, db_shown, db_completed;
+    double started = now_s();
+    jsonl_compliance(&jsonl_shown, &jsonl_completed);
+    double jsonl_compliance_s = now_s() - started;
+    started = now_s();
+    db_compliance(compliance, &db_shown, &db_completed);
+    double db_compliance_s = now_s() - started;
+    same = same && jsonl_shown == db_shown && jsonl_completed == db_completed;
+
+    sqlite3_finalize(hourly);
+    sqlite3_finalize(compliance);
+    sqlite3_close(db);
+    off_t db_bytes = file_size(db_path);
+
+    printf("{\"store\":\"jsonl\",\"events\":%d,\"batch\":%d,\"bytes\":%lld,\"write_s\":%.3f,"
+           "\"write_us_per_event\":%.2f,\"hourly_query_ms\":%.3f,\"compliance_query_ms\":%.2f}\n",
+           count, batch, (long long)jsonl_bytes, jsonl_write_s, jsonl_write_s * 1e6 / count,
+           jsonl_hourly_s * 1e3 / queries, jsonl_compliance_s * 1e3);
+    printf("{\"store\":\"sqlite\",\"events\":%d,\"batch\":%d,\"bytes\":%lld,\"write_s\":%.3f,"
+           "\"write_us_per_event\":%.2f,\"hourly_query_ms\":%.3f,\"compliance_query_ms\":%.2f,"
+           "\"same_results\":%s}\n",
+           count, batch, (long long)db_bytes, db_write_s, db_write_s * 1e6 / count,
+           db_hourly_s * 1e3 / queries, db_compliance_s * 1e3, same ? "true" : "false");
+
+    free(events);
+    nftw(scratch, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+    return same ? 0 : 1;
+}
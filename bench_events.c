@@ -0,0 +1,117 @@
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "bench_events.h"
+
+static const char* commands[] = {
+    "remind me to stretch in 25 minutes", "pause for an hour", "start deep work for 90 minutes",
+    "break in 10 minutes", "resume", "what's next", "remind me to drink water at 3pm",
+};
+
+static unsigned int seed = 12345;
+
+static unsigned int next_random(void) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+// Synthetic events
+
+typedef struct {
+    ActivityEvent* events;
+    int count;
+    int breaks;
+    time_t work_start;
+    bool paused;
+    bool deep_work;
+    time_t next_break;
+} Year;
+
+static ActivityEvent* add(Year* y, time_t t, ActivityEventType type) {
+    ActivityEvent* e = &y->events[y->count++];
+    memset(e, 0, sizeof(*e));
+    e->timestamp = t;
+    e->event_type = type;
+    e->system_state.is_paused = y->paused;
+    e->system_state.in_deep_work_session = y->deep_work;
+    e->system_state.next_break_in_minutes = (int)((y->next_break - t) / 60);
+    e->system_state.total_breaks_today = y->breaks;
+    e->system_state.total_work_minutes_today = (int)((t - y->work_start) / 60);
+    return e;
+}
+
+static void generate_day(Year* y, time_t morning) {
+    time_t t = morning + (time_t)(next_random() % 1800);
+    time_t evening = morning + 8 * 3600 + (time_t)(next_random() % 3600);
+    y->breaks = 0;
+    y->work_start = t;
+    y->paused = y->deep_work = false;
+    y->next_break = t + 20 * 60;
+    add(y, t, EVENT_APP_STARTED);
+
+    while (t < evening && y->count < BENCH_MAX_EVENTS - 16) {
+        time_t step = 60 + (time_t)(next_random() % 300);
+        t += step;
+        unsigned int roll = next_random() % 100;
+        if (t >= y->next_break) {
+            t = y->next_break;
+            ActivityEvent* e = add(y, t, EVENT_BREAK_SHOWN);
+            e->event_data.break_event.duration_seconds = 20;
+            e = add(y, t, EVENT_POPUP_SHOWN);
+            strcpy(e->event_data.popup_event.kind, "routine");
+            e->event_data.popup_event.latency_ms = 20 + next_random() % 40;
+            e->event_data.popup_event.mapped = true;
+            y->breaks++;
+            y->next_break = t + 20 * 60 + 20;
+            e = add(y, t + 20, EVENT_BREAK_COMPLETED);
+            e->event_data.break_event.duration_seconds = 20;
+            e->event_data.break_event.user_dismissed = roll < 5;
+            t += 20;
+        } else if (roll < 6) {
+            unsigned int group = (unsigned int)t;
+            ActivityEvent* e = add(y, t, EVENT_COMMAND_RECEIVED);
+            e->group_id = group;
+            strcpy(e->event_data.command_event.command_text, commands[next_random() % 7]);
+            strcpy(e->event_data.command_event.intent, "remind");
+            strcpy(e->event_data.command_event.intent_source, roll < 4 ? "classifier" : "rules");
+            e->event_data.command_event.confidence = (700 + next_random() % 300) / 1000.0f;
+            if (roll < 1) {
+                e = add(y, t, EVENT_COMMAND_CORRECTED);
+                e->group_id = group;
+                strcpy(e->event_data.correction_event.typo, "remnid");
+                strcpy(e->event_data.correction_event.correction, "remind");
+                e->event_data.correction_event.distance = 1;
+            }
+            e = add(y, t, EVENT_POPUP_SHOWN);
+            e->group_id = group;
+            strcpy(e->event_data.popup_event.kind, "confirmation");
+            e->event_data.popup_event.latency_ms = 15 + next_random() % 30;
+            e->event_data.popup_event.mapped = true;
+        } else if (roll < 8) {
+            y->paused = !y->paused;
+            add(y, t, EVENT_PAUSE_TOGGLED)->event_data.pause_event.is_paused = y->paused;
+        } else if (roll < 10) {
+            y->deep_work = !y->deep_work;
+            ActivityEvent* e = add(y, t, y->deep_work ? EVENT_SESSION_STARTED : EVENT_SESSION_ENDED);
+            e->event_data.session_event.duration_minutes = 90;
+        } else if (roll < 11) {
+            y->next_break += 5 * 60;
+            add(y, t, EVENT_BREAK_RESCHEDULED)->event_data.reschedule_event.delay_minutes = 5;
+        }
+    }
+    add(y, evening, EVENT_APP_STOPPED);
+}
+
+int bench_generate_days(ActivityEvent* events, int days) {
+    Year year = { .events = events };
+    seed = 12345;
+
+    // Local 09:00 on 1 January 2025, then one workday per calendar day
+    struct tm start = { .tm_year = 125, .tm_mday = 1, .tm_hour = 9, .tm_isdst = -1 };
+    for (int day = 0; day < days && year.count < BENCH_MAX_EVENTS - 512; day++) {
+        struct tm morning = start;
+        morning.tm_mday += day;
+        generate_day(&year, mktime(&morning));
+    }
+    return year.count;
+}
@@ -0,0 +1,16 @@
+#ifndef BENCH_EVENTS_H
+#define BENCH_EVENTS_H
+
+#include "activity_log.h"
+
+// Synthetic activity for the log benchmarks: one workday per calendar day
+// from 1 January 2025. The app started in the morning, an eye-care break
+// every 20 minutes with its popup, a few commands, corrections, pauses and
+// work sessions, then the app stopped. Always the same events.
+#define BENCH_MAX_EVENTS 2000000
+
+// Fill events, room for BENCH_MAX_EVENTS, with days of activity; returns
+// how many there are
+int bench_generate_days(ActivityEvent* events, int days);
+
+#endif
@@ -0,0 +1,166 @@
+// Activity log write throughput, old writer against the current one.
+// Usage: bench_log [events]
+//
+// Logs the same command_received event repeatedly into a scratch HOME, once
+// through a copy of the writer activity_log.c used before records were
+// built in memory (fopen, fprintf per field, fseek to drop a trailing
+// comma, fclose, for every event) and once through log_activity_event(),
+// which queues for the logger thread. That one is fed in bursts of half its
+// queue with a flush after each, so nothing is dropped and the time covers
+// the writes; enqueue_us is the time the caller itself spent per event.
+// Prints one JSON object per writer.
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include "activity_log.h"
+
+#define MAX_EVENTS 1000000
+#define BURST 128                   // half the logger's ring
+
+// timer.c state read by get_current_system_state()
+bool is_paused = false;
+bool in_deep_work_session = false;
+time_t next_break_time = 0;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The previous writer, trimmed to the command_received event
+static void legacy_log_event(const char *path, const ActivityEvent *event) {
+    FILE *file = fopen(path, "a");
+    if (!file) {
+        return;
+    }
+    struct tm *utc_time = gmtime(&event->timestamp);
+    char timestamp_str[32];
+    strftime(timestamp_str, sizeof(timestamp_str), "%Y-%m-%dT%H:%M:%SZ", utc_time);
+
+    fprintf(file, "{");
+    fprintf(file, "\"timestamp\":\"%s\",", timestamp_str);
+    fprintf(file, "\"event_type\":\"%s\",", "command_received");
+    fprintf(file, "\"event_data\":{");
+    fprintf(file, "\"command_text\":\"");
+    for (int i = 0; event->event_data.command_event.command_text[i]; i++) {
+        char c = event->event_data.command_event.command_text[i];
+        if (c == '"' || c == '\\') {
+            fprintf(file, "\\%c", c);
+        } else {
+            fprintf(file, "%c", c);
+        }
+    }
+    fprintf(file, "\",");
+    fprintf(file, "\"intent\":\"%s\",", event->event_data.command_event.intent);
+    fprintf(file, "\"intent_source\":\"%s\",", event->event_data.command_event.intent_source);
+    fprintf(file, "\"confidence\":%.3f,", event->event_data.command_event.confidence);
+
+    long pos = ftell(file);
+    if (pos > 0) {
+        fseek(file, -1, SEEK_CUR);
+        char last_char;
+        if (fread(&last_char, 1, 1, file) == 1 && last_char == ',') {
+            fseek(file, -1, SEEK_CUR);
+        } else {
+            fseek(file, 0, SEEK_END);
+        }
+    }
+    fprintf(file, "},");
+    fprintf(file, "\"system_state\":{");
+    fprintf(file, "\"is_paused\":%s,", event->system_state.is_paused ? "true" : "false");
+    fprintf(file, "\"in_deep_work_session\":%s,", event->system_state.in_deep_work_session ? "true" : "false");
+    fprintf(file, "\"next_break_in_minutes\":%d,", event->system_state.next_break_in_minutes);
+    fprintf(file, "\"total_breaks_today\":%d,", event->system_state.total_breaks_today);
+    fprintf(file, "\"total_work_minutes_today\":%d", event->system_state.total_work_minutes_today);
+    fprintf(file, "}");
+    fprintf(file, "}\n");
+    fclose(file);
+}
+
+static void make_event(ActivityEvent *event) {
+    memset(event, 0, sizeof(*event));
+    event->timestamp = time(NULL);
+    event->event_type = EVENT_COMMAND_RECEIVED;
+    strcpy(event->event_data.command_event.command_text, "remind me to stretch in 25 minutes");
+    strcpy(event->event_data.command_event.intent, "remind");
+    strcpy(event->event_data.command_event.intent_source, "classifier");
+    event->event_data.command_event.confidence = 0.93f;
+    get_current_system_state(event);
+}
+
+static void report(const char *writer, int events, double seconds, const char *path) {
+    FILE *file = fopen(path, "r");
+    long bytes = 0;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        bytes = ftell(file);
+        fclose(file);
+    }
+    printf("{\"writer\":\"%s\",\"events\":%d,\"seconds\":%.3f,\"events_per_s\":%.0f,"
+           "\"us_per_event\":%.2f,\"bytes\":%ld",
+           writer, events, seconds, events / seconds, seconds * 1e6 / events, bytes);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+int main(int argc, char *argv[]) {
+    int events = argc > 1 ? atoi(argv[1]) : 20000;
+    if (events < 1) events = 1;
+    if (events > MAX_EVENTS) events = MAX_EVENTS;
+
+    char home[] = "/tmp/restly-bench-log-XXXXXX";
+    if (!mkdtemp(home)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    setenv("HOME", home, 1);
+    char config[sizeof(home) + 16];
+    snprintf(config, sizeof(config), "%s/.config", home);
+    mkdir(config, 0755);
+
+    init_activity_logging();
+    ActivityEvent event;
+    make_event(&event);
+
+    char legacy_path[sizeof(home) + 32];
+    snprintf(legacy_path, sizeof(legacy_path), "%s/legacy.jsonl", home);
+    double started = now_s();
+    for (int i = 0; i < events; i++) {
+        legacy_log_event(legacy_path, &event);
+    }
+    report("fopen_per_event", events, now_s() - started, legacy_path);
+    printf("}\n");
+
+    double enqueue_s = 0;
+    started = now_s();
+    for (int done = 0; done < events; done += BURST) {
+        double burst_started = now_s();
+        for (int i = done; i < events && i < done + BURST; i++) {
+            log_activity_event(&event);
+        }
+        enqueue_s += now_s() - burst_started;
+        activity_log_flush();
+    }
+    double seconds = now_s() - started;
+    ActivityLogStats stats;
+    activity_log_get_stats(&stats);
+    report("logger_thread", events, seconds, get_activity_log_path());
+    printf(",\"enqueue_us\":%.3f,\"dropped\":%lu}\n", enqueue_s * 1e6 / events, stats.dropped);
+
+    cleanup_activity_logging();
+    nftw(home, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+    return 0;
+}
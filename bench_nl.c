@@ -0,0 +1,158 @@
+// Speed and accuracy benchmark for the NL command parser.
+// Usage: bench_nl [corpus.tsv] [iterations] [model.bin]
+//
+// Each corpus line is "<intent>\t<duration>\t<command>", where intent is an
+// nl_intent_name() value and duration is the expected time in seconds, or
+// "-" for none. Commands are parsed as if it were 2025-06-11 10:00 local time.
+// Prints one JSON object so results can be compared between builds.
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "nl_parser.h"
+#include "nl_classify.h"
+
+#define MAX_LINE_LENGTH 512
+#define MAX_COMMANDS 4096
+
+typedef struct {
+    NLIntent intent;
+    int duration_seconds;   // -1: no time expression expected
+    char text[256];
+} LabelledCommand;
+
+static LabelledCommand commands[MAX_COMMANDS];
+
+static time_t corpus_now(void) {
+    struct tm tm = {0};
+    tm.tm_year = 2025 - 1900;
+    tm.tm_mon = 5;
+    tm.tm_mday = 11;
+    tm.tm_hour = 10;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int compare_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static int load_corpus(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    int count = 0;
+    while (fgets(line, sizeof(line), file) && count < MAX_COMMANDS) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        char *duration = strchr(line, '\t');
+        char *text = duration ? strchr(duration + 1, '\t') : NULL;
+        if (!text) {
+            fprintf(stderr, "malformed corpus line: %s\n", line);
+            continue;
+        }
+        *duration++ = '\0';
+        *text++ = '\0';
+
+        LabelledCommand *command = &commands[count++];
+        command->intent = nl_intent_from_name(line);
+        command->duration_seconds = strcmp(duration, "-") == 0 ? -1 : atoi(duration);
+        strncpy(command->text, text, sizeof(command->text) - 1);
+        command->text[sizeof(command->text) - 1] = '\0';
+    }
+
+    fclose(file);
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "nl_command_corpus.tsv";
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+    const char *model = argc > 3 ? argv[3] : NULL;
+    if (iterations < 1) iterations = 1;
+
+    int count = load_corpus(path);
+    if (count <= 0) {
+        fprintf(stderr, "no commands in %s\n", path);
+        return 1;
+    }
+    if (model && !nl_classifier_load(model)) {
+        fprintf(stderr, "could not load intent model %s\n", model);
+        return 1;
+    }
+
+    time_t now = corpus_now();
+    NLCommand parsed;
+
+    // Accuracy pass
+    int intent_correct = 0, duration_correct = 0;
+    int source_counts[4] = {0};
+    for (int i = 0; i < count; i++) {
+        nl_parse_command(commands[i].text, now, &parsed);
+        int duration = parsed.time.kind == NL_TIME_NONE ? -1 : parsed.time.duration_seconds;
+        if (parsed.intent == commands[i].intent) {
+            intent_correct++;
+        } else {
+            fprintf(stderr, "intent: \"%s\": expected %s, got %s\n", commands[i].text,
+                    nl_intent_name(commands[i].intent), nl_intent_name(parsed.intent));
+        }
+        if (duration == commands[i].duration_seconds) {
+            duration_correct++;
+        } else {
+            fprintf(stderr, "duration: \"%s\": expected %d, got %d\n", commands[i].text,
+                    commands[i].duration_seconds, duration);
+        }
+        source_counts[parsed.source]++;
+    }
+
+    // Timing pass: every command timed on its own for the percentiles
+    long total = (long)count * iterations;
+    long long *latencies = malloc(sizeof(long long) * total);
+    if (!latencies) {
+        perror("malloc");
+        return 1;
+    }
+
+    long long start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 0; i < count; i++) {
+            long long t0 = now_ns();
+            nl_parse_command(commands[i].text, now, &parsed);
+            latencies[(long)it * count + i] = now_ns() - t0;
+        }
+    }
+    long long elapsed = now_ns() - start;
+
+    qsort(latencies, total, sizeof(long long), compare_ll);
+    long long p50 = latencies[total / 2];
+    long long p99 = latencies[(total * 99) / 100];
+    long long max = latencies[total - 1];
+    free(latencies);
+
+    printf("{\"corpus\":\"%s\",\"commands\":%d,\"iterations\":%d,\"classifier\":%s,"
+           "\"commands_per_sec\":%.0f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f,"
+           "\"intent_accuracy\":%.4f,\"duration_accuracy\":%.4f,"
+           "\"sources\":{\"none\":%d,\"classifier\":%d,\"rules\":%d,\"fuzzy\":%d}}\n",
+           path, count, iterations, nl_classifier_loaded() ? "true" : "false",
+           total / (elapsed / 1e9), p50 / 1000.0, p99 / 1000.0, max / 1000.0,
+           (double)intent_correct / count, (double)duration_correct / count,
+           source_counts[NL_SOURCE_NONE], source_counts[NL_SOURCE_CLASSIFIER],
+           source_counts[NL_SOURCE_RULES], source_counts[NL_SOURCE_FUZZY]);
+
+    nl_classifier_unload();
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Offscreen popup rendering benchmark; no display needed.
+// Usage: bench_popup [messages.txt] [iterations] [png-dir]
+//
+// One message per line, "\n" in a line stands for a line break. Prints one
+// JSON object per message with median layout/render time over the
+// iterations, then a summary line and one line for the countdown ring over
+// the 21 s look-away step. With png-dir, writes <n>.png per message for
+// golden-image comparison.
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "popup_offscreen.h"
+#include "popup_ring.h"
+#include "popup_style.h"
+
+#define MAX_LINE_LENGTH 1024
+#define MAX_ITERATIONS 10000
+#define RING_STEP_MS 21000
+#define RING_MAX_TICK_MS 250        // the renderer's ROUTINE_TICK_MS
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void unescape(char *text) {
+    char *out = text;
+    for (char *p = text; *p; p++) {
+        if (p[0] == '\\' && p[1] == 'n') {
+            *out++ = '\n';
+            p++;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+}
+
+static void print_json_string(const char *text) {
+    putchar('"');
+    for (const char *p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            printf("\\%c", *p);
+        } else if (*p == '\n') {
+            printf("\\n");
+        } else {
+            putchar(*p);
+        }
+    }
+    putchar('"');
+}
+
+// One step of the countdown ring, ticked as the renderer ticks it: each
+// change is drawn clipped to its damage, as GTK would after queue_draw_area
+static bool bench_ring(unsigned int step_ms) {
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, POPUP_RING_SIZE, POPUP_RING_SIZE);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return false;
+    }
+    cairo_t *cr = cairo_create(surface);
+    unsigned int tick_ms = popup_ring_tick_ms(step_ms, RING_MAX_TICK_MS);
+    int drawn = 0, ticks = 0, redraws = 0;
+    long damaged_px = 0;
+    double draw_us = 0, worst_us = 0;
+
+    for (unsigned int t = 0; t <= step_ms; t += tick_ms) {
+        ticks++;
+        int steps = popup_ring_steps((double)(step_ms - t) / step_ms);
+        PopupRingRect damage;
+        if (!popup_ring_damage(drawn, steps, &damage)) {
+            continue;
+        }
+        drawn = steps;
+        double started = now_us();
+        cairo_save(cr);
+        cairo_rectangle(cr, damage.x, damage.y, damage.width, damage.height);
+        cairo_clip(cr);
+        popup_ring_draw(cr, steps);
+        cairo_restore(cr);
+        cairo_surface_flush(surface);
+        double took = now_us() - started;
+
+        redraws++;
+        damaged_px += damage.width * damage.height;
+        draw_us += took;
+        if (took > worst_us) {
+            worst_us = took;
+        }
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+
+    printf("{\"ring\":true,\"step_ms\":%u,\"tick_ms\":%u,\"ticks\":%d,\"redraws\":%d,"
+           "\"mean_damage_px\":%.1f,\"mean_draw_us\":%.1f,\"worst_draw_us\":%.1f,\"draw_us_per_s\":%.1f}\n",
+           step_ms, tick_ms, ticks, redraws, redraws ? (double)damaged_px / redraws : 0.0,
+           redraws ? draw_us / redraws : 0.0, worst_us, draw_us * 1000.0 / step_ms);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "popup_bench_messages.txt";
+    int iterations = argc > 2 ? atoi(argv[2]) : 100;
+    const char *png_dir = argc > 3 ? argv[3] : NULL;
+    if (iterations < 1) iterations = 1;
+    if (iterations > MAX_ITERATIONS) iterations = MAX_ITERATIONS;
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+
+    static double layout_us[MAX_ITERATIONS];
+    static double render_us[MAX_ITERATIONS];
+    char line[MAX_LINE_LENGTH];
+    int messages = 0;
+    double total_layout = 0, total_render = 0, worst = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        unescape(line);
+
+        PopupRenderStats stats;
+        for (int i = 0; i < iterations; i++) {
+            if (!popup_offscreen_render(line, NULL, &stats)) {
+                fprintf(stderr, "render failed: %s\n", line);
+                fclose(file);
+                return 1;
+            }
+            layout_us[i] = stats.layout_us;
+            render_us[i] = stats.render_us;
+        }
+        qsort(layout_us, iterations, sizeof(double), compare_double);
+        qsort(render_us, iterations, sizeof(double), compare_double);
+        double layout_p50 = layout_us[iterations / 2];
+        double render_p50 = render_us[iterations / 2];
+
+        if (png_dir) {
+            char png_path[512];
+            snprintf(png_path, sizeof(png_path), "%s/%d.png", png_dir, messages);
+            if (!popup_offscreen_render(line, png_path, &stats)) {
+                fprintf(stderr, "could not write %s\n", png_path);
+            }
+        }
+
+        printf("{\"message\":");
+        print_json_string(line);
+        printf(",\"bytes\":%zu,\"width\":%d,\"height\":%d,\"layout_us\":%.1f,\"render_us\":%.1f}\n",
+               strlen(line), stats.width, stats.height, layout_p50, render_p50);
+
+        messages++;
+        total_layout += layout_p50;
+        total_render += render_p50;
+        if (layout_p50 + render_p50 > worst) {
+            worst = layout_p50 + render_p50;
+        }
+    }
+    fclose(file);
+
+    if (messages == 0) {
+        fprintf(stderr, "no messages in %s\n", path);
+        return 1;
+    }
+    printf("{\"summary\":true,\"messages\":%d,\"iterations\":%d,\"mean_layout_us\":%.1f,"
+           "\"mean_render_us\":%.1f,\"worst_total_us\":%.1f}\n",
+           messages, iterations, total_layout / messages, total_render / messages, worst);
+    if (!bench_ring(RING_STEP_MS)) {
+        fprintf(stderr, "ring surface could not be created\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,226 @@
+// Size and parse speed of the binary activity log against JSONL.
+// Usage: bench_rlog [days]
+//
+// Generates a synthetic year (by default) of workdays (bench_events.h).
+// The events are written both ways in memory and each form is parsed back
+// into ActivityEvents: the binary one with the rlog reader, the JSON one by
+// a field-by-field scanner (no general JSON parser, so a lower bound for
+// JSONL consumers). Sizes include gzip, as archived days are stored. Checks
+// that every decoded binary record prints the same JSON line as the
+// original. Prints one JSON object per format.
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include "activity_log.h"
+#include "rlog.h"
+#include "bench_events.h"
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// JSONL scanner: "key":value pairs in order, objects entered as they come
+
+static const char* scan_string(const char* p, char* out, size_t size) {
+    size_t len = 0;
+    p++;    // opening quote
+    while (*p && *p != '"') {
+        char c = *p++;
+        if (c == '\\' && *p) {
+            c = *p++;
+            if (c == 'u') {
+                c = (char)strtol((char[]){p[0], p[1], p[2], p[3], 0}, NULL, 16);
+                p += 4;
+            }
+        }
+        if (len + 1 < size) out[len++] = c;
+    }
+    out[len] = '\0';
+    return *p ? p + 1 : p;
+}
+
+static ActivityEventType type_from_name(const char* name) {
+    static const char* names[] = {
+        "break_shown", "break_completed", "session_started", "session_ended", "pause_toggled",
+        "break_rescheduled", "command_received", "app_started", "app_stopped", "command_corrected",
+        "popup_shown",
+    };
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(name, names[i]) == 0) return i;
+    }
+    return EVENT_APP_STARTED;
+}
+
+static void parse_json_line(const char* p, ActivityEvent* e) {
+    char key[32], text[256];
+    bool in_state = false;
+    memset(e, 0, sizeof(*e));
+    while ((p = strchr(p, '"'))) {
+        p = scan_string(p, key, sizeof(key));
+        if (*p != ':') continue;
+        p++;
+        if (*p == '{') {
+            in_state = strcmp(key, "system_state") == 0;
+            p++;
+            continue;
+        }
+        long number = 0;
+        double real = 0;
+        bool flag = false;
+        text[0] = '\0';
+        if (*p == '"') {
+            p = scan_string(p, text, sizeof(text));
+        } else if (*p == 't' || *p == 'f') {
+            flag = *p == 't';
+        } else {
+            real = strtod(p, NULL);
+            number = (long)real;
+        }
+
+        if (in_state) {
+            if (strcmp(key, "is_paused") == 0) e->system_state.is_paused = flag;
+            else if (strcmp(key, "in_deep_work_session") == 0) e->system_state.in_deep_work_session = flag;
+            else if (strcmp(key, "next_break_in_minutes") == 0) e->system_state.next_break_in_minutes = number;
+            else if (strcmp(key, "total_breaks_today") == 0) e->system_state.total_breaks_today = number;
+            else if (strcmp(key, "total_work_minutes_today") == 0) e->system_state.total_work_minutes_today = number;
+        } else if (strcmp(key, "timestamp") == 0) {
+            struct tm tm = {0};
+            strptime(text, "%Y-%m-%dT%H:%M:%SZ", &tm);
+            e->timestamp = timegm(&tm);
+        } else if (strcmp(key, "event_type") == 0) {
+            e->event_type = type_from_name(text);
+        } else if (strcmp(key, "group") == 0) {
+            e->group_id = (unsigned int)number;
+        } else if (strcmp(key, "duration_seconds") == 0) {
+            e->event_data.break_event.duration_seconds = number;
+        } else if (strcmp(key, "user_dismissed") == 0) {
+            e->event_data.break_event.user_dismissed = flag;
+        } else if (strcmp(key, "duration_minutes") == 0) {
+            e->event_data.session_event.duration_minutes = number;
+        } else if (strcmp(key, "is_paused") == 0) {
+            e->event_data.pause_event.is_paused = flag;
+        } else if (strcmp(key, "delay_minutes") == 0) {
+            e->event_data.reschedule_event.delay_minutes = number;
+        } else if (strcmp(key, "command_text") == 0) {
+            strcpy(e->event_data.command_event.command_text, text);
+        } else if (strcmp(key, "intent") == 0) {
+            snprintf(e->event_data.command_event.intent, 16, "%s", text);
+        } else if (strcmp(key, "intent_source") == 0) {
+            snprintf(e->event_data.command_event.intent_source, 16, "%s", text);
+        } else if (strcmp(key, "confidence") == 0) {
+            e->event_data.command_event.confidence = (float)real;
+        } else if (strcmp(key, "typo") == 0) {
+            snprintf(e->event_data.correction_event.typo, 32, "%s", text);
+        } else if (strcmp(key, "correction") == 0) {
+            snprintf(e->event_data.correction_event.correction, 32, "%s", text);
+        } else if (strcmp(key, "distance") == 0) {
+            e->event_data.correction_event.distance = number;
+        } else if (strcmp(key, "kind") == 0) {
+            snprintf(e->event_data.popup_event.kind, 16, "%s", text);
+        } else if (strcmp(key, "latency_ms") == 0) {
+            e->event_data.popup_event.latency_ms = number;
+        } else if (strcmp(key, "mapped") == 0) {
+            e->event_data.popup_event.mapped = flag;
+        }
+    }
+}
+
+static unsigned long gzip_size(const unsigned char* data, size_t len) {
+    uLongf size = compressBound(len);
+    unsigned char* out = malloc(size);
+    if (!out || compress2(out, &size, data, len, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        size = 0;
+    }
+    free(out);
+    return size;
+}
+
+static void report(const char* format, int events, size_t bytes, unsigned long gzip_bytes, double seconds) {
+    printf("{\"format\":\"%s\",\"events\":%d,\"bytes\":%zu,\"bytes_per_event\":%.1f,\"gzip_bytes\":%lu,"
+           "\"parse_s\":%.3f,\"events_per_s\":%.0f",
+           format, events, bytes, (double)bytes / events, gzip_bytes, seconds, events / seconds);
+}
+
+int main(int argc, char* argv[]) {
+    int days = argc > 1 ? atoi(argv[1]) : 365;
+    if (days < 1) days = 1;
+
+    ActivityEvent* events = malloc(sizeof(ActivityEvent) * BENCH_MAX_EVENTS);
+    size_t capacity = (size_t)BENCH_MAX_EVENTS * 400;
+    unsigned char* jsonl = malloc(capacity);
+    unsigned char* rlog = malloc(capacity);
+    ActivityEvent* parsed = malloc(sizeof(ActivityEvent) * BENCH_MAX_EVENTS);
+    if (!events || !jsonl || !rlog || !parsed) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    int total = bench_generate_days(events, days);
+
+    // Both encodings; a new binary segment per day and every
+    // RLOG_SEGMENT_RECORDS records, as the daemon writes it
+    size_t jsonl_len = 0, rlog_len = 0;
+    RlogContext ctx;
+    int segment_records = 0;
+    for (int i = 0; i < total; i++) {
+        const ActivityEvent* e = &events[i];
+        jsonl_len += activity_event_to_json(e, (char*)jsonl + jsonl_len, capacity - jsonl_len);
+        if (i == 0 || e->event_type == EVENT_APP_STARTED || segment_records == RLOG_SEGMENT_RECORDS) {
+            rlog_len += rlog_write_header(&ctx, e->timestamp, rlog + rlog_len, capacity - rlog_len);
+            segment_records = 0;
+        }
+        segment_records++;
+        rlog_len += rlog_write_event(&ctx, e, rlog + rlog_len, capacity - rlog_len);
+    }
+
+    // JSONL, line by line
+    double started = now_s();
+    int count = 0;
+    for (char* line = (char*)jsonl; line < (char*)jsonl + jsonl_len; count++) {
+        char* end = memchr(line, '\n', (char*)jsonl + jsonl_len - line);
+        *end = '\0';
+        parse_json_line(line, &parsed[count]);
+        *end = '\n';
+        line = end + 1;
+    }
+    double jsonl_s = now_s() - started;
+    report("jsonl", count, jsonl_len, gzip_size(jsonl, jsonl_len), jsonl_s);
+    printf("}\n");
+
+    // Binary, then the round trip through the JSON writer
+    started = now_s();
+    RlogReader reader;
+    rlog_reader_init(&reader, rlog, rlog_len);
+    count = 0;
+    while (count < BENCH_MAX_EVENTS && rlog_read_event(&reader, &parsed[count]) == RLOG_EVENT) {
+        count++;
+    }
+    double rlog_s = now_s() - started;
+
+    bool same = count == total;
+    char expected[2048], actual[2048];
+    for (int i = 0; same && i < count; i++) {
+        size_t a = activity_event_to_json(&events[i], expected, sizeof(expected));
+        size_t b = activity_event_to_json(&parsed[i], actual, sizeof(actual));
+        same = a == b && memcmp(expected, actual, a) == 0;
+        if (!same) {
+            fprintf(stderr, "event %d differs:\n%.*s%.*s", i, (int)a, expected, (int)b, actual);
+        }
+    }
+    report("rlog", count, rlog_len, gzip_size(rlog, rlog_len), rlog_s);
+    printf(",\"size_ratio\":%.3f,\"parse_speedup\":%.1f,\"roundtrip\":%s}\n",
+           (double)rlog_len / jsonl_len, jsonl_s / rlog_s, same ? "true" : "false");
+
+    free(events);
+    free(jsonl);
+    free(rlog);
+    free(parsed);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// Startup time and memory of the restly daemon and its popup renderer.
+// Usage: bench_startup [path/to/restly] [runs]
+//
+// Each run starts "restly --foreground" with a scratch HOME, times how long
+// it takes until the control socket answers, waits for the renderer to
+// report READY (see "stats" on the control socket) and reads VmRSS of both
+// processes from /proc before stopping the daemon again. Without a display
+// the renderer cannot start; its fields are then reported as null.
+// Prints one JSON object so results can be compared between builds.
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define MAX_RUNS 1000
+#define STARTUP_TIMEOUT_MS 5000
+#define RENDERER_TIMEOUT_MS 2000
+
+typedef struct {
+    long long daemon_ready_us;      // exec -> control socket answers
+    long daemon_rss_kb;
+    int renderer_started;
+    long long renderer_child_us;    // fork -> restly-popup main()
+    long long renderer_ready_us;    // fork -> window built
+    long renderer_rss_kb;
+    int daemon_maps_gtk;
+} StartupRun;
+
+static StartupRun runs[MAX_RUNS];
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int compare_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+// "VmRSS:" of a process in kB, -1 if it is gone
+static long read_rss_kb(int pid) {
+    char path[64], line[256];
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    long rss = -1;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "VmRSS: %ld", &rss) == 1) {
+            break;
+        }
+    }
+    fclose(file);
+    return rss;
+}
+
+static int maps_library(int pid, const char *name) {
+    char path[64], line[512];
+    snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file)) {
+        found = strstr(line, name) != NULL;
+    }
+    fclose(file);
+    return found;
+}
+
+static int connect_control(const char *socket_path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    memcpy(addr.sun_path, socket_path, strlen(socket_path) + 1); // sized like sun_path
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One "stats" round trip; the reply ends with an empty line
+static int query_stats(int fd, char *reply, size_t size) {
+    if (write(fd, "stats\n", 6) != 6) {
+        return -1;
+    }
+    size_t used = 0;
+    while (used < size - 1) {
+        ssize_t n = read(fd, reply + used, size - 1 - used);
+        if (n <= 0) {
+            return -1;
+        }
+        used += n;
+        reply[used] = '\0';
+        if (strstr(reply, "\n\n")) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static long long stats_value(const char *reply, const char *key) {
+    size_t len = strlen(key);
+    for (const char *line = reply; line && *line; line = strchr(line, '\n'), line = line ? line + 1 : NULL) {
+        if (strncmp(line, key, len) == 0 && line[len] == ' ') {
+            return atoll(line + len + 1);
+        }
+    }
+    return -1;
+}
+
+static int run_once(const char *daemon_path, StartupRun *run) {
+    char home[] = "/tmp/restly-bench-XXXXXX";
+    if (!mkdtemp(home)) {
+        perror("mkdtemp");
+        return -1;
+    }
+    // The daemon creates ~/.config/restly but expects ~/.config to exist
+    char socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    snprintf(socket_path, sizeof(socket_path), "%s/.config", home);
+    mkdir(socket_path, 0755);
+    snprintf(socket_path, sizeof(socket_path), "%s/.config/restly/restly.sock", home);
+
+    long long start = now_ns();
+    pid_t pid = fork();
+    if (pid == 0) {
+        setenv("HOME", home, 1);
+        int null_fd = open("/dev/null", O_RDWR);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execl(daemon_path, daemon_path, "--foreground", (char *)NULL);
+        _exit(127);
+    }
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+
+    int fd = -1;
+    while ((fd = connect_control(socket_path)) < 0) {
+        if (now_ns() - start > STARTUP_TIMEOUT_MS * 1000000LL || waitpid(pid, NULL, WNOHANG) == pid) {
+            fprintf(stderr, "%s did not open %s\n", daemon_path, socket_path);
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+            nftw(home, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+            return -1;
+        }
+        sleep_ms(1);
+    }
+    run->daemon_ready_us = (now_ns() - start) / 1000;
+
+    char reply[4096];
+    long long waited_from = now_ns();
+    run->renderer_started = 0;
+    while (query_stats(fd, reply, sizeof(reply)) == 0) {
+        if (stats_value(reply, "renderer_starts") > 0) {
+            run->renderer_started = 1;
+            break;
+        }
+        if (now_ns() - waited_from > RENDERER_TIMEOUT_MS * 1000000LL) {
+            break;
+        }
+        sleep_ms(5);
+    }
+    close(fd);
+
+    run->daemon_rss_kb = read_rss_kb(pid);
+    run->daemon_maps_gtk = maps_library(pid, "libgtk-3");
+    run->renderer_child_us = stats_value(reply, "renderer_child_us");
+    run->renderer_ready_us = stats_value(reply, "renderer_ready_us");
+    long long renderer_pid = stats_value(reply, "renderer_pid");
+    run->renderer_rss_kb = run->renderer_started && renderer_pid > 0 ? read_rss_kb((int)renderer_pid) : -1;
+
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    nftw(home, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    return 0;
+}
+
+// Median of one field over the successful runs, -1 if none had it
+static long long median(int count, long long (*field)(const StartupRun *)) {
+    long long values[MAX_RUNS];
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        long long value = field(&runs[i]);
+        if (value >= 0) {
+            values[n++] = value;
+        }
+    }
+    if (n == 0) {
+        return -1;
+    }
+    qsort(values, n, sizeof(long long), compare_ll);
+    return values[n / 2];
+}
+
+static long long daemon_ready_us(const StartupRun *run) { return run->daemon_ready_us; }
+static long long daemon_rss_kb(const StartupRun *run) { return run->daemon_rss_kb; }
+static long long renderer_child_us(const StartupRun *run) { return run->renderer_started ? run->renderer_child_us : -1; }
+static long long renderer_ready_us(const StartupRun *run) { return run->renderer_started ? run->renderer_ready_us : -1; }
+static long long renderer_rss_kb(const StartupRun *run) { return run->renderer_rss_kb; }
+
+static void print_field(const char *name, long long value, int last) {
+    if (value < 0) {
+        printf("\"%s\":null%s", name, last ? "" : ",");
+    } else {
+        printf("\"%s\":%lld%s", name, value, last ? "" : ",");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *daemon_path = argc > 1 ? argv[1] : "./restly";
+    int count = argc > 2 ? atoi(argv[2]) : 20;
+    if (count < 1) count = 1;
+    if (count > MAX_RUNS) count = MAX_RUNS;
+
+    int ok = 0, renderer_ok = 0, gtk_in_daemon = 0;
+    for (int i = 0; i < count; i++) {
+        if (run_once(daemon_path, &runs[ok]) == 0) {
+            renderer_ok += runs[ok].renderer_started;
+            gtk_in_daemon |= runs[ok].daemon_maps_gtk;
+            ok++;
+        }
+    }
+    if (ok == 0) {
+        fprintf(stderr, "no successful runs\n");
+        return 1;
+    }
+
+    printf("{\"daemon\":\"%s\",\"runs\":%d,\"renderer_runs\":%d,\"daemon_maps_gtk\":%s,",
+           daemon_path, ok, renderer_ok, gtk_in_daemon ? "true" : "false");
+    print_field("daemon_ready_us", median(ok, daemon_ready_us), 0);
+    print_field("daemon_rss_kb", median(ok, daemon_rss_kb), 0);
+    print_field("renderer_child_us", median(ok, renderer_child_us), 0);
+    print_field("renderer_ready_us", median(ok, renderer_ready_us), 0);
+    print_field("renderer_rss_kb", median(ok, renderer_rss_kb), 1);
+    printf("}\n");
+    return 0;
+}
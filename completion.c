@@ -0,0 +1,306 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <zlib.h>
+#include "completion.h"
+#include "activity_log.h"
+#include "rlog.h"
+
+// Fixed arena: the daemon never frees trie nodes, and history is bounded
+#define COMPLETION_MAX_NODES 16384
+#define COMPLETION_POOL_SIZE (64 * 1024)
+
+typedef struct {
+    uint16_t first_child;   // node index, 0 for none (node 0 is the root)
+    uint16_t next_sibling;
+    char ch;
+    uint32_t count;         // uses of the command ending here, 0 if none
+    uint32_t text;          // offset of the full command in text_pool
+    uint16_t top[COMPLETION_MAX_RESULTS]; // best commands below, by count
+} TrieNode;
+
+static TrieNode nodes[COMPLETION_MAX_NODES];
+static int node_count = 1;
+static char text_pool[COMPLETION_POOL_SIZE];
+static size_t pool_used = 0;
+
+// Commands offered before any history exists
+static const char *seed_commands[] = {
+    "reschedule break",
+    "reschedule break by 15 minutes",
+    "delay 10 minutes",
+    "delay 30 minutes",
+    "postpone break until 3pm",
+    "pause",
+    "pause for 30 minutes",
+    "pause for 1 hour",
+    "resume",
+    "deep work 45 minutes",
+    "deep work 90 minutes",
+    "start a 90 minute focus session",
+    "focus until 5pm",
+    "break now",
+    "status",
+    "pause for 30 minutes then start a 90 minute focus session",
+};
+
+// Lowercase, trim and collapse whitespace. A single trailing space is kept
+// when keep_trailing is set, so "deep " only completes whole words.
+static size_t normalize(const char *in, char *out, size_t size, bool keep_trailing) {
+    size_t len = 0;
+    bool space = false;
+    for (const char *p = in; *p && len < size - 1; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (isspace(c)) {
+            space = len > 0;
+            continue;
+        }
+        if (space && len < size - 2) {
+            out[len++] = ' ';
+        }
+        space = false;
+        out[len++] = (char)tolower(c);
+    }
+    if (keep_trailing && space && len < size - 1) {
+        out[len++] = ' ';
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static int find_child(int parent, char ch) {
+    for (int n = nodes[parent].first_child; n; n = nodes[n].next_sibling) {
+        if (nodes[n].ch == ch) return n;
+    }
+    return 0;
+}
+
+static int add_child(int parent, char ch) {
+    if (node_count >= COMPLETION_MAX_NODES) {
+        return 0;
+    }
+    int n = node_count++;
+    memset(&nodes[n], 0, sizeof(nodes[n]));
+    nodes[n].ch = ch;
+    nodes[n].next_sibling = nodes[parent].first_child;
+    nodes[parent].first_child = (uint16_t)n;
+    return n;
+}
+
+// Keep node's top list sorted after terminal's count went up
+static void update_top(TrieNode *node, int terminal) {
+    uint16_t *top = node->top;
+    uint32_t count = nodes[terminal].count;
+    int slot = COMPLETION_MAX_RESULTS - 1;
+
+    for (int i = 0; i < COMPLETION_MAX_RESULTS; i++) {
+        if (top[i] == terminal || top[i] == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (top[slot] != terminal && top[slot] != 0 && nodes[top[slot]].count >= count) {
+        return;
+    }
+
+    top[slot] = (uint16_t)terminal;
+    while (slot > 0 && nodes[top[slot - 1]].count < count) {
+        uint16_t tmp = top[slot - 1];
+        top[slot - 1] = top[slot];
+        top[slot] = tmp;
+        slot--;
+    }
+}
+
+void completion_record(const char *command, unsigned int weight) {
+    char text[COMPLETION_TEXT_MAX];
+    size_t len = normalize(command, text, sizeof(text), false);
+    if (len == 0 || weight == 0) {
+        return;
+    }
+
+    int path[COMPLETION_TEXT_MAX + 1];
+    int depth = 0;
+    int n = 0;
+    path[depth++] = 0;
+    for (size_t i = 0; i < len; i++) {
+        int child = find_child(n, text[i]);
+        if (!child && !(child = add_child(n, text[i]))) {
+            return; // arena full: keep what we have
+        }
+        n = child;
+        path[depth++] = n;
+    }
+
+    if (nodes[n].count == 0) {
+        if (pool_used + len + 1 > sizeof(text_pool)) {
+            return;
+        }
+        nodes[n].text = (uint32_t)pool_used;
+        memcpy(text_pool + pool_used, text, len + 1);
+        pool_used += len + 1;
+    }
+    nodes[n].count += weight;
+
+    for (int i = 0; i < depth; i++) {
+        update_top(&nodes[path[i]], n);
+    }
+}
+
+int completion_query(const char *prefix, CompletionResult *results, int max) {
+    char text[COMPLETION_TEXT_MAX];
+    size_t len = normalize(prefix, text, sizeof(text), true);
+
+    int n = 0;
+    for (size_t i = 0; i < len; i++) {
+        n = find_child(n, text[i]);
+        if (!n) return 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < COMPLETION_MAX_RESULTS && count < max && nodes[n].top[i]; i++) {
+        const TrieNode *terminal = &nodes[nodes[n].top[i]];
+        results[count].text = text_pool + terminal->text;
+        results[count].count = terminal->count;
+        count++;
+    }
+    return count;
+}
+
+// Pull command_text out of one command_received log line
+static bool extract_command(const char *line, char *out, size_t size) {
+    if (!strstr(line, "\"event_type\":\"command_received\"")) {
+        return false;
+    }
+    // Commands nothing understood would only teach the palette typos
+    if (strstr(line, "\"intent\":\"unknown\"")) {
+        return false;
+    }
+    const char *p = strstr(line, "\"command_text\":\"");
+    if (!p) {
+        return false;
+    }
+    p += strlen("\"command_text\":\"");
+
+    size_t len = 0;
+    while (*p && *p != '"' && len < size - 1) {
+        if (*p == '\\' && p[1]) {
+            p++;
+        }
+        out[len++] = *p++;
+    }
+    out[len] = '\0';
+    return len > 0;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool has_suffix(const char *name, const char *suffix) {
+    size_t len = strlen(name), suffix_len = strlen(suffix);
+    return len > suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+// Log names are "activity_" then the date, YYYY-MM-DD
+static bool same_day(const char *a, const char *b) {
+    return strncmp(a + 9, b + 9, 10) == 0;
+}
+
+static void load_rlog_history(const char *path) {
+    size_t len;
+    unsigned char *data = rlog_load_file(path, &len);
+    if (!data) return;
+
+    RlogReader reader;
+    ActivityEvent event;
+    rlog_reader_init(&reader, data, len);
+    while (rlog_read_event(&reader, &event) == RLOG_EVENT) {
+        if (event.event_type == EVENT_COMMAND_RECEIVED
+            && strcmp(event.event_data.command_event.intent, "unknown") != 0) {
+            completion_record(event.event_data.command_event.command_text, 1);
+        }
+    }
+    free(data);
+}
+
+static void load_history(void) {
+    const char *home = getenv("HOME");
+    if (!home) return;
+
+    char dir_path[512];
+    snprintf(dir_path, sizeof(dir_path), "%s/.config/restly/activity", home);
+    DIR *dir = opendir(dir_path);
+    if (!dir) return;
+
+    // Daily files sort by date; only those of the newest days are read, a
+    // day being one or more files (plain or gzipped, JSON lines or binary).
+    // Past days are gzipped, which gzopen reads as readily as the plain
+    // files; binary logs (see rlog.h) are decoded.
+    char **names = NULL;
+    int name_count = 0, name_capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        const char *name = entry->d_name;
+        if (strncmp(name, "activity_", 9) == 0 && strlen(name) > 19
+            && (has_suffix(name, ".jsonl") || has_suffix(name, ".jsonl.gz")
+                || has_suffix(name, ".rlog") || has_suffix(name, ".rlog.gz"))) {
+            if (name_count == name_capacity) {
+                name_capacity = name_capacity ? 2 * name_capacity : 64;
+                char **bigger = realloc(names, name_capacity * sizeof(names[0]));
+                if (!bigger) break;
+                names = bigger;
+            }
+            names[name_count++] = strdup(name);
+        }
+    }
+    closedir(dir);
+    if (name_count > 0) {
+        qsort(names, name_count, sizeof(names[0]), compare_names);
+    }
+
+    // Back from the newest file to the first of the oldest day kept
+    int first = name_count, days = 0;
+    while (first > 0) {
+        bool new_day = first == name_count || !same_day(names[first - 1], names[first]);
+        if (new_day && days == COMPLETION_HISTORY_DAYS) break;
+        days += new_day;
+        first--;
+    }
+    for (int i = 0; i < name_count; i++) {
+        if (i >= first) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%s", dir_path, names[i]);
+            gzFile file;
+            if (strstr(names[i], ".rlog")) {
+                load_rlog_history(path);
+            } else if ((file = gzopen(path, "rb"))) {
+                char line[2048];
+                char command[COMPLETION_TEXT_MAX];
+                while (gzgets(file, line, sizeof(line))) {
+                    if (extract_command(line, command, sizeof(command))) {
+                        completion_record(command, 1);
+                    }
+                }
+                gzclose(file);
+            }
+        }
+        free(names[i]);
+    }
+    free(names);
+}
+
+void completion_init(void) {
+    node_count = 1;
+    pool_used = 0;
+    memset(&nodes[0], 0, sizeof(nodes[0]));
+
+    for (size_t i = 0; i < sizeof(seed_commands) / sizeof(seed_commands[0]); i++) {
+        completion_record(seed_commands[i], 1);
+    }
+    load_history();
+}
@@ -0,0 +1,27 @@
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <stdbool.h>
+
+// Palette autocompletion: a prefix trie over known commands, each node
+// caching its most frequent completions so a query is one walk down the prefix
+#define COMPLETION_MAX_RESULTS 5
+#define COMPLETION_TEXT_MAX 96
+#define COMPLETION_HISTORY_DAYS 60
+
+typedef struct {
+    const char *text;
+    unsigned int count;     // seed weight plus the times it was used
+} CompletionResult;
+
+// Seed with the intent vocabulary, then add command_received history from
+// the activity logs of the last COMPLETION_HISTORY_DAYS days that have any
+void completion_init(void);
+
+// Count one use of a command (normalized: lowercase, single spaces)
+void completion_record(const char *command, unsigned int weight);
+
+// Up to max completions of prefix, most frequent first. Returns the count.
+int completion_query(const char *prefix, CompletionResult *results, int max);
+
+#endif
@@ -11,6 +11,11 @@ AppConfig parse_arguments(int argc, char *argv[])
         .duration_seconds = 20,
         .message = NULL,
         .eye_care = 1,
+        .foreground = 0,
+        .popup_backend = POPUP_BACKEND_GTK,
+        .log_popups = 0,
+        .log_format = ACTIVITY_LOG_JSONL,
+        .activity_db = 0,
         .start_time = "00:00",
         .end_time = "23:59"
     };
@@ -50,6 +55,32 @@ AppConfig parse_arguments(int argc, char *argv[])
         {
             config.eye_care = atoi(argv[++i]);
         }
+        else if (strcmp(argv[i], "--foreground") == 0)
+        {
+            config.foreground = 1;
+        }
+        else if (strcmp(argv[i], "--popup-backend") == 0 && i + 1 < argc)
+        {
+            if (!popup_backend_from_name(argv[++i], &config.popup_backend))
+            {
+                fprintf(stderr, "Unknown popup backend '%s' (gtk, dbus or auto), using gtk\n", argv[i]);
+            }
+        }
+        else if (strcmp(argv[i], "--log-popups") == 0)
+        {
+            config.log_popups = 1;
+        }
+        else if (strcmp(argv[i], "--log-format") == 0 && i + 1 < argc)
+        {
+            if (!activity_log_format_from_name(argv[++i], &config.log_format))
+            {
+                fprintf(stderr, "Unknown log format '%s' (jsonl or binary), using jsonl\n", argv[i]);
+            }
+        }
+        else if (strcmp(argv[i], "--activity-db") == 0)
+        {
+            config.activity_db = 1;
+        }
         else if ((strcmp(argv[i], "--stop") == 0))
         {
             stopdaemon();
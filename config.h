@@ -1,6 +1,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 #include <stdio.h>
+#include "popup.h"
+#include "activity_log.h"
 
 typedef struct {
     int interval_minutes;
@@ -9,6 +11,11 @@ typedef struct {
     char start_time[6];
     char end_time[6];
     int eye_care;
+    int foreground;     // stay attached to the terminal, don't daemonize
+    PopupBackend popup_backend;
+    int log_popups;     // log a popup_shown event with its time-to-visible
+    ActivityLogFormat log_format;
+    int activity_db;    // also write events to activity/activity.db (SQLite)
 }AppConfig;
 
 AppConfig parse_arguments(int argc, char *argv[]);
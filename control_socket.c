@@ -0,0 +1,239 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "control_socket.h"
+#include "event_loop.h"
+#include "completion.h"
+#include "popup.h"
+#include "activity_log.h"
+
+#define CLIENT_BUFFER_SIZE 512
+#define REPLY_BUFFER_SIZE 2048
+
+typedef struct {
+    int fd;
+    size_t used;
+    char buffer[CLIENT_BUFFER_SIZE];
+} Client;
+
+static int listen_fd = -1;
+static char socket_path[108];
+static Client clients[CONTROL_SOCKET_MAX_CLIENTS];
+
+const char *get_control_socket_path(void) {
+    const char *home = getenv("HOME");
+    if (!home) {
+        return NULL;
+    }
+    snprintf(socket_path, sizeof(socket_path), "%s/.config/restly/restly.sock", home);
+    return socket_path;
+}
+
+static void close_client(Client *client) {
+    event_loop_remove(client->fd);
+    close(client->fd);
+    client->fd = -1;
+    client->used = 0;
+}
+
+static void reply_complete(const char *prefix, char *reply, size_t size) {
+    CompletionResult results[COMPLETION_MAX_RESULTS];
+    int count = completion_query(prefix, results, COMPLETION_MAX_RESULTS);
+    size_t len = 0;
+    for (int i = 0; i < count && len < size; i++) {
+        len += snprintf(reply + len, size - len, "%s\t%u\n", results[i].text, results[i].count);
+    }
+}
+
+static void reply_stats(char *reply, size_t size) {
+    PopupStats stats;
+    popup_get_stats(&stats);
+
+    size_t len = snprintf(reply, size,
+                          "popups_shown %u\n"
+                          "popup_latency_p50_us %lld\n"
+                          "popup_latency_p99_us %lld\n"
+                          "popup_latency_max_us %lld\n"
+                          "popup_latency_mean_us %lld\n"
+                          "popup_queued_mean_us %lld\n",
+                          stats.shown,
+                          popup_latency_percentile_us(&stats, 50),
+                          popup_latency_percentile_us(&stats, 99),
+                          stats.latency_max_us,
+                          stats.shown ? stats.latency_sum_us / stats.shown : 0,
+                          stats.shown ? stats.queued_sum_us / stats.shown : 0);
+    for (int i = 0; i < POPUP_LATENCY_BUCKETS && len < size; i++) {
+        if (i < POPUP_LATENCY_BUCKETS - 1) {
+            len += snprintf(reply + len, size - len, "popup_latency_le_us %lld %u\n",
+                            popup_latency_bounds_us[i], stats.buckets[i]);
+        } else {
+            len += snprintf(reply + len, size - len, "popup_latency_le_us inf %u\n", stats.buckets[i]);
+        }
+    }
+    if (len < size) {
+        len += snprintf(reply + len, size - len,
+                        "popup_backend %s\nrenderer_pid %d\nrenderer_starts %u\nrenderer_child_us %lld\nrenderer_ready_us %lld\n"
+                        "renderer_exits %u\nrenderer_crashes %u\nrenderer_hangs %u\n",
+                        popup_backend_name(stats.backend), stats.renderer_pid, stats.renderer_starts,
+                        stats.renderer_child_us, stats.renderer_ready_us,
+                        stats.renderer_exits, stats.renderer_crashes, stats.renderer_hangs);
+    }
+    if (len < size) {
+        int status = stats.renderer_last_status;
+        if (status < 0) {
+            snprintf(reply + len, size - len, "renderer_last_exit none\n");
+        } else if (WIFSIGNALED(status)) {
+            snprintf(reply + len, size - len, "renderer_last_exit signal %d\n", WTERMSIG(status));
+        } else {
+            snprintf(reply + len, size - len, "renderer_last_exit exit %d\n", WEXITSTATUS(status));
+        }
+        len = strlen(reply);
+    }
+    if (len < size) {
+        ActivityLogStats log_stats;
+        activity_log_get_stats(&log_stats);
+        snprintf(reply + len, size - len, "log_events_written %lu\nlog_events_dropped %lu\n"
+                 "log_days %u\nlog_bytes %llu\nlog_archived_days %u\nlog_archived_bytes %llu\n",
+                 log_stats.written, log_stats.dropped, log_stats.plain_days, log_stats.plain_bytes,
+                 log_stats.archived_days, log_stats.archived_bytes);
+        len = strlen(reply);
+        if (len < size && log_stats.db_enabled) {
+            snprintf(reply + len, size - len, "db_open %d\ndb_events_dropped %lu\n",
+                     log_stats.db_open, log_stats.db_dropped);
+        }
+    }
+}
+
+// Answer one request line; the reply block always ends with an empty line
+static void handle_request(Client *client, const char *line) {
+    char reply[REPLY_BUFFER_SIZE] = "";
+
+    if (strncmp(line, "complete", 8) == 0 && (line[8] == ' ' || line[8] == '\0')) {
+        reply_complete(line[8] ? line + 9 : "", reply, sizeof(reply) - 1);
+    } else if (strcmp(line, "stats") == 0) {
+        reply_stats(reply, sizeof(reply) - 1);
+    } else {
+        snprintf(reply, sizeof(reply), "error unknown request\n");
+    }
+
+    size_t len = strlen(reply);
+    reply[len++] = '\n';
+    // Replies are small; a client that cannot take one is dropped
+    if (send(client->fd, reply, len, MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t)len) {
+        close_client(client);
+    }
+}
+
+static void on_client_readable(int fd, short revents, void *data) {
+    (void)fd;
+    Client *client = data;
+
+    ssize_t n = recv(client->fd, client->buffer + client->used,
+                     sizeof(client->buffer) - 1 - client->used, MSG_DONTWAIT);
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR) && !(revents & (POLLHUP | POLLERR))) {
+            return;
+        }
+        close_client(client);
+        return;
+    }
+    client->used += n;
+    client->buffer[client->used] = '\0';
+
+    char *start = client->buffer;
+    char *newline;
+    while (client->fd >= 0 && (newline = strchr(start, '\n'))) {
+        *newline = '\0';
+        if (newline > start && newline[-1] == '\r') {
+            newline[-1] = '\0';
+        }
+        handle_request(client, start);
+        start = newline + 1;
+    }
+    if (client->fd < 0) {
+        return;
+    }
+
+    // Keep a partial line for the next read; a line longer than the buffer is dropped
+    client->used -= (size_t)(start - client->buffer);
+    memmove(client->buffer, start, client->used);
+    if (client->used >= sizeof(client->buffer) - 1) {
+        client->used = 0;
+    }
+}
+
+static void on_listen_readable(int fd, short revents, void *data) {
+    (void)revents;
+    (void)data;
+
+    int client_fd = accept(fd, NULL, NULL);
+    if (client_fd < 0) {
+        return;
+    }
+    fcntl(client_fd, F_SETFD, FD_CLOEXEC);
+
+    for (int i = 0; i < CONTROL_SOCKET_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            clients[i].fd = client_fd;
+            clients[i].used = 0;
+            if (event_loop_add(client_fd, POLLIN, on_client_readable, &clients[i])) {
+                return;
+            }
+            clients[i].fd = -1;
+            break;
+        }
+    }
+    close(client_fd);
+}
+
+bool control_socket_init(void) {
+    for (int i = 0; i < CONTROL_SOCKET_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+    }
+
+    const char *path = get_control_socket_path();
+    if (!path) {
+        return false;
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        fprintf(stderr, "Failed to create control socket: %s\n", strerror(errno));
+        return false;
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1); // both sized like sun_path
+
+    // A socket left behind by a crashed daemon would block bind
+    unlink(path);
+    mode_t old_mask = umask(0077);
+    int rc = bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old_mask);
+    if (rc < 0 || listen(listen_fd, CONTROL_SOCKET_MAX_CLIENTS) < 0
+        || !event_loop_add(listen_fd, POLLIN, on_listen_readable, NULL)) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void control_socket_close(void) {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(socket_path);
+    }
+}
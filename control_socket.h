@@ -0,0 +1,16 @@
+#ifndef CONTROL_SOCKET_H
+#define CONTROL_SOCKET_H
+
+#include <stdbool.h>
+
+// Local request socket at ~/.config/restly/restly.sock, served from the
+// event loop. Line protocol, one reply block per request ending in an empty line:
+//   complete <prefix>   ->  "<command>\t<count>" per suggestion
+#define CONTROL_SOCKET_MAX_CLIENTS 8
+
+bool control_socket_init(void);
+// Close and unlink the socket; only async-signal-safe calls, for shutdown
+void control_socket_close(void);
+const char *get_control_socket_path(void);
+
+#endif
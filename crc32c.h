@@ -0,0 +1,10 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC32C of len bytes, hardware-accelerated where the CPU allows
+uint32_t crc32c(const void* data, size_t len);
+
+#endif
@@ -6,15 +6,298 @@ Analyzes daily activity logs and prepares data for AI-powered insights.
 Can send data to an AI API for generating personalized daily summaries.
 """
 
+import gzip
+import io
 import json
 import os
+import shutil
+import sqlite3
+import struct
+import subprocess
 import sys
+import zlib
 from datetime import datetime, timedelta
 from pathlib import Path
-from typing import Dict, List, Any, Optional
+from typing import Dict, List, Any, Optional, Tuple
 import argparse
 
 
+# ActivityEventType in activity_log.h, in order; the sidecar index stores the number
+EVENT_TYPES = [
+    "break_shown", "break_completed", "session_started", "session_ended", "pause_toggled",
+    "break_rescheduled", "command_received", "app_started", "app_stopped", "command_corrected",
+    "popup_shown",
+]
+
+
+def _crc32c_table() -> List[int]:
+    table = []
+    for n in range(256):
+        for _ in range(8):
+            n = (n >> 1) ^ 0x82F63B78 if n & 1 else n >> 1
+        table.append(n)
+    return table
+
+
+_CRC32C_TABLE = _crc32c_table()
+# Last field of every JSONL line: the CRC32C of the line up to the comma before it
+_CRC_FIELD = b',"crc32c":"'
+_CRC_TAIL = len(_CRC_FIELD) + 8 + 2
+
+
+def crc32c(data: bytes) -> int:
+    crc = 0xFFFFFFFF
+    for byte in data:
+        crc = _CRC32C_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8)
+    return crc ^ 0xFFFFFFFF
+
+
+def json_line_ok(line: bytes) -> bool:
+    """True if a log line is whole: its crc32c matches, or it has none (older logs) and closes its object."""
+    line = line.rstrip(b"\n")
+    if not line.startswith(b"{") or not line.endswith(b"}") or b"\0" in line:
+        return False
+    if len(line) < _CRC_TAIL or line[-_CRC_TAIL:-_CRC_TAIL + len(_CRC_FIELD)] != _CRC_FIELD:
+        return True
+    try:
+        return line[-2:] == b'"}' and int(line[-10:-2], 16) == crc32c(line[:-_CRC_TAIL])
+    except ValueError:
+        return False
+
+
+class ActivityIndex:
+    """Sidecar index of one day's log, written by restly next to it.
+
+    activity_DATE.jsonl.idx (or .rlog.idx) holds one entry per record: byte
+    offset and length in the uncompressed log, event type, local hour and
+    timestamp. Counts, per-hour offsets and per-type offset lists come from
+    it without parsing the log.
+    """
+    HEADER = struct.Struct("<4sBBxx")
+    ENTRY = struct.Struct("<IHBBq")
+    VERSION = 1
+
+    def __init__(self, entries: List[Tuple[int, int, int, int, int]]):
+        self.entries = entries
+
+    @staticmethod
+    def path_for(log_file: Path) -> Optional[Path]:
+        """Where log_file's index would be, None if it cannot have one.
+
+        An archive shares its name's .idx with the plain file of the same
+        day; when both exist (events came in after archiving) the index is
+        the plain file's, and the archive has none.
+        """
+        if log_file.suffix == ".gz":
+            plain = log_file.with_suffix("")
+            if plain.exists():
+                return None
+        else:
+            plain = log_file
+        return plain.with_name(plain.name + ".idx")
+
+    @classmethod
+    def load(cls, log_file: Path) -> Optional["ActivityIndex"]:
+        """Index of log_file, or None if it is missing or does not cover the log."""
+        path = cls.path_for(log_file)
+        try:
+            data = path.read_bytes() if path else b""
+        except OSError:
+            return None
+        if len(data) < cls.HEADER.size:
+            return None
+        magic, version, _ = cls.HEADER.unpack_from(data)
+        if magic != b"RIDX" or version != cls.VERSION:
+            return None
+        body = data[cls.HEADER.size:]
+        body = body[:len(body) - len(body) % cls.ENTRY.size]
+        entries = list(cls.ENTRY.iter_unpack(body))
+        # Archived days keep their index only if it was whole; a plain log
+        # may have been written past it
+        if log_file.suffix != ".gz":
+            end = entries[-1][0] + entries[-1][1] if entries else 0
+            if end != log_file.stat().st_size:
+                return None
+        return cls(entries)
+
+    def select(self, event_type: Optional[str] = None, start: Optional[datetime] = None,
+               end: Optional[datetime] = None) -> List[Tuple[int, int, int, int, int]]:
+        """Entries of event_type (any if None) with start <= time < end."""
+        type_number = EVENT_TYPES.index(event_type) if event_type in EVENT_TYPES else None
+        if event_type is not None and type_number is None:
+            return []
+        low = start.timestamp() if start else float("-inf")
+        high = end.timestamp() if end else float("inf")
+        return [entry for entry in self.entries
+                if (type_number is None or entry[2] == type_number) and low <= entry[4] < high]
+
+    def count(self, event_type: Optional[str] = None, start: Optional[datetime] = None,
+              end: Optional[datetime] = None) -> int:
+        return len(self.select(event_type, start, end))
+
+    def offsets(self, event_type: Optional[str] = None, start: Optional[datetime] = None,
+                end: Optional[datetime] = None) -> List[int]:
+        return [entry[0] for entry in self.select(event_type, start, end)]
+
+    def type_counts(self) -> Dict[str, int]:
+        counts: Dict[str, int] = {}
+        for entry in self.entries:
+            name = EVENT_TYPES[entry[2]] if entry[2] < len(EVENT_TYPES) else "unknown"
+            counts[name] = counts.get(name, 0) + 1
+        return counts
+
+    def hour_offsets(self) -> Dict[int, int]:
+        """Byte offset of the first record of each local hour that has one."""
+        offsets: Dict[int, int] = {}
+        for entry in self.entries:
+            offsets.setdefault(entry[3], entry[0])
+        return offsets
+
+
+class ActivityRollup:
+    """Daily and weekly totals the daemon keeps in activity/rollup (see rollup.h).
+
+    The file is small and read whole; no log is parsed.
+    """
+    HEADER = struct.Struct("<4sBBBBI")
+    VERSION = 1
+    # RollupField in rollup.h, in order
+    FIELDS = [
+        "events", "breaks_shown", "breaks_completed", "eye_care_breaks", "custom_message_breaks",
+        "sessions", "deep_work_sessions", "pauses", "reschedules", "commands", "work_minutes",
+    ]
+
+    def __init__(self, weeks: List[Dict[str, Any]], days: Dict[str, Dict[str, Any]]):
+        self.weeks = weeks
+        self.days = days
+
+    @staticmethod
+    def _date(value: int) -> str:
+        return f"{value // 10000:04d}-{value // 100 % 100:02d}-{value % 100:02d}"
+
+    @classmethod
+    def load(cls, path: Path) -> Optional["ActivityRollup"]:
+        """The rollup at path, or None if it is missing or damaged."""
+        try:
+            data = path.read_bytes()
+        except OSError:
+            return None
+        if len(data) < cls.HEADER.size:
+            return None
+        magic, version, fields, days, weeks, crc = cls.HEADER.unpack_from(data)
+        if magic != b"RRUP" or version != cls.VERSION or fields != len(cls.FIELDS):
+            return None
+        week = struct.Struct(f"<{1 + fields}I")
+        day = struct.Struct(f"<{1 + fields + 24 * fields}I")
+        if len(data) != cls.HEADER.size + weeks * week.size + days * day.size:
+            return None
+        if zlib.crc32(data[cls.HEADER.size:]) != crc:
+            return None
+
+        offset = cls.HEADER.size
+        week_list = []
+        for _ in range(weeks):
+            values = week.unpack_from(data, offset)
+            offset += week.size
+            week_list.append({"week_of": cls._date(values[0]), **dict(zip(cls.FIELDS, values[1:]))})
+        day_map = {}
+        for _ in range(days):
+            values = day.unpack_from(data, offset)
+            offset += day.size
+            if values[0] == 0:
+                continue
+            hours = {}
+            for hour in range(24):
+                start = 1 + fields * (hour + 1)
+                counts = dict(zip(cls.FIELDS, values[start:start + fields]))
+                if counts["events"]:
+                    hours[hour] = counts
+            day_map[cls._date(values[0])] = {"totals": dict(zip(cls.FIELDS, values[1:1 + fields])),
+                                             "hours": hours}
+        return cls(week_list, day_map)
+
+    def day(self, date: datetime) -> Optional[Dict[str, Any]]:
+        """Totals and per-hour counts of a date, None if the rollup does not hold it."""
+        return self.days.get(date.strftime("%Y-%m-%d"))
+
+
+class ActivityDatabase:
+    """The SQLite copy of the log kept with restly --activity-db (see activity_db.h).
+
+    Answers the analyzer's questions with indexed queries instead of a scan
+    of the day's log. Hours are local.
+    """
+    def __init__(self, connection: sqlite3.Connection):
+        self.connection = connection
+
+    @classmethod
+    def open(cls, path: Path) -> Optional["ActivityDatabase"]:
+        """Read-only connection to the database, None if there is none."""
+        if not path.exists():
+            return None
+        try:
+            connection = sqlite3.connect(f"file:{path}?mode=ro", uri=True)
+            connection.execute("SELECT 1 FROM events LIMIT 1")
+        except sqlite3.Error:
+            return None
+        return cls(connection)
+
+    @staticmethod
+    def _day_range(date: datetime) -> Tuple[float, float]:
+        start = date.replace(hour=0, minute=0, second=0, microsecond=0)
+        return start.timestamp(), (start + timedelta(days=1)).timestamp()
+
+    def event_count(self, date: datetime) -> int:
+        return self.connection.execute(
+            "SELECT count(*) FROM events WHERE timestamp >= ? AND timestamp < ?",
+            self._day_range(date)).fetchone()[0]
+
+    def day_counts(self, date: datetime) -> Dict[str, Any]:
+        """What analyze_daily_patterns() counts for a date, as _finish_analysis() takes it."""
+        day = self._day_range(date)
+        query = self.connection.execute
+        types = dict(query("SELECT event_type, count(*) FROM events"
+                           " WHERE timestamp >= ? AND timestamp < ? GROUP BY event_type", day).fetchall())
+        hourly = dict(query("SELECT hour, count(*) FROM events"
+                            " WHERE timestamp >= ? AND timestamp < ? GROUP BY hour", day).fetchall())
+        break_types = {"eye_care": 0, "custom_message": 0}
+        for break_type, count in query("SELECT json_extract(event_data, '$.break_type'), count(*) FROM events"
+                                       " WHERE event_type = 'break_shown' AND timestamp >= ? AND timestamp < ?"
+                                       " GROUP BY 1", day):
+            if break_type in break_types:
+                break_types[break_type] = count
+        deep_work = query("SELECT count(*) FROM events WHERE event_type = 'session_started'"
+                          " AND timestamp >= ? AND timestamp < ?"
+                          " AND json_extract(event_data, '$.session_type') = 'deep_work'", day).fetchone()[0]
+        # Work time from the last event logged that day, as in the log
+        last = query("SELECT total_work_minutes_today FROM events WHERE id ="
+                     " (SELECT max(id) FROM events WHERE timestamp >= ? AND timestamp < ?)", day).fetchone()
+        corrections = {f"{typo} -> {correction}": count for typo, correction, count in query(
+            "SELECT json_extract(event_data, '$.typo'), json_extract(event_data, '$.correction'), count(*)"
+            " FROM events WHERE event_type = 'command_corrected' AND timestamp >= ? AND timestamp < ?"
+            " GROUP BY 1, 2", day)}
+        return {
+            "total_breaks": types.get("break_shown", 0),
+            "breaks_completed": types.get("break_completed", 0),
+            "total_work_minutes": last[0] if last else 0,
+            "deep_work_sessions": deep_work,
+            "commands_used": types.get("command_received", 0),
+            "pause_events": types.get("pause_toggled", 0),
+            "break_types": break_types,
+            "hourly_activity": hourly,
+            "reschedule_count": types.get("break_rescheduled", 0),
+            "command_corrections": corrections,
+        }
+
+    def breaks_by_day(self, start: datetime, end: datetime) -> Dict[str, Tuple[int, int]]:
+        """(shown, completed) breaks per local day in [start, end), days without any left out."""
+        rows = self.connection.execute(
+            "SELECT day, sum(event_type = 'break_shown'), sum(event_type = 'break_completed') FROM events"
+            " WHERE event_type IN ('break_shown', 'break_completed') AND timestamp >= ? AND timestamp < ?"
+            " GROUP BY day", (start.timestamp(), end.timestamp()))
+        return {day: (shown, completed) for day, shown, completed in rows}
+
+
 class ActivityAnalyzer:
     def __init__(self, config_dir: Optional[str] = None):
         if config_dir is None:
@@ -30,29 +313,217 @@ class ActivityAnalyzer:
         date_str = date.strftime("%Y-%m-%d")
         return self.activity_dir / f"activity_{date_str}.jsonl"
     
-    def load_daily_activities(self, date: datetime) -> List[Dict[str, Any]]:
-        """Load all activities for a specific date."""
+    def get_log_file_paths(self, date: datetime) -> List[Path]:
+        """Get the existing log files for a date, oldest records first.
+
+        Restly gzips the logs of past days; a day can briefly have both the
+        archive and a plain file with events that came in after it. Days
+        logged with --log-format binary are .rlog files.
+        """
         log_file = self.get_log_file_path(date)
+        binary = log_file.with_suffix(".rlog")
+        candidates = []
+        for path in (binary, log_file):
+            candidates += [path.with_name(path.name + ".gz"), path]
+        return [path for path in candidates if path.exists()]
+    
+    def _open_log(self, log_file: Path):
+        """Text stream of JSON lines from a plain, gzipped or binary log."""
+        if ".rlog" in log_file.suffixes:
+            # Binary logs are converted by the daemon's reader
+            tool = shutil.which("restly-log") or str(Path(__file__).resolve().parent / "restly-log")
+            result = subprocess.run([tool, "cat", "--json", str(log_file)],
+                                    capture_output=True, text=True, check=False)
+            if result.returncode != 0:
+                print(f"Warning: {log_file}: {result.stderr.strip()}", file=sys.stderr)
+            return io.StringIO(result.stdout)
+        opener = gzip.open if log_file.suffix == ".gz" else open
+        return opener(log_file, 'rt', encoding='utf-8')
+    
+    def read_log(self, log_file: Path) -> List[Dict[str, Any]]:
+        """All activities of one log file."""
         activities = []
-        
-        if not log_file.exists():
-            return activities
-        
         try:
-            with open(log_file, 'r', encoding='utf-8') as f:
+            with self._open_log(log_file) as f:
                 for line in f:
                     line = line.strip()
                     if line:
+                        if not json_line_ok(line.encode('utf-8')):
+                            print(f"Warning: Skipping damaged line in {log_file}", file=sys.stderr)
+                            continue
                         try:
                             activity = json.loads(line)
                             activities.append(activity)
                         except json.JSONDecodeError as e:
                             print(f"Warning: Skipping malformed JSON line: {e}", file=sys.stderr)
-        except IOError as e:
+        except (OSError, EOFError) as e:
             print(f"Error reading log file {log_file}: {e}", file=sys.stderr)
-        
         return activities
     
+    def load_daily_activities(self, date: datetime) -> List[Dict[str, Any]]:
+        """Load all activities for a specific date."""
+        activities = []
+        for log_file in self.get_log_file_paths(date):
+            activities += self.read_log(log_file)
+        return activities
+    
+    def load_daily_indexes(self, date: datetime) -> List[Tuple[Path, Optional[ActivityIndex]]]:
+        """Every log file of a date with its sidecar index, None where it has no usable one."""
+        return [(log_file, ActivityIndex.load(log_file)) for log_file in self.get_log_file_paths(date)]
+    
+    def count_events(self, date: datetime, event_type: Optional[str] = None,
+                     start: Optional[datetime] = None, end: Optional[datetime] = None) -> Dict[str, Any]:
+        """Count events of a type (any if None) in [start, end) local time on a date.
+
+        Answered from the sidecar index of each log file that has one that
+        covers it; the others are parsed.
+        """
+        low = start.timestamp() if start else float("-inf")
+        high = end.timestamp() if end else float("inf")
+        count = 0
+        sources = set()
+        for log_file, index in self.load_daily_indexes(date):
+            if index is not None:
+                count += index.count(event_type, start, end)
+                sources.add("index")
+                continue
+            sources.add("log")
+            for activity in self.read_log(log_file):
+                if event_type is not None and activity.get("event_type") != event_type:
+                    continue
+                try:
+                    when = datetime.fromisoformat(activity.get("timestamp", "").replace('Z', '+00:00')).timestamp()
+                except (ValueError, AttributeError):
+                    continue
+                if low <= when < high:
+                    count += 1
+        return {"count": count, "source": "+".join(sorted(sources)) or "index"}
+    
+    def load_events_at(self, log_file: Path, offsets: List[int]) -> List[Dict[str, Any]]:
+        """Events at index offsets of a plain JSONL log, read without the rest."""
+        events = []
+        with open(log_file, 'rb') as f:
+            for offset in offsets:
+                f.seek(offset)
+                line = f.readline()
+                if not json_line_ok(line):
+                    continue
+                try:
+                    events.append(json.loads(line))
+                except json.JSONDecodeError:
+                    continue
+        return events
+    
+    def load_rollup(self) -> Optional[ActivityRollup]:
+        return ActivityRollup.load(self.activity_dir / "rollup")
+    
+    def _indexed_records(self, date: datetime) -> Optional[int]:
+        """Records of a date by its index file sizes, None without indexes.
+
+        A log file that cannot have its own index (an archive next to a
+        plain file of the same day) has its records counted by reading it.
+        """
+        total = 0
+        for log_file in self.get_log_file_paths(date):
+            path = ActivityIndex.path_for(log_file)
+            if path is None:
+                total += len(self.read_log(log_file))
+                continue
+            try:
+                size = path.stat().st_size
+            except OSError:
+                return None
+            total += (size - ActivityIndex.HEADER.size) // ActivityIndex.ENTRY.size
+        return total
+    
+    def analyze_rollup_day(self, date: datetime) -> Optional[Dict[str, Any]]:
+        """analyze_daily_patterns() of a date from the rollup, without reading its logs.
+
+        None if the rollup does not hold the date or has not seen all of its
+        events (it started mid-day, or an event was counted but not written),
+        going by the record count in the day's indexes. Command corrections
+        are not rolled up. Hours are local.
+        """
+        rollup = self.load_rollup()
+        day = rollup.day(date) if rollup else None
+        if day is None or self._indexed_records(date) != day["totals"]["events"]:
+            return None
+        totals = day["totals"]
+        return self._finish_analysis({
+            "total_breaks": totals["breaks_shown"],
+            "breaks_completed": totals["breaks_completed"],
+            "total_work_minutes": totals["work_minutes"],
+            "deep_work_sessions": totals["deep_work_sessions"],
+            "commands_used": totals["commands"],
+            "pause_events": totals["pauses"],
+            "break_types": {"eye_care": totals["eye_care_breaks"],
+                            "custom_message": totals["custom_message_breaks"]},
+            "hourly_activity": {hour: counts["events"] for hour, counts in day["hours"].items()},
+            "reschedule_count": totals["reschedules"],
+            "command_corrections": {},
+        })
+    
+    def load_database(self) -> Optional[ActivityDatabase]:
+        return ActivityDatabase.open(self.activity_dir / "activity.db")
+    
+    def analyze_db_day(self, date: datetime) -> Optional[Dict[str, Any]]:
+        """analyze_daily_patterns() of a date by SQL on the activity database.
+
+        None without a database, or if it does not hold all of the day's
+        events (it was enabled later), going by the day's indexes.
+        """
+        database = self.load_database()
+        if database is None or database.event_count(date) != self._indexed_records(date):
+            return None
+        return self._finish_analysis(database.day_counts(date))
+    
+    def get_compliance_by_day(self, end: datetime, days: int) -> List[Dict[str, Any]]:
+        """Break compliance for each of days days up to end, newest first.
+
+        One query on the activity database for the days it fully holds; the
+        rest are parsed from their logs.
+        """
+        last_day = end.replace(hour=0, minute=0, second=0, microsecond=0)
+        first_day = last_day - timedelta(days=days - 1)
+        database = self.load_database()
+        from_db = database.breaks_by_day(first_day, last_day + timedelta(days=1)) if database else {}
+        
+        result = []
+        for i in range(days):
+            date = last_day - timedelta(days=i)
+            if database and database.event_count(date) == self._indexed_records(date):
+                shown, completed = from_db.get(date.strftime("%Y-%m-%d"), (0, 0))
+                source = "database"
+            else:
+                analysis = self.analyze_daily_patterns(self.load_daily_activities(date))
+                shown, completed = analysis["total_breaks"], analysis.get("breaks_completed", 0)
+                source = "log"
+            result.append({
+                "date": date.strftime("%Y-%m-%d"),
+                "breaks_shown": shown,
+                "breaks_completed": completed,
+                "break_compliance": round(completed / shown * 100, 1) if shown else 0.0,
+                "source": source,
+            })
+        return result
+    
+    def get_weekly_totals(self) -> List[Dict[str, Any]]:
+        """This week's and the previous weeks' totals from the rollup, newest first."""
+        rollup = self.load_rollup()
+        return rollup.weeks if rollup else []
+    
+    def get_disk_usage(self) -> Dict[str, Any]:
+        """Days and bytes in plain and in archived (gzipped) activity logs."""
+        usage = {"plain_days": 0, "plain_bytes": 0, "archived_days": 0, "archived_bytes": 0}
+        for log_file in self.activity_dir.glob("activity_*"):
+            if log_file.suffix not in (".gz", ".jsonl", ".rlog"):
+                continue
+            kind = "archived" if log_file.suffix == ".gz" else "plain"
+            usage[f"{kind}_days"] += 1
+            usage[f"{kind}_bytes"] += log_file.stat().st_size
+        usage["total_bytes"] = usage["plain_bytes"] + usage["archived_bytes"]
+        return usage
+    
     def analyze_daily_patterns(self, activities: List[Dict[str, Any]]) -> Dict[str, Any]:
         """Analyze daily activity patterns and extract insights."""
         if not activities:
@@ -65,6 +536,7 @@ class ActivityAnalyzer:
                 "pause_events": 0,
                 "break_types": {},
                 "hourly_activity": {},
+                "command_corrections": {},
                 "insights": []
             }
         
@@ -77,6 +549,7 @@ class ActivityAnalyzer:
         break_types = {"eye_care": 0, "custom_message": 0}
         hourly_activity = {}
         reschedule_count = 0
+        command_corrections = {}
         
         # Get work time from final system state
         final_work_minutes = 0
@@ -121,6 +594,33 @@ class ActivityAnalyzer:
             
             elif event_type == "break_rescheduled":
                 reschedule_count += 1
+            
+            elif event_type == "command_corrected":
+                key = f"{event_data.get('typo', '')} -> {event_data.get('correction', '')}"
+                command_corrections[key] = command_corrections.get(key, 0) + 1
+        
+        return self._finish_analysis({
+            "total_breaks": break_count,
+            "breaks_completed": break_completed_count,
+            "total_work_minutes": final_work_minutes,
+            "deep_work_sessions": deep_work_sessions,
+            "commands_used": commands_used,
+            "pause_events": pause_events,
+            "break_types": break_types,
+            "hourly_activity": hourly_activity,
+            "reschedule_count": reschedule_count,
+            "command_corrections": command_corrections,
+        })
+    
+    def _finish_analysis(self, counts: Dict[str, Any]) -> Dict[str, Any]:
+        """Add break compliance and insights to a day's counts."""
+        break_count = counts["total_breaks"]
+        break_completed_count = counts["breaks_completed"]
+        deep_work_sessions = counts["deep_work_sessions"]
+        reschedule_count = counts["reschedule_count"]
+        pause_events = counts["pause_events"]
+        commands_used = counts["commands_used"]
+        hourly_activity = counts["hourly_activity"]
         
         # Calculate break compliance rate
         break_compliance = (break_completed_count / break_count * 100) if break_count > 0 else 0
@@ -154,14 +654,15 @@ class ActivityAnalyzer:
         return {
             "total_breaks": break_count,
             "breaks_completed": break_completed_count,
-            "total_work_minutes": final_work_minutes,
+            "total_work_minutes": counts["total_work_minutes"],
             "break_compliance": round(break_compliance, 1),
             "deep_work_sessions": deep_work_sessions,
             "commands_used": commands_used,
             "pause_events": pause_events,
-            "break_types": break_types,
+            "break_types": counts["break_types"],
             "hourly_activity": hourly_activity,
             "reschedule_count": reschedule_count,
+            "command_corrections": counts["command_corrections"],
             "insights": insights
         }
     
@@ -248,9 +749,27 @@ def main():
     parser.add_argument("--config-dir", "-c", type=str, help="Custom config directory path")
     parser.add_argument("--days", "-n", type=int, default=1, 
                        help="Number of days to analyze (starting from specified date)")
+    parser.add_argument("--disk-usage", action="store_true",
+                       help="Report the disk space taken by activity logs and exit")
+    parser.add_argument("--count", type=str, metavar="EVENT_TYPE",
+                       help="Count events of a type ('all' for any) on the date and exit")
+    parser.add_argument("--weekly", action="store_true",
+                       help="Print weekly totals from the daemon's rollup and exit")
+    parser.add_argument("--compliance", action="store_true",
+                       help="Print break compliance per day for --days days up to the date and exit")
+    parser.add_argument("--between", type=str, metavar="HH:MM-HH:MM",
+                       help="With --count, only count events in this local time range")
     
     args = parser.parse_args()
     
+    if args.disk_usage:
+        print(json.dumps(ActivityAnalyzer(args.config_dir).get_disk_usage(), indent=2))
+        return 0
+    
+    if args.weekly:
+        print(json.dumps(ActivityAnalyzer(args.config_dir).get_weekly_totals(), indent=2))
+        return 0
+    
     # Parse date
     if args.date:
         try:
@@ -264,6 +783,28 @@ def main():
     # Initialize analyzer
     analyzer = ActivityAnalyzer(args.config_dir)
     
+    if args.compliance:
+        print(json.dumps(analyzer.get_compliance_by_day(target_date, max(1, args.days)), indent=2))
+        return 0
+    
+    if args.count:
+        start = end = None
+        if args.between:
+            try:
+                start_str, end_str = args.between.split("-")
+                start = datetime.combine(target_date.date(), datetime.strptime(start_str, "%H:%M").time())
+                end = datetime.combine(target_date.date(), datetime.strptime(end_str, "%H:%M").time())
+            except ValueError:
+                print("Error: Invalid time range. Use HH:MM-HH:MM", file=sys.stderr)
+                return 1
+        event_type = None if args.count == "all" else args.count
+        result = analyzer.count_events(target_date, event_type, start, end)
+        result.update({"date": target_date.strftime("%Y-%m-%d"), "event_type": args.count})
+        if args.between:
+            result["between"] = args.between
+        print(json.dumps(result, indent=2))
+        return 0
+    
     # Generate summaries for requested number of days
     summaries = []
     for i in range(args.days):
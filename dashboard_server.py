@@ -46,9 +46,14 @@ class RestlyDashboard:
         if date is None:
             date = datetime.now()
         
-        # Get activity data
-        activities = self.activity_analyzer.load_daily_activities(date)
-        analysis = self.activity_analyzer.analyze_daily_patterns(activities)
+        # Get activity data: the daemon's rollup or database if either covers
+        # the day, else the logs
+        analysis = self.activity_analyzer.analyze_rollup_day(date)
+        if analysis is None:
+            analysis = self.activity_analyzer.analyze_db_day(date)
+        if analysis is None:
+            activities = self.activity_analyzer.load_daily_activities(date)
+            analysis = self.activity_analyzer.analyze_daily_patterns(activities)
         
         # Calculate circular ring metrics (Apple Watch style)
         work_minutes = analysis.get("total_work_minutes", 0)
@@ -133,6 +138,7 @@ class RestlyDashboard:
                 }
             },
             "hourly_activity": hourly_data,
+            "weekly": self.activity_analyzer.get_weekly_totals(),
             "insights": analysis.get("insights", []),
             "ai_summary": ai_summary,
             "break_types": analysis.get("break_types", {}),
@@ -164,6 +170,32 @@ class RestlyDashboard:
         data = await self.get_dashboard_data(date)
         return Response(text=json.dumps(data, indent=2), content_type='application/json')
     
+    async def api_count_handler(self, request: Request) -> Response:
+        """API endpoint counting events, e.g. /api/count?type=break_completed&from=09:00&to=12:00."""
+        date_str = request.query.get('date')
+        if date_str:
+            try:
+                date = datetime.strptime(date_str, "%Y-%m-%d")
+            except ValueError:
+                date = datetime.now()
+        else:
+            date = datetime.now()
+        
+        try:
+            start = end = None
+            if 'from' in request.query:
+                start = datetime.combine(date.date(), datetime.strptime(request.query['from'], "%H:%M").time())
+            if 'to' in request.query:
+                end = datetime.combine(date.date(), datetime.strptime(request.query['to'], "%H:%M").time())
+        except ValueError:
+            return Response(text=json.dumps({"error": "from and to must be HH:MM"}),
+                            status=400, content_type='application/json')
+        
+        event_type = request.query.get('type')
+        result = self.activity_analyzer.count_events(date, event_type, start, end)
+        result.update({"date": date.strftime("%Y-%m-%d"), "event_type": event_type or "all"})
+        return Response(text=json.dumps(result), content_type='application/json')
+    
     async def api_summary_handler(self, request: Request) -> Response:
         """API endpoint for AI summary."""
         date_str = request.query.get('date')
@@ -631,6 +663,7 @@ class RestlyDashboard:
         self.app.router.add_get('/', self.dashboard_handler)
         self.app.router.add_get('/api/data', self.api_data_handler)
         self.app.router.add_get('/api/summary', self.api_summary_handler)
+        self.app.router.add_get('/api/count', self.api_count_handler)
         
         # Add CORS to all routes
         for route in list(self.app.router.routes()):
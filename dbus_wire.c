@@ -0,0 +1,528 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "dbus_wire.h"
+
+#define DBUS_HEADER_SIZE 16
+
+enum {
+    FIELD_PATH = 1,
+    FIELD_INTERFACE,
+    FIELD_MEMBER,
+    FIELD_ERROR_NAME,
+    FIELD_REPLY_SERIAL,
+    FIELD_DESTINATION,
+    FIELD_SENDER,
+    FIELD_SIGNATURE
+};
+
+// Writing: always little-endian, alignment is relative to the message start
+
+static void store_u32(uint8_t *p, uint32_t value) {
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = value >> 24;
+}
+
+static bool reserve(DBusWriter *w, size_t n) {
+    if (w->overflow || w->len + n > sizeof(w->data)) {
+        w->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+static void pad(DBusWriter *w, size_t alignment) {
+    while (w->len % alignment) {
+        if (!reserve(w, 1)) return;
+        w->data[w->len++] = 0;
+    }
+}
+
+void dbus_put_byte(DBusWriter *w, uint8_t value) {
+    if (reserve(w, 1)) {
+        w->data[w->len++] = value;
+    }
+}
+
+void dbus_put_u32(DBusWriter *w, uint32_t value) {
+    pad(w, 4);
+    if (reserve(w, 4)) {
+        store_u32(w->data + w->len, value);
+        w->len += 4;
+    }
+}
+
+void dbus_put_i32(DBusWriter *w, int32_t value) {
+    dbus_put_u32(w, (uint32_t)value);
+}
+
+void dbus_put_bool(DBusWriter *w, bool value) {
+    dbus_put_u32(w, value ? 1 : 0);
+}
+
+// Length of the valid UTF-8 sequence at s, 0 if it is not one
+static size_t utf8_sequence(const unsigned char *s) {
+    unsigned char c = s[0];
+    if (c < 0x80) return 1;
+    if (c >= 0xc2 && c <= 0xdf) return (s[1] & 0xc0) == 0x80 ? 2 : 0;
+    if (c >= 0xe0 && c <= 0xef) {
+        unsigned char lo = c == 0xe0 ? 0xa0 : 0x80, hi = c == 0xed ? 0x9f : 0xbf;
+        return s[1] >= lo && s[1] <= hi && (s[2] & 0xc0) == 0x80 ? 3 : 0;
+    }
+    if (c >= 0xf0 && c <= 0xf4) {
+        unsigned char lo = c == 0xf0 ? 0x90 : 0x80, hi = c == 0xf4 ? 0x8f : 0xbf;
+        return s[1] >= lo && s[1] <= hi && (s[2] & 0xc0) == 0x80 && (s[3] & 0xc0) == 0x80 ? 4 : 0;
+    }
+    return 0;
+}
+
+void dbus_put_string(DBusWriter *w, const char *value) {
+    dbus_put_u32(w, 0);
+    size_t length_at = w->len - 4;
+    const unsigned char *s = (const unsigned char *)value;
+    while (*s && !w->overflow) {
+        size_t n = utf8_sequence(s);
+        if (n == 0) {
+            dbus_put_byte(w, '?');
+            s++;
+        } else if (reserve(w, n)) {
+            memcpy(w->data + w->len, s, n);
+            w->len += n;
+            s += n;
+        }
+    }
+    dbus_put_byte(w, 0);
+    if (!w->overflow) {
+        store_u32(w->data + length_at, (uint32_t)(w->len - length_at - 5));
+    }
+}
+
+void dbus_put_signature(DBusWriter *w, const char *value) {
+    size_t len = strlen(value);
+    if (len > 255 || !reserve(w, len + 2)) {
+        w->overflow = true;
+        return;
+    }
+    w->data[w->len++] = (uint8_t)len;
+    memcpy(w->data + w->len, value, len + 1);
+    w->len += len + 1;
+}
+
+DBusArray dbus_open_array(DBusWriter *w, int element_alignment) {
+    DBusArray array;
+    dbus_put_u32(w, 0);
+    array.length_at = w->len - 4;
+    // Padding to the first element does not count towards the length
+    pad(w, element_alignment);
+    array.start = w->len;
+    return array;
+}
+
+void dbus_close_array(DBusWriter *w, DBusArray array) {
+    if (!w->overflow) {
+        store_u32(w->data + array.length_at, (uint32_t)(w->len - array.start));
+    }
+}
+
+void dbus_open_struct(DBusWriter *w) {
+    pad(w, 8);
+}
+
+static void put_field(DBusWriter *w, uint8_t code, const char *signature, const char *value) {
+    if (!value) return;
+    dbus_open_struct(w);
+    dbus_put_byte(w, code);
+    dbus_put_signature(w, signature);
+    if (signature[0] == 'g') {
+        dbus_put_signature(w, value);
+    } else {
+        dbus_put_string(w, value);
+    }
+}
+
+void dbus_writer_begin(DBusWriter *w, const DBusHeader *header) {
+    w->len = 0;
+    w->overflow = false;
+    dbus_put_byte(w, 'l');
+    dbus_put_byte(w, (uint8_t)header->type);
+    dbus_put_byte(w, 0);
+    dbus_put_byte(w, 1);
+    dbus_put_u32(w, 0);     // body length, set by dbus_wire_send
+    dbus_put_u32(w, 0);     // serial, likewise
+
+    DBusArray fields = dbus_open_array(w, 8);
+    put_field(w, FIELD_PATH, "o", header->path);
+    put_field(w, FIELD_INTERFACE, "s", header->interface);
+    put_field(w, FIELD_MEMBER, "s", header->member);
+    put_field(w, FIELD_ERROR_NAME, "s", header->error_name);
+    if (header->reply_serial) {
+        dbus_open_struct(w);
+        dbus_put_byte(w, FIELD_REPLY_SERIAL);
+        dbus_put_signature(w, "u");
+        dbus_put_u32(w, header->reply_serial);
+    }
+    put_field(w, FIELD_DESTINATION, "s", header->destination);
+    put_field(w, FIELD_SIGNATURE, "g", header->signature);
+    dbus_close_array(w, fields);
+
+    pad(w, 8);
+    w->body_start = w->len;
+}
+
+// Reading: either byte order, every access bounds-checked
+
+static uint32_t load_u32(const uint8_t *p, bool swap) {
+    if (swap) {
+        return (uint32_t)p[3] | (uint32_t)p[2] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[0] << 24;
+    }
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void dbus_reader_init(DBusReader *r, const DBusMessage *message) {
+    r->data = message->body;
+    r->len = message->body_len;
+    r->pos = 0;
+    r->swap = message->swap;
+    r->error = false;
+}
+
+uint32_t dbus_read_u32(DBusReader *r) {
+    r->pos = (r->pos + 3) & ~(size_t)3;
+    if (r->error || r->pos + 4 > r->len) {
+        r->error = true;
+        return 0;
+    }
+    uint32_t value = load_u32(r->data + r->pos, r->swap);
+    r->pos += 4;
+    return value;
+}
+
+bool dbus_read_bool(DBusReader *r) {
+    return dbus_read_u32(r) != 0;
+}
+
+const char *dbus_read_string(DBusReader *r) {
+    uint32_t len = dbus_read_u32(r);
+    if (r->error || len >= r->len - r->pos || r->data[r->pos + len] != '\0') {
+        r->error = true;
+        return "";
+    }
+    const char *value = (const char *)r->data + r->pos;
+    r->pos += len + 1;
+    return value;
+}
+
+// Header fields of a complete message in buf; false if malformed
+static bool parse_header(const uint8_t *buf, size_t fields_end, DBusMessage *m) {
+    size_t pos = DBUS_HEADER_SIZE;
+    while (pos < fields_end) {
+        pos = (pos + 7) & ~(size_t)7;
+        if (pos + 3 > fields_end) return false;
+        uint8_t code = buf[pos++];
+        uint8_t signature_len = buf[pos++];
+        if (signature_len != 1 || pos + 2 > fields_end) return false;
+        char type = (char)buf[pos];
+        pos += 2;
+
+        const char *string = NULL;
+        uint32_t number = 0;
+        if (type == 'o' || type == 's') {
+            pos = (pos + 3) & ~(size_t)3;
+            if (pos + 4 > fields_end) return false;
+            uint32_t len = load_u32(buf + pos, m->swap);
+            pos += 4;
+            if (len >= fields_end - pos || buf[pos + len] != '\0') return false;
+            string = (const char *)buf + pos;
+            pos += len + 1;
+        } else if (type == 'g') {
+            uint8_t len = buf[pos++];
+            if (pos + len >= fields_end || buf[pos + len] != '\0') return false;
+            string = (const char *)buf + pos;
+            pos += len + 1;
+        } else if (type == 'u') {
+            pos = (pos + 3) & ~(size_t)3;
+            if (pos + 4 > fields_end) return false;
+            number = load_u32(buf + pos, m->swap);
+            pos += 4;
+        } else {
+            return false;
+        }
+
+        switch (code) {
+            case FIELD_PATH: m->path = string; break;
+            case FIELD_INTERFACE: m->interface = string; break;
+            case FIELD_MEMBER: m->member = string; break;
+            case FIELD_ERROR_NAME: m->error_name = string; break;
+            case FIELD_REPLY_SERIAL: m->reply_serial = number; break;
+            case FIELD_SENDER: m->sender = string; break;
+            case FIELD_SIGNATURE: m->signature = string; break;
+            default: break;
+        }
+    }
+    return true;
+}
+
+bool dbus_wire_next(DBusConnection *conn, DBusMessage *message) {
+    if (conn->consumed) {
+        memmove(conn->buffer, conn->buffer + conn->consumed, conn->used - conn->consumed);
+        conn->used -= conn->consumed;
+        conn->consumed = 0;
+    }
+    if (conn->fd < 0 || conn->used < DBUS_HEADER_SIZE) {
+        return false;
+    }
+
+    const uint8_t *buf = conn->buffer;
+    memset(message, 0, sizeof(*message));
+    if (buf[0] != 'l' && buf[0] != 'B') {
+        dbus_wire_close(conn);
+        return false;
+    }
+    message->swap = buf[0] == 'B';
+    size_t body_len = load_u32(buf + 4, message->swap);
+    size_t fields_end = DBUS_HEADER_SIZE + (size_t)load_u32(buf + 12, message->swap);
+    size_t body_start = (fields_end + 7) & ~(size_t)7;
+    if (body_start + body_len > sizeof(conn->buffer)) {
+        // Bigger than anything we ask for; the stream cannot be resynced
+        dbus_wire_close(conn);
+        return false;
+    }
+    if (conn->used < body_start + body_len) {
+        return false;
+    }
+
+    message->type = (DBusMessageType)buf[1];
+    message->serial = load_u32(buf + 8, message->swap);
+    if (!parse_header(buf, fields_end, message)) {
+        dbus_wire_close(conn);
+        return false;
+    }
+    message->body = buf + body_start;
+    message->body_len = body_len;
+    conn->consumed = body_start + body_len;
+    return true;
+}
+
+bool dbus_wire_receive(DBusConnection *conn) {
+    if (conn->fd < 0) {
+        return false;
+    }
+    if (conn->used == sizeof(conn->buffer)) {
+        return true;    // dbus_wire_next has to make room first
+    }
+    ssize_t n = recv(conn->fd, conn->buffer + conn->used, sizeof(conn->buffer) - conn->used, MSG_DONTWAIT);
+    if (n > 0) {
+        conn->used += n;
+        return true;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return true;
+    }
+    dbus_wire_close(conn);
+    return false;
+}
+
+uint32_t dbus_wire_send(DBusConnection *conn, DBusWriter *w) {
+    if (conn->fd < 0 || w->overflow) {
+        return 0;
+    }
+    uint32_t serial = ++conn->last_serial;
+    if (serial == 0) {
+        serial = ++conn->last_serial;
+    }
+    store_u32(w->data + 4, (uint32_t)(w->len - w->body_start));
+    store_u32(w->data + 8, serial);
+
+    // Messages are far smaller than the socket buffer; a short write means
+    // the bus stopped reading, which we treat as a lost connection
+    if (send(conn->fd, w->data, w->len, MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t)w->len) {
+        dbus_wire_close(conn);
+        return 0;
+    }
+    return serial;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool wait_readable(int fd, long long deadline) {
+    long long left = deadline - now_ms();
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    return left > 0 && poll(&pfd, 1, (int)left) > 0;
+}
+
+bool dbus_wire_call(DBusConnection *conn, DBusWriter *w, DBusMessage *reply, int timeout_ms) {
+    uint32_t serial = dbus_wire_send(conn, w);
+    if (!serial) {
+        return false;
+    }
+    long long deadline = now_ms() + timeout_ms;
+    for (;;) {
+        while (dbus_wire_next(conn, reply)) {
+            if ((reply->type == DBUS_MESSAGE_METHOD_RETURN || reply->type == DBUS_MESSAGE_ERROR)
+                && reply->reply_serial == serial) {
+                return reply->type == DBUS_MESSAGE_METHOD_RETURN;
+            }
+        }
+        if (!wait_readable(conn->fd, deadline) || !dbus_wire_receive(conn)) {
+            return false;
+        }
+    }
+}
+
+// One "unix:path=..." or "unix:abstract=..." address, %-escapes decoded
+static int connect_address(const char *address, size_t len) {
+    if (len < 5 || strncmp(address, "unix:", 5) != 0) {
+        return -1;
+    }
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    size_t path_len = 0;
+    bool abstract = false;
+    bool found = false;
+
+    const char *p = address + 5, *end = address + len;
+    while (p < end && !found) {
+        const char *comma = memchr(p, ',', end - p);
+        const char *stop = comma ? comma : end;
+        if (stop - p > 5 && strncmp(p, "path=", 5) == 0) {
+            p += 5;
+            found = true;
+        } else if (stop - p > 9 && strncmp(p, "abstract=", 9) == 0) {
+            p += 9;
+            abstract = found = true;
+        } else {
+            p = stop + 1;
+            continue;
+        }
+        // Abstract names start with a NUL, paths end with one
+        char *out = addr.sun_path + (abstract ? 1 : 0);
+        size_t room = sizeof(addr.sun_path) - 1;
+        while (p < stop && path_len < room) {
+            if (*p == '%' && stop - p >= 3) {
+                char hex[3] = { p[1], p[2], 0 };
+                out[path_len++] = (char)strtol(hex, NULL, 16);
+                p += 3;
+            } else {
+                out[path_len++] = *p++;
+            }
+        }
+    }
+    if (!found || path_len == 0) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    socklen_t addr_len = offsetof(struct sockaddr_un, sun_path) + path_len + (abstract ? 1 : 0);
+    if (connect(fd, (struct sockaddr *)&addr, addr_len) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// "\0AUTH EXTERNAL <hex uid>" then BEGIN; the server answers with one line
+static bool authenticate(int fd, long long deadline) {
+    char uid[16], request[64];
+    int len = snprintf(uid, sizeof(uid), "%u", (unsigned int)getuid());
+    int n = snprintf(request, sizeof(request), "%cAUTH EXTERNAL ", '\0');
+    for (int i = 0; i < len; i++) {
+        n += snprintf(request + n, sizeof(request) - n, "%02x", (unsigned char)uid[i]);
+    }
+    n += snprintf(request + n, sizeof(request) - n, "\r\n");
+    if (send(fd, request, n, MSG_NOSIGNAL) != n) {
+        return false;
+    }
+
+    char line[256];
+    size_t used = 0;
+    while (used < sizeof(line) - 1 && !memchr(line, '\n', used)) {
+        if (!wait_readable(fd, deadline)) {
+            return false;
+        }
+        ssize_t got = recv(fd, line + used, sizeof(line) - 1 - used, 0);
+        if (got <= 0) {
+            return false;
+        }
+        used += got;
+    }
+    line[used] = '\0';
+    if (strncmp(line, "OK ", 3) != 0) {
+        return false;
+    }
+    return send(fd, "BEGIN\r\n", 7, MSG_NOSIGNAL) == 7;
+}
+
+bool dbus_wire_open_session(DBusConnection *conn, int timeout_ms) {
+    memset(conn, 0, sizeof(*conn));
+    conn->fd = -1;
+    long long deadline = now_ms() + timeout_ms;
+
+    char fallback[128];
+    const char *addresses = getenv("DBUS_SESSION_BUS_ADDRESS");
+    if (!addresses || !*addresses) {
+        const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+        if (!runtime_dir) {
+            return false;
+        }
+        snprintf(fallback, sizeof(fallback), "unix:path=%s/bus", runtime_dir);
+        addresses = fallback;
+    }
+
+    // Addresses are tried in order, separated by ';'
+    for (const char *p = addresses; *p && conn->fd < 0; ) {
+        const char *end = strchr(p, ';');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        int fd = connect_address(p, len);
+        if (fd >= 0) {
+            if (authenticate(fd, deadline)) {
+                conn->fd = fd;
+            } else {
+                close(fd);
+            }
+        }
+        p += len + (end ? 1 : 0);
+    }
+    if (conn->fd < 0) {
+        return false;
+    }
+
+    DBusWriter w;
+    DBusMessage reply;
+    DBusHeader hello = {
+        .type = DBUS_MESSAGE_METHOD_CALL,
+        .destination = "org.freedesktop.DBus",
+        .path = "/org/freedesktop/DBus",
+        .interface = "org.freedesktop.DBus",
+        .member = "Hello"
+    };
+    dbus_writer_begin(&w, &hello);
+    if (!dbus_wire_call(conn, &w, &reply, (int)(deadline - now_ms()))) {
+        dbus_wire_close(conn);
+        return false;
+    }
+    return true;
+}
+
+void dbus_wire_close(DBusConnection *conn) {
+    if (conn->fd >= 0) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    conn->used = 0;
+    conn->consumed = 0;
+}
@@ -0,0 +1,111 @@
+#ifndef DBUS_WIRE_H
+#define DBUS_WIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Just enough of the D-Bus wire protocol to call methods and receive
+// signals on the session bus: one connection, EXTERNAL auth, no fd passing.
+// Messages are built and parsed in fixed buffers, nothing is allocated.
+#define DBUS_WIRE_MAX_MESSAGE 4096
+
+typedef enum {
+    DBUS_MESSAGE_METHOD_CALL = 1,
+    DBUS_MESSAGE_METHOD_RETURN,
+    DBUS_MESSAGE_ERROR,
+    DBUS_MESSAGE_SIGNAL
+} DBusMessageType;
+
+// Header of an outgoing message; unused fields are NULL or 0
+typedef struct {
+    DBusMessageType type;
+    uint32_t reply_serial;
+    const char *destination;
+    const char *path;
+    const char *interface;
+    const char *member;
+    const char *error_name;
+    const char *signature;      // of the body, NULL for none
+} DBusHeader;
+
+typedef struct {
+    uint8_t data[DBUS_WIRE_MAX_MESSAGE];
+    size_t len;
+    size_t body_start;
+    bool overflow;              // message did not fit, send refuses it
+} DBusWriter;
+
+// An array under construction, see dbus_open_array
+typedef struct {
+    size_t length_at;
+    size_t start;
+} DBusArray;
+
+// A received message; strings point into the connection's buffer and stay
+// valid until the next dbus_wire_next
+typedef struct {
+    DBusMessageType type;
+    uint32_t serial;
+    uint32_t reply_serial;
+    const char *path;
+    const char *interface;
+    const char *member;
+    const char *error_name;
+    const char *sender;
+    const char *signature;
+    const uint8_t *body;
+    size_t body_len;
+    bool swap;                  // sent with the other byte order
+} DBusMessage;
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    bool swap;
+    bool error;                 // set by any read past the end or type mismatch
+} DBusReader;
+
+typedef struct {
+    int fd;
+    uint32_t last_serial;
+    uint8_t buffer[2 * DBUS_WIRE_MAX_MESSAGE];
+    size_t used;
+    size_t consumed;            // length of the message last returned by dbus_wire_next
+} DBusConnection;
+
+// Building: begin, append body values, then dbus_wire_send
+void dbus_writer_begin(DBusWriter *w, const DBusHeader *header);
+void dbus_put_byte(DBusWriter *w, uint8_t value);
+void dbus_put_bool(DBusWriter *w, bool value);
+void dbus_put_u32(DBusWriter *w, uint32_t value);
+void dbus_put_i32(DBusWriter *w, int32_t value);
+// Invalid UTF-8 is replaced by '?', the bus would drop the connection for it
+void dbus_put_string(DBusWriter *w, const char *value);
+void dbus_put_signature(DBusWriter *w, const char *value);
+DBusArray dbus_open_array(DBusWriter *w, int element_alignment);
+void dbus_close_array(DBusWriter *w, DBusArray array);
+void dbus_open_struct(DBusWriter *w);   // also dict entries
+
+// Reading a body, values in signature order
+void dbus_reader_init(DBusReader *r, const DBusMessage *message);
+uint32_t dbus_read_u32(DBusReader *r);
+bool dbus_read_bool(DBusReader *r);
+const char *dbus_read_string(DBusReader *r);
+
+// Connect and authenticate to the session bus (DBUS_SESSION_BUS_ADDRESS,
+// else $XDG_RUNTIME_DIR/bus) and say Hello. Blocks for at most timeout_ms.
+bool dbus_wire_open_session(DBusConnection *conn, int timeout_ms);
+void dbus_wire_close(DBusConnection *conn);
+
+// Assigns the serial and sends without blocking; returns it, 0 on failure
+uint32_t dbus_wire_send(DBusConnection *conn, DBusWriter *w);
+// Read what the socket has; false once the connection is gone
+bool dbus_wire_receive(DBusConnection *conn);
+// Next complete message from what was received, false if there is none
+bool dbus_wire_next(DBusConnection *conn, DBusMessage *message);
+// Send and wait for the matching reply, dropping anything else; for setup only
+bool dbus_wire_call(DBusConnection *conn, DBusWriter *w, DBusMessage *reply, int timeout_ms);
+
+#endif
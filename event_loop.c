@@ -0,0 +1,98 @@
+#define _POSIX_C_SOURCE 199309L
+#include <poll.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include "event_loop.h"
+
+typedef struct {
+    EventCallback callback;
+    void *data;
+} Watch;
+
+static struct pollfd poll_fds[EVENT_LOOP_MAX_WATCHES];
+static Watch watches[EVENT_LOOP_MAX_WATCHES];
+static int watch_count = 0;
+static bool removed_during_dispatch = false;
+static volatile sig_atomic_t stop_requested = 0;
+
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool event_loop_add(int fd, short events, EventCallback callback, void *data) {
+    if (fd < 0 || watch_count >= EVENT_LOOP_MAX_WATCHES) {
+        return false;
+    }
+    poll_fds[watch_count].fd = fd;
+    poll_fds[watch_count].events = events;
+    poll_fds[watch_count].revents = 0;
+    watches[watch_count].callback = callback;
+    watches[watch_count].data = data;
+    watch_count++;
+    return true;
+}
+
+void event_loop_remove(int fd) {
+    // Only mark the slot here; it is dropped once dispatch is done
+    for (int i = 0; i < watch_count; i++) {
+        if (poll_fds[i].fd == fd) {
+            poll_fds[i].fd = -1;
+            removed_during_dispatch = true;
+        }
+    }
+}
+
+static void compact_watches(void) {
+    int kept = 0;
+    for (int i = 0; i < watch_count; i++) {
+        if (poll_fds[i].fd >= 0) {
+            poll_fds[kept] = poll_fds[i];
+            watches[kept] = watches[i];
+            kept++;
+        }
+    }
+    watch_count = kept;
+    removed_during_dispatch = false;
+}
+
+void event_loop_run_for(int timeout_ms) {
+    long long deadline = monotonic_ms() + timeout_ms;
+
+    while (!stop_requested) {
+        long long remaining = deadline - monotonic_ms();
+        if (remaining <= 0) {
+            break;
+        }
+
+        int ready = poll(poll_fds, watch_count, (int)remaining);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Watches added by a callback are polled from the next round
+        int count = watch_count;
+        for (int i = 0; i < count && ready > 0; i++) {
+            if (poll_fds[i].fd < 0 || poll_fds[i].revents == 0) continue;
+            short revents = poll_fds[i].revents;
+            poll_fds[i].revents = 0;
+            ready--;
+            watches[i].callback(poll_fds[i].fd, revents, watches[i].data);
+        }
+
+        if (removed_during_dispatch) {
+            compact_watches();
+        }
+    }
+}
+
+void event_loop_stop(void) {
+    stop_requested = 1;
+}
+
+bool event_loop_stopped(void) {
+    return stop_requested != 0;
+}
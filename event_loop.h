@@ -0,0 +1,25 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+
+// Small poll(2) loop so the daemon can serve sockets between timer ticks
+#define EVENT_LOOP_MAX_WATCHES 32
+
+typedef void (*EventCallback)(int fd, short revents, void *data);
+
+// Watch fd for events (POLLIN etc.); callback runs from event_loop_run_for
+bool event_loop_add(int fd, short events, EventCallback callback, void *data);
+// Safe to call from inside a callback
+void event_loop_remove(int fd);
+
+// Dispatch events until timeout_ms has elapsed. Replaces sleep() in the
+// timer loop, so it always waits the full time, unless stopped.
+void event_loop_run_for(int timeout_ms);
+
+// Make event_loop_run_for return now and from then on; async-signal-safe,
+// so a SIGTERM handler can end the timer loop and let it clean up
+void event_loop_stop(void);
+bool event_loop_stopped(void);
+
+#endif
@@ -26,6 +26,12 @@ command -v python3 >/dev/null 2>&1 || fail "python3 not found"
 if ! pkg-config --exists gtk+-3.0; then
   fail "GTK+3 development libraries not found. Install with:\n  - Debian/Ubuntu: sudo apt install libgtk-3-dev\n  - Fedora:        sudo dnf install gtk3-devel\n  - Arch:          sudo pacman -S gtk3"
 fi
+if ! pkg-config --exists zlib; then
+  fail "zlib development files not found. Install with:\n  - Debian/Ubuntu: sudo apt install zlib1g-dev\n  - Fedora:        sudo dnf install zlib-devel\n  - Arch:          sudo pacman -S zlib"
+fi
+if ! pkg-config --exists sqlite3; then
+  fail "SQLite development files not found. Install with:\n  - Debian/Ubuntu: sudo apt install libsqlite3-dev\n  - Fedora:        sudo dnf install sqlite-devel\n  - Arch:          sudo pacman -S sqlite"
+fi
 
 # Check Python dependencies
 say "Checking Python dependencies..."
@@ -43,6 +49,8 @@ make clean
 make all
 
 install -m 0755 "$bin_name" "$install_bin_path"
+install -m 0755 restly-popup "$install_bin_dir/"
+install -m 0755 restly-log "$install_bin_dir/"
 ok "Installed binary to ${install_bin_path/$HOME/~}"
 
 # Install Python scripts
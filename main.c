@@ -4,13 +4,13 @@
 #include "timer.h"
 #include "daemon.h"
 #include "config.h"
-#include "activity_log.h"
+#include "event_loop.h"
 
-// Signal handler for graceful shutdown
+// Signal handler for graceful shutdown: the timer loop returns from its
+// wait and runs the usual cleanup, which flushes the activity log
 void signal_handler(int sig) {
     (void)sig; // Suppress unused parameter warning
-    cleanup_activity_logging();
-    exit(0);
+    event_loop_stop();
 }
 
 
@@ -22,7 +22,9 @@ int main(int argc, char *argv[])
     signal(SIGTERM, signal_handler);
     signal(SIGINT, signal_handler);
     
-    daemonize();
+    if (!config.foreground) {
+        daemonize();
+    }
 
     start_timer(config);
     if(config.message) {
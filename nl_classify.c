@@ -0,0 +1,170 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "nl_classify.h"
+
+#define NL_TEXT_MAX 256
+
+static const NLModelHeader *model = NULL;
+static const float *model_bias = NULL;
+static const float *model_weights = NULL;
+static size_t model_size = 0;
+
+const char *get_intent_model_path(void) {
+    static char path[512];
+    const char *home = getenv("HOME");
+    if (!home) {
+        return NULL;
+    }
+    snprintf(path, sizeof(path), "%s/.config/restly/intent_model.bin", home);
+    return path;
+}
+
+bool nl_classifier_load(const char *path) {
+    nl_classifier_unload();
+    if (!path) {
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        // No model trained yet, rules only
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(NLModelHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Failed to map intent model %s\n", path);
+        return false;
+    }
+
+    const NLModelHeader *header = map;
+    size_t expected = 0;
+    bool valid = memcmp(header->magic, NL_MODEL_MAGIC, sizeof(header->magic)) == 0
+        && header->version == NL_MODEL_VERSION
+        && header->n_classes > 0 && header->n_classes <= NL_MODEL_MAX_CLASSES
+        && header->n_buckets > 0 && (header->n_buckets & (header->n_buckets - 1)) == 0
+        && header->ngram_min > 0 && header->ngram_min <= header->ngram_max
+        && header->ngram_max <= 8;
+    if (valid) {
+        expected = sizeof(NLModelHeader)
+            + sizeof(float) * header->n_classes * ((size_t)header->n_buckets + 1);
+        valid = (size_t)st.st_size == expected;
+        for (uint32_t c = 0; valid && c < header->n_classes; c++) {
+            valid = header->class_names[c][NL_MODEL_CLASS_NAME - 1] == '\0';
+        }
+    }
+    if (!valid) {
+        fprintf(stderr, "Ignoring invalid intent model %s\n", path);
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+
+    // Lookups touch a handful of random buckets; don't read ahead
+    madvise(map, (size_t)st.st_size, MADV_RANDOM);
+
+    model = header;
+    model_size = (size_t)st.st_size;
+    model_bias = (const float *)(header + 1);
+    model_weights = model_bias + header->n_classes;
+    return true;
+}
+
+bool nl_classifier_loaded(void) {
+    return model != NULL;
+}
+
+void nl_classifier_unload(void) {
+    if (model) {
+        munmap((void *)model, model_size);
+    }
+    model = NULL;
+    model_bias = NULL;
+    model_weights = NULL;
+    model_size = 0;
+}
+
+// Lowercase ASCII letters and digits, everything else folds to one space,
+// padded with a space on each side. Must match normalize() in the trainer.
+static size_t normalize_text(const char *text, char *out, size_t size) {
+    size_t len = 0;
+    out[len++] = ' ';
+    for (const char *p = text; *p && len < size - 2; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c < 0x80 && isalnum(c)) {
+            out[len++] = (char)tolower(c);
+        } else if (out[len - 1] != ' ') {
+            out[len++] = ' ';
+        }
+    }
+    if (out[len - 1] != ' ') {
+        out[len++] = ' ';
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// 32-bit FNV-1a, the feature hash shared with the trainer
+static uint32_t fnv1a(const char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool nl_classifier_predict(const char *text, NLPrediction *out) {
+    if (!model || !text) {
+        return false;
+    }
+
+    char norm[NL_TEXT_MAX + 3];
+    size_t len = normalize_text(text, norm, sizeof(norm));
+    if (len <= 2) {
+        return false;
+    }
+
+    uint32_t n_classes = model->n_classes;
+    uint32_t mask = model->n_buckets - 1;
+    float scores[NL_MODEL_MAX_CLASSES];
+    memcpy(scores, model_bias, sizeof(float) * n_classes);
+
+    for (uint32_t n = model->ngram_min; n <= model->ngram_max; n++) {
+        for (size_t i = 0; i + n <= len; i++) {
+            const float *row = model_weights + (size_t)(fnv1a(norm + i, n) & mask) * n_classes;
+            for (uint32_t c = 0; c < n_classes; c++) {
+                scores[c] += row[c];
+            }
+        }
+    }
+
+    uint32_t best = 0;
+    for (uint32_t c = 1; c < n_classes; c++) {
+        if (scores[c] > scores[best]) {
+            best = c;
+        }
+    }
+    float total = 0;
+    for (uint32_t c = 0; c < n_classes; c++) {
+        total += expf(scores[c] - scores[best]);
+    }
+
+    out->class_name = model->class_names[best];
+    out->confidence = 1.0f / total;
+    return true;
+}
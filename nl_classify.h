@@ -0,0 +1,43 @@
+#ifndef NL_CLASSIFY_H
+#define NL_CLASSIFY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Offline intent classifier: hashed character n-grams scored by a linear
+// model whose weights are mmapped read-only from a file written by
+// train_intent_model.py.
+
+#define NL_MODEL_MAGIC "RSTLYIC1"
+#define NL_MODEL_VERSION 1
+#define NL_MODEL_MAX_CLASSES 16
+#define NL_MODEL_CLASS_NAME 16
+
+// On-disk header, followed by float bias[n_classes] and
+// float weights[n_buckets][n_classes] (native byte order)
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t n_classes;
+    uint32_t n_buckets;     // power of two
+    uint32_t ngram_min;
+    uint32_t ngram_max;
+    uint32_t reserved;
+    char class_names[NL_MODEL_MAX_CLASSES][NL_MODEL_CLASS_NAME];
+} NLModelHeader;
+
+typedef struct {
+    const char *class_name;  // points into the mapped model
+    float confidence;        // softmax probability of the best class
+} NLPrediction;
+
+// Map the model file; returns false (and stays unloaded) if it is missing or invalid
+bool nl_classifier_load(const char *path);
+bool nl_classifier_loaded(void);
+bool nl_classifier_predict(const char *text, NLPrediction *out);
+void nl_classifier_unload(void);
+
+// Default model location: ~/.config/restly/intent_model.bin
+const char *get_intent_model_path(void);
+
+#endif
@@ -0,0 +1,131 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "nl_fuzzy.h"
+
+static long elapsed_us(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+int nl_edit_distance(const char *pattern, size_t m, const char *text, size_t n) {
+    if (m == 0) return (int)n;
+    if (n == 0) return (int)m;
+    if (m > NL_FUZZY_MAX_PATTERN) return -1;
+
+    // Peq[c]: bit i set where pattern[i] == c
+    uint64_t peq[256] = {0};
+    for (size_t i = 0; i < m; i++) {
+        peq[(unsigned char)pattern[i]] |= (uint64_t)1 << i;
+    }
+
+    uint64_t pv = (m == 64) ? ~(uint64_t)0 : (((uint64_t)1 << m) - 1);
+    uint64_t mv = 0;
+    uint64_t high = (uint64_t)1 << (m - 1);
+    int score = (int)m;
+
+    for (size_t j = 0; j < n; j++) {
+        uint64_t eq = peq[(unsigned char)text[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        if (ph & high) {
+            score++;
+        } else if (mh & high) {
+            score--;
+        }
+
+        // Row 0 grows by one per text character: global, not substring, distance
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+
+    return score;
+}
+
+// Allowed distance for a word pair: one edit for short words, two otherwise
+static int distance_limit(size_t a, size_t b) {
+    size_t shorter = a < b ? a : b;
+    return shorter <= 4 ? 1 : 2;
+}
+
+static size_t append(char *out, size_t len, size_t size, const char *src, size_t n) {
+    if (len + n >= size) {
+        n = len < size - 1 ? size - 1 - len : 0;
+    }
+    memcpy(out + len, src, n);
+    return len + n;
+}
+
+int nl_fuzzy_correct(const char *text, char *out, size_t out_size,
+                     const NLVocabEntry *vocab, int vocab_count,
+                     NLCorrection *corrections, int max_corrections,
+                     bool *budget_exceeded) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    size_t len = 0;
+    int count = 0;
+    const char *p = text;
+    *budget_exceeded = false;
+
+    while (*p) {
+        if (!isalpha((unsigned char)*p)) {
+            len = append(out, len, out_size, p, 1);
+            p++;
+            continue;
+        }
+
+        const char *word = p;
+        while (isalnum((unsigned char)*p)) {
+            p++;
+        }
+        size_t wlen = (size_t)(p - word);
+        const NLVocabEntry *best = NULL;
+        int best_distance = 0;
+
+        if (wlen >= 4 && wlen < NL_FUZZY_WORD_MAX && count < max_corrections && !*budget_exceeded) {
+            if (elapsed_us(&start) > NL_FUZZY_BUDGET_US) {
+                *budget_exceeded = true;
+            } else {
+                for (int i = 0; i < vocab_count; i++) {
+                    size_t m = strlen(vocab[i].word);
+                    int limit = distance_limit(m, wlen);
+                    size_t diff = m > wlen ? m - wlen : wlen - m;
+                    if ((int)diff > limit) continue;
+
+                    int d = nl_edit_distance(vocab[i].word, m, word, wlen);
+                    if (d >= 0 && d <= limit && (!best || d < best_distance)) {
+                        best = &vocab[i];
+                        best_distance = d;
+                        if (d == 0) break;
+                    }
+                }
+            }
+        }
+
+        bool changed = best && (best_distance > 0
+            || strlen(best->replacement) != wlen || strncmp(best->replacement, word, wlen) != 0);
+        if (changed) {
+            NLCorrection *c = &corrections[count++];
+            memcpy(c->typo, word, wlen);
+            c->typo[wlen] = '\0';
+            strncpy(c->correction, best->replacement, sizeof(c->correction) - 1);
+            c->correction[sizeof(c->correction) - 1] = '\0';
+            c->distance = best_distance;
+            len = append(out, len, out_size, best->replacement, strlen(best->replacement));
+        } else {
+            len = append(out, len, out_size, word, wlen);
+        }
+    }
+
+    out[len] = '\0';
+    return count;
+}
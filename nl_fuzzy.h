@@ -0,0 +1,36 @@
+#ifndef NL_FUZZY_H
+#define NL_FUZZY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Longest keyword the bit-parallel kernel accepts (one machine word)
+#define NL_FUZZY_MAX_PATTERN 64
+// Hard cap on time spent correcting one command
+#define NL_FUZZY_BUDGET_US 200
+#define NL_FUZZY_WORD_MAX 32
+
+typedef struct {
+    const char *word;         // keyword as typed correctly
+    const char *replacement;  // text substituted for it ("deepwork" -> "deep work")
+} NLVocabEntry;
+
+typedef struct {
+    char typo[NL_FUZZY_WORD_MAX];
+    char correction[NL_FUZZY_WORD_MAX];
+    int distance;
+} NLCorrection;
+
+// Levenshtein distance between pattern (at most NL_FUZZY_MAX_PATTERN bytes)
+// and text using Myers' bit-parallel algorithm, O(n) word operations.
+int nl_edit_distance(const char *pattern, size_t m, const char *text, size_t n);
+
+// Copy lowercase text to out, replacing each word that is within a small edit
+// distance of a vocabulary keyword. Stops correcting once NL_FUZZY_BUDGET_US
+// has elapsed and sets *budget_exceeded. Returns the number of corrections.
+int nl_fuzzy_correct(const char *text, char *out, size_t out_size,
+                     const NLVocabEntry *vocab, int vocab_count,
+                     NLCorrection *corrections, int max_corrections,
+                     bool *budget_exceeded);
+
+#endif
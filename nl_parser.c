@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "nl_parser.h"
+#include "nl_classify.h"
+
+static const char *intent_names[NL_INTENT_COUNT] = {
+    [NL_INTENT_UNKNOWN] = "unknown",
+    [NL_INTENT_RESCHEDULE] = "reschedule",
+    [NL_INTENT_PAUSE] = "pause",
+    [NL_INTENT_RESUME] = "resume",
+    [NL_INTENT_DEEP_WORK] = "deep_work",
+    [NL_INTENT_BREAK_NOW] = "break_now",
+    [NL_INTENT_STATUS] = "status",
+};
+
+const char *nl_intent_name(NLIntent intent) {
+    if (intent < 0 || intent >= NL_INTENT_COUNT) {
+        return "unknown";
+    }
+    return intent_names[intent];
+}
+
+NLIntent nl_intent_from_name(const char *name) {
+    for (int i = 0; i < NL_INTENT_COUNT; i++) {
+        if (strcmp(intent_names[i], name) == 0) {
+            return (NLIntent)i;
+        }
+    }
+    return NL_INTENT_UNKNOWN;
+}
+
+const char *nl_source_name(NLSource source) {
+    switch (source) {
+        case NL_SOURCE_CLASSIFIER: return "classifier";
+        case NL_SOURCE_RULES: return "rules";
+        case NL_SOURCE_FUZZY: return "fuzzy";
+        default: return "none";
+    }
+}
+
+// Keywords the typo matcher may correct to. Very short or very common
+// words ("now", "how", "what", "work") are left out to avoid false hits.
+static const NLVocabEntry rule_vocabulary[] = {
+    {"reschedule", "reschedule"},
+    {"delay", "delay"},
+    {"postpone", "postpone"},
+    {"pause", "pause"},
+    {"stop", "stop"},
+    {"resume", "resume"},
+    {"start", "start"},
+    {"continue", "continue"},
+    {"deepwork", "deep work"},
+    {"focus", "focus"},
+    {"session", "session"},
+    {"break", "break"},
+    {"status", "status"},
+};
+
+// Keyword rules, checked in priority order
+static NLIntent rule_intent(const char *lower_text) {
+    if (strstr(lower_text, "reschedule") || strstr(lower_text, "delay") || strstr(lower_text, "postpone")) {
+        return NL_INTENT_RESCHEDULE;
+    }
+    if (strstr(lower_text, "pause") || strstr(lower_text, "stop")) {
+        return NL_INTENT_PAUSE;
+    }
+    // Before resume, so "start a focus session" is not read as "start"
+    if (strstr(lower_text, "deep work") || strstr(lower_text, "focus") || strstr(lower_text, "session")) {
+        return NL_INTENT_DEEP_WORK;
+    }
+    if (strstr(lower_text, "resume") || strstr(lower_text, "start") || strstr(lower_text, "continue")) {
+        return NL_INTENT_RESUME;
+    }
+    if (strstr(lower_text, "break") && strstr(lower_text, "now")) {
+        return NL_INTENT_BREAK_NOW;
+    }
+    if (strstr(lower_text, "status") || strstr(lower_text, "how") || strstr(lower_text, "what")) {
+        return NL_INTENT_STATUS;
+    }
+    return NL_INTENT_UNKNOWN;
+}
+
+void nl_parse_command(const char *text, time_t now, NLCommand *out) {
+    memset(out, 0, sizeof(*out));
+    if (!text) {
+        return;
+    }
+
+    // Convert to lowercase for case-insensitive matching
+    char lower_text[256];
+    strncpy(lower_text, text, sizeof(lower_text) - 1);
+    lower_text[sizeof(lower_text) - 1] = '\0';
+    for (int i = 0; lower_text[i]; i++) {
+        lower_text[i] = tolower((unsigned char)lower_text[i]);
+    }
+
+    // Statistical model first when one is installed, rules as the fallback
+    NLPrediction prediction;
+    if (nl_classifier_predict(lower_text, &prediction)) {
+        NLIntent predicted = nl_intent_from_name(prediction.class_name);
+        out->confidence = prediction.confidence;
+        if (predicted != NL_INTENT_UNKNOWN && prediction.confidence >= NL_CLASSIFIER_THRESHOLD) {
+            out->intent = predicted;
+            out->source = NL_SOURCE_CLASSIFIER;
+        }
+    }
+
+    if (out->source == NL_SOURCE_NONE) {
+        out->intent = rule_intent(lower_text);
+        if (out->intent != NL_INTENT_UNKNOWN) {
+            out->source = NL_SOURCE_RULES;
+            out->confidence = 1.0f;
+        }
+    }
+
+    // Last resort before the help popup: retry the rules with typos fixed
+    const char *time_text = lower_text;
+    char corrected[256];
+    if (out->source == NL_SOURCE_NONE) {
+        NLCorrection corrections[NL_MAX_CORRECTIONS];
+        int count = nl_fuzzy_correct(lower_text, corrected, sizeof(corrected),
+                                     rule_vocabulary, sizeof(rule_vocabulary) / sizeof(rule_vocabulary[0]),
+                                     corrections, NL_MAX_CORRECTIONS, &out->fuzzy_budget_exceeded);
+        NLIntent intent = count > 0 ? rule_intent(corrected) : NL_INTENT_UNKNOWN;
+        if (intent != NL_INTENT_UNKNOWN) {
+            out->intent = intent;
+            out->source = NL_SOURCE_FUZZY;
+            out->confidence = 1.0f;
+            memcpy(out->corrections, corrections, sizeof(corrections[0]) * count);
+            out->correction_count = count;
+            time_text = corrected;
+        }
+    }
+
+    nl_parse_time(time_text, now, &out->time);
+}
+
+// Default deep work length when a step gives none, matching timer.c
+#define NL_DEFAULT_DEEP_WORK_SECONDS (45 * 60)
+
+static bool is_word_at(const char *text, const char *p, const char *word) {
+    size_t len = strlen(word);
+    return strncmp(p, word, len) == 0
+        && (p == text || !isalnum((unsigned char)p[-1]))
+        && !isalnum((unsigned char)p[len]);
+}
+
+// Length of a step separator starting at p, 0 if there is none
+static size_t separator_length(const char *text, const char *p) {
+    static const char *separators[] = {"and then", "after that", "afterwards", "then"};
+    if (*p == ';') {
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(separators) / sizeof(separators[0]); i++) {
+        if (is_word_at(text, p, separators[i])) {
+            return strlen(separators[i]);
+        }
+    }
+    return 0;
+}
+
+static void add_clause(NLActionList *out, const char *start, const char *end) {
+    // Trim spaces and joining punctuation around the clause
+    while (start < end && (isspace((unsigned char)*start) || *start == ',')) start++;
+    while (end > start && (isspace((unsigned char)end[-1]) || end[-1] == ',')) end--;
+    if (start == end) {
+        return;
+    }
+    if (out->count >= NL_MAX_ACTIONS) {
+        out->overflow = true;
+        return;
+    }
+
+    NLAction *action = &out->actions[out->count++];
+    size_t len = (size_t)(end - start);
+    if (len >= sizeof(action->clause)) {
+        len = sizeof(action->clause) - 1;
+        out->overflow = true;
+    }
+    memcpy(action->clause, start, len);
+    action->clause[len] = '\0';
+}
+
+int nl_parse_actions(const char *text, time_t now, NLActionList *out) {
+    memset(out, 0, sizeof(*out));
+    if (!text) {
+        return 0;
+    }
+
+    char lower_text[256];
+    strncpy(lower_text, text, sizeof(lower_text) - 1);
+    lower_text[sizeof(lower_text) - 1] = '\0';
+    if (strlen(text) >= sizeof(lower_text)) {
+        out->overflow = true;
+    }
+    for (int i = 0; lower_text[i]; i++) {
+        lower_text[i] = tolower((unsigned char)lower_text[i]);
+    }
+
+    const char *start = lower_text;
+    for (const char *p = lower_text; *p; ) {
+        size_t sep = separator_length(lower_text, p);
+        if (sep) {
+            add_clause(out, start, p);
+            p += sep;
+            start = p;
+        } else {
+            p++;
+        }
+    }
+    add_clause(out, start, lower_text + strlen(lower_text));
+
+    // Steps run back to back: one that follows a timed pause or a focus
+    // session is deferred until it is over
+    int offset = 0;
+    for (int i = 0; i < out->count; i++) {
+        NLAction *action = &out->actions[i];
+        action->offset_seconds = offset;
+        nl_parse_command(action->clause, now + offset, &action->command);
+
+        const NLCommand *command = &action->command;
+        bool timed = command->time.kind != NL_TIME_NONE && command->time.duration_seconds > 0;
+        if (command->intent == NL_INTENT_PAUSE && timed) {
+            offset += command->time.duration_seconds;
+        } else if (command->intent == NL_INTENT_DEEP_WORK) {
+            offset += timed ? command->time.duration_seconds : NL_DEFAULT_DEEP_WORK_SECONDS;
+        }
+    }
+
+    return out->count;
+}
@@ -0,0 +1,74 @@
+#ifndef NL_PARSER_H
+#define NL_PARSER_H
+
+#include <stdbool.h>
+#include <time.h>
+#include "nl_time.h"
+#include "nl_fuzzy.h"
+
+// Intents understood by the command palette
+typedef enum {
+    NL_INTENT_UNKNOWN = 0,
+    NL_INTENT_RESCHEDULE,
+    NL_INTENT_PAUSE,
+    NL_INTENT_RESUME,
+    NL_INTENT_DEEP_WORK,
+    NL_INTENT_BREAK_NOW,
+    NL_INTENT_STATUS,
+    NL_INTENT_COUNT
+} NLIntent;
+
+// Which stage decided the intent
+typedef enum {
+    NL_SOURCE_NONE = 0,
+    NL_SOURCE_CLASSIFIER,
+    NL_SOURCE_RULES,
+    NL_SOURCE_FUZZY         // keyword rules after typo correction
+} NLSource;
+
+// Classifier predictions below this probability fall back to keyword rules
+#define NL_CLASSIFIER_THRESHOLD 0.6f
+#define NL_MAX_CORRECTIONS 4
+// Steps in one multi-intent command ("pause 30 min then focus 90 min")
+#define NL_MAX_ACTIONS 4
+#define NL_CLAUSE_MAX 128
+
+typedef struct {
+    NLIntent intent;
+    NLSource source;
+    float confidence;       // classifier probability, 1.0 for a rule match
+    NLTimeExpr time;        // duration or deadline, kind NL_TIME_NONE if absent
+    NLCorrection corrections[NL_MAX_CORRECTIONS];
+    int correction_count;   // typos fixed to reach the intent (NL_SOURCE_FUZZY)
+    bool fuzzy_budget_exceeded;
+} NLCommand;
+
+// One step of a multi-intent command
+typedef struct {
+    NLCommand command;
+    int offset_seconds;         // when the step starts, relative to now
+    char clause[NL_CLAUSE_MAX]; // the part of the text this step came from
+} NLAction;
+
+typedef struct {
+    NLAction actions[NL_MAX_ACTIONS];
+    int count;
+    bool overflow;              // a step was dropped or cut short: more than
+                                // NL_MAX_ACTIONS, or text beyond the limits
+} NLActionList;
+
+// Parse a palette command into an intent plus optional time expression.
+// Does not touch daemon state, so it can be linked without GTK.
+void nl_parse_command(const char *text, time_t now, NLCommand *out);
+
+// Split a command on "then" / "after that" / ";" into ordered steps. A step
+// following a timed pause or a deep work session starts when that one ends.
+// Returns the number of steps; out->overflow says some were lost, and the
+// command should not be run in part.
+int nl_parse_actions(const char *text, time_t now, NLActionList *out);
+
+const char *nl_intent_name(NLIntent intent);
+NLIntent nl_intent_from_name(const char *name);
+const char *nl_source_name(NLSource source);
+
+#endif
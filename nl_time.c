@@ -0,0 +1,611 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "nl_time.h"
+
+// Tokens are lexed lazily into a small ring, so the input is read exactly once
+#define NL_LOOKAHEAD 8
+#define NL_WORD_MAX 16
+#define NL_MAX_SECONDS (7 * 24 * 3600)
+
+typedef enum {
+    TOK_END,
+    TOK_NUMBER,
+    TOK_CLOCK,
+    TOK_WORD,
+    TOK_OTHER
+} TokenKind;
+
+typedef enum {
+    W_NONE,
+    W_SECOND,
+    W_MINUTE,
+    W_HOUR,
+    W_HALF,
+    W_QUARTER,
+    W_AND,
+    W_OF,
+    W_AM,
+    W_PM,
+    W_NOON,
+    W_MIDNIGHT,
+    W_UNTIL,
+    W_BY,
+    W_AT,
+    W_OCLOCK,
+    W_MORE,
+    W_SLOT              // a bare number after it is a duration ("for 20", "delay 5")
+} WordId;
+
+// Number token flags
+#define NUM_DIGITS  0x1   // written with digits ("30", "1.5")
+#define NUM_WORD    0x2   // spelled out ("thirty")
+#define NUM_TENS    0x4   // "twenty".."ninety", may be followed by a unit digit word
+#define NUM_ARTICLE 0x8   // "a" / "an"
+
+// Clock token flags
+#define CLOCK_24H   0x1   // zero-padded hour ("09:30"), never read as 12-hour
+
+typedef struct {
+    TokenKind kind;
+    WordId word;
+    double value;
+    int hour;
+    int minute;
+    unsigned flags;
+} Token;
+
+typedef struct {
+    const char *p;
+    Token ring[NL_LOOKAHEAD];
+    int head;
+    int count;
+} Lexer;
+
+typedef struct {
+    const char *text;
+    TokenKind kind;
+    WordId word;
+    double value;
+    unsigned flags;
+} LexEntry;
+
+static const LexEntry lexicon[] = {
+    {"s", TOK_WORD, W_SECOND, 0, 0},
+    {"sec", TOK_WORD, W_SECOND, 0, 0},
+    {"secs", TOK_WORD, W_SECOND, 0, 0},
+    {"second", TOK_WORD, W_SECOND, 0, 0},
+    {"seconds", TOK_WORD, W_SECOND, 0, 0},
+    {"m", TOK_WORD, W_MINUTE, 0, 0},
+    {"min", TOK_WORD, W_MINUTE, 0, 0},
+    {"mins", TOK_WORD, W_MINUTE, 0, 0},
+    {"minute", TOK_WORD, W_MINUTE, 0, 0},
+    {"minutes", TOK_WORD, W_MINUTE, 0, 0},
+    {"h", TOK_WORD, W_HOUR, 0, 0},
+    {"hr", TOK_WORD, W_HOUR, 0, 0},
+    {"hrs", TOK_WORD, W_HOUR, 0, 0},
+    {"hour", TOK_WORD, W_HOUR, 0, 0},
+    {"hours", TOK_WORD, W_HOUR, 0, 0},
+    {"half", TOK_WORD, W_HALF, 0, 0},
+    {"quarter", TOK_WORD, W_QUARTER, 0, 0},
+    {"quarters", TOK_WORD, W_QUARTER, 0, 0},
+    {"and", TOK_WORD, W_AND, 0, 0},
+    {"of", TOK_WORD, W_OF, 0, 0},
+    {"am", TOK_WORD, W_AM, 0, 0},
+    {"pm", TOK_WORD, W_PM, 0, 0},
+    {"noon", TOK_WORD, W_NOON, 0, 0},
+    {"midday", TOK_WORD, W_NOON, 0, 0},
+    {"midnight", TOK_WORD, W_MIDNIGHT, 0, 0},
+    {"until", TOK_WORD, W_UNTIL, 0, 0},
+    {"untill", TOK_WORD, W_UNTIL, 0, 0},
+    {"till", TOK_WORD, W_UNTIL, 0, 0},
+    {"til", TOK_WORD, W_UNTIL, 0, 0},
+    {"by", TOK_WORD, W_BY, 0, 0},
+    {"before", TOK_WORD, W_UNTIL, 0, 0},
+    {"at", TOK_WORD, W_AT, 0, 0},
+    {"oclock", TOK_WORD, W_OCLOCK, 0, 0},
+    {"more", TOK_WORD, W_MORE, 0, 0},
+    {"extra", TOK_WORD, W_MORE, 0, 0},
+    {"for", TOK_WORD, W_SLOT, 0, 0},
+    {"in", TOK_WORD, W_SLOT, 0, 0},
+    {"delay", TOK_WORD, W_SLOT, 0, 0},
+    {"postpone", TOK_WORD, W_SLOT, 0, 0},
+    {"reschedule", TOK_WORD, W_SLOT, 0, 0},
+    {"snooze", TOK_WORD, W_SLOT, 0, 0},
+    {"wait", TOK_WORD, W_SLOT, 0, 0},
+    {"pause", TOK_WORD, W_SLOT, 0, 0},
+    {"focus", TOK_WORD, W_SLOT, 0, 0},
+    {"work", TOK_WORD, W_SLOT, 0, 0},
+    {"a", TOK_NUMBER, W_NONE, 1, NUM_WORD | NUM_ARTICLE},
+    {"an", TOK_NUMBER, W_NONE, 1, NUM_WORD | NUM_ARTICLE},
+    {"couple", TOK_NUMBER, W_NONE, 2, NUM_WORD},
+    {"zero", TOK_NUMBER, W_NONE, 0, NUM_WORD},
+    {"one", TOK_NUMBER, W_NONE, 1, NUM_WORD},
+    {"two", TOK_NUMBER, W_NONE, 2, NUM_WORD},
+    {"three", TOK_NUMBER, W_NONE, 3, NUM_WORD},
+    {"four", TOK_NUMBER, W_NONE, 4, NUM_WORD},
+    {"five", TOK_NUMBER, W_NONE, 5, NUM_WORD},
+    {"six", TOK_NUMBER, W_NONE, 6, NUM_WORD},
+    {"seven", TOK_NUMBER, W_NONE, 7, NUM_WORD},
+    {"eight", TOK_NUMBER, W_NONE, 8, NUM_WORD},
+    {"nine", TOK_NUMBER, W_NONE, 9, NUM_WORD},
+    {"ten", TOK_NUMBER, W_NONE, 10, NUM_WORD},
+    {"eleven", TOK_NUMBER, W_NONE, 11, NUM_WORD},
+    {"twelve", TOK_NUMBER, W_NONE, 12, NUM_WORD},
+    {"thirteen", TOK_NUMBER, W_NONE, 13, NUM_WORD},
+    {"fourteen", TOK_NUMBER, W_NONE, 14, NUM_WORD},
+    {"fifteen", TOK_NUMBER, W_NONE, 15, NUM_WORD},
+    {"sixteen", TOK_NUMBER, W_NONE, 16, NUM_WORD},
+    {"seventeen", TOK_NUMBER, W_NONE, 17, NUM_WORD},
+    {"eighteen", TOK_NUMBER, W_NONE, 18, NUM_WORD},
+    {"nineteen", TOK_NUMBER, W_NONE, 19, NUM_WORD},
+    {"twenty", TOK_NUMBER, W_NONE, 20, NUM_WORD | NUM_TENS},
+    {"thirty", TOK_NUMBER, W_NONE, 30, NUM_WORD | NUM_TENS},
+    {"forty", TOK_NUMBER, W_NONE, 40, NUM_WORD | NUM_TENS},
+    {"fourty", TOK_NUMBER, W_NONE, 40, NUM_WORD | NUM_TENS},
+    {"fifty", TOK_NUMBER, W_NONE, 50, NUM_WORD | NUM_TENS},
+    {"sixty", TOK_NUMBER, W_NONE, 60, NUM_WORD | NUM_TENS},
+    {"seventy", TOK_NUMBER, W_NONE, 70, NUM_WORD | NUM_TENS},
+    {"eighty", TOK_NUMBER, W_NONE, 80, NUM_WORD | NUM_TENS},
+    {"ninety", TOK_NUMBER, W_NONE, 90, NUM_WORD | NUM_TENS},
+};
+
+static void lex_word(Token *tok, const char *word) {
+    tok->kind = TOK_OTHER;
+    for (size_t i = 0; i < sizeof(lexicon) / sizeof(lexicon[0]); i++) {
+        if (strcmp(lexicon[i].text, word) == 0) {
+            tok->kind = lexicon[i].kind;
+            tok->word = lexicon[i].word;
+            tok->value = lexicon[i].value;
+            tok->flags = lexicon[i].flags;
+            return;
+        }
+    }
+}
+
+// Scan one token starting at lx->p. Digits and letters always split, so
+// "1h30m" lexes as 1 h 30 m and "3pm" as 3 pm.
+static void lex_one(Lexer *lx, Token *tok) {
+    const char *p = lx->p;
+    memset(tok, 0, sizeof(*tok));
+
+    while (*p && !isalnum((unsigned char)*p)) {
+        p++;
+    }
+
+    if (*p == '\0') {
+        tok->kind = TOK_END;
+    } else if (isdigit((unsigned char)*p)) {
+        long whole = 0;
+        int digits = 0;
+        const char *start = p;
+        while (isdigit((unsigned char)*p)) {
+            if (digits < 9) {
+                whole = whole * 10 + (*p - '0');
+            }
+            digits++;
+            p++;
+        }
+
+        if (*p == ':' && isdigit((unsigned char)p[1]) && isdigit((unsigned char)p[2])
+                && !isdigit((unsigned char)p[3])) {
+            tok->kind = TOK_CLOCK;
+            tok->hour = (int)whole;
+            tok->flags = (digits == 2 && start[0] == '0') ? CLOCK_24H : 0;
+            tok->minute = (p[1] - '0') * 10 + (p[2] - '0');
+            p += 3;
+        } else {
+            tok->kind = TOK_NUMBER;
+            tok->value = (double)whole;
+            tok->flags = NUM_DIGITS;
+            if (*p == '.' && isdigit((unsigned char)p[1])) {
+                double scale = 0.1;
+                p++;
+                while (isdigit((unsigned char)*p)) {
+                    tok->value += (*p - '0') * scale;
+                    scale *= 0.1;
+                    p++;
+                }
+            }
+        }
+    } else {
+        // Letters, keeping inner apostrophes and dots out of the word
+        // so that "o'clock" and "p.m." match the lexicon
+        char word[NL_WORD_MAX];
+        size_t len = 0;
+        bool overflow = false;
+        while (isalpha((unsigned char)*p)
+                || ((*p == '\'' || *p == '.') && isalpha((unsigned char)p[1]))) {
+            if (isalpha((unsigned char)*p)) {
+                if (len < sizeof(word) - 1) {
+                    word[len++] = (char)tolower((unsigned char)*p);
+                } else {
+                    overflow = true;
+                }
+            }
+            p++;
+        }
+        if (*p == '.' && len == 2 && (word[1] == 'm')) {
+            p++;   // trailing dot of "a.m." / "p.m."
+        }
+        word[len] = '\0';
+
+        if (overflow) {
+            tok->kind = TOK_OTHER;
+        } else {
+            lex_word(tok, word);
+        }
+    }
+
+    lx->p = p;
+}
+
+static const Token *peek(Lexer *lx, int k) {
+    while (lx->count <= k) {
+        Token *slot = &lx->ring[(lx->head + lx->count) % NL_LOOKAHEAD];
+        lex_one(lx, slot);
+        lx->count++;
+    }
+    return &lx->ring[(lx->head + k) % NL_LOOKAHEAD];
+}
+
+static void advance(Lexer *lx) {
+    peek(lx, 0);
+    if (lx->ring[lx->head].kind == TOK_END) {
+        return;
+    }
+    lx->head = (lx->head + 1) % NL_LOOKAHEAD;
+    lx->count--;
+}
+
+static bool is_word(const Token *tok, WordId word) {
+    return tok->kind == TOK_WORD && tok->word == word;
+}
+
+static bool is_article(const Token *tok) {
+    return tok->kind == TOK_NUMBER && (tok->flags & NUM_ARTICLE);
+}
+
+static int unit_seconds(const Token *tok) {
+    if (tok->kind != TOK_WORD) return 0;
+    switch (tok->word) {
+        case W_SECOND: return 1;
+        case W_MINUTE: return 60;
+        case W_HOUR: return 3600;
+        default: return 0;
+    }
+}
+
+static bool is_fraction(const Token *tok) {
+    return is_word(tok, W_HALF) || is_word(tok, W_QUARTER);
+}
+
+static double fraction_value(const Token *tok) {
+    return is_word(tok, W_HALF) ? 0.5 : 0.25;
+}
+
+// quantity := number [ones] ["and" ["a"] fraction] [fraction] ["of"] ["a"]
+// Covers "90", "1.5", "twenty five", "one and a half", "half an",
+// "a quarter of an", "three quarters of an" and "a couple of".
+static bool read_quantity(Lexer *lx, double *out, unsigned *flags) {
+    const Token *tok = peek(lx, 0);
+    double value = 1;
+    *flags = 0;
+
+    if (tok->kind == TOK_NUMBER) {
+        value = tok->value;
+        *flags = tok->flags;
+        advance(lx);
+
+        tok = peek(lx, 0);
+        if ((*flags & NUM_TENS) && tok->kind == TOK_NUMBER && (tok->flags & NUM_WORD)
+                && !(tok->flags & NUM_ARTICLE) && tok->value > 0 && tok->value < 10) {
+            value += tok->value;
+            advance(lx);
+        } else if ((*flags & NUM_ARTICLE) && tok->kind == TOK_NUMBER
+                && (tok->flags & NUM_WORD) && !(tok->flags & NUM_ARTICLE)) {
+            // "a couple"
+            value = tok->value;
+            *flags = tok->flags;
+            advance(lx);
+        }
+    } else if (!is_fraction(tok)) {
+        return false;
+    }
+
+    // "one and a half hours": only taken when a unit follows the fraction
+    if (is_word(peek(lx, 0), W_AND)) {
+        int k = is_article(peek(lx, 1)) ? 2 : 1;
+        if (is_fraction(peek(lx, k)) && unit_seconds(peek(lx, k + 1))) {
+            value += fraction_value(peek(lx, k));
+            for (int i = 0; i <= k; i++) {
+                advance(lx);
+            }
+        }
+    }
+
+    if (is_fraction(peek(lx, 0))) {
+        value *= fraction_value(peek(lx, 0));
+        advance(lx);
+        *flags &= ~(unsigned)NUM_DIGITS;
+    }
+    if (is_word(peek(lx, 0), W_OF)) {
+        advance(lx);
+    }
+    if (is_article(peek(lx, 0))) {
+        advance(lx);
+    }
+
+    *out = value;
+    return true;
+}
+
+// duration := term { ["and"] term } ["and" ["a"] fraction]
+// term     := quantity ["more"] unit
+static bool parse_duration(Lexer *lx, double *seconds, bool *unitless) {
+    double total = 0;
+    int last_unit = 0;
+    int terms = 0;
+    *unitless = false;
+
+    for (;;) {
+        double quantity;
+        unsigned flags;
+
+        if (terms > 0) {
+            // "an hour and a half" / "1 hour and 15 minutes"
+            int k = is_word(peek(lx, 0), W_AND) ? 1 : 0;
+            if (k == 1 && (is_fraction(peek(lx, 1))
+                    || (is_article(peek(lx, 1)) && is_fraction(peek(lx, 2))))) {
+                advance(lx);
+                if (is_article(peek(lx, 0))) {
+                    advance(lx);
+                }
+                total += fraction_value(peek(lx, 0)) * last_unit;
+                advance(lx);
+                break;
+            }
+            const Token *next = peek(lx, k);
+            if (next->kind != TOK_NUMBER && !is_fraction(next)) {
+                break;
+            }
+            if (next->kind == TOK_NUMBER && !(next->flags & NUM_ARTICLE)
+                    && !unit_seconds(peek(lx, k + 1)) && !is_fraction(peek(lx, k + 1))
+                    && !is_word(peek(lx, k + 1), W_AND) && last_unit > 1
+                    && (next->flags & NUM_DIGITS)) {
+                // "1 hour 30" / "1h30": trailing number takes the next smaller unit
+                total += next->value * (last_unit / 60);
+                if (k) advance(lx);
+                advance(lx);
+                break;
+            }
+            if (k) {
+                advance(lx);
+            }
+        }
+
+        if (!read_quantity(lx, &quantity, &flags)) {
+            break;
+        }
+        // "give me 5 more minutes"
+        if (is_word(peek(lx, 0), W_MORE) && unit_seconds(peek(lx, 1))) {
+            advance(lx);
+        }
+
+        int unit = unit_seconds(peek(lx, 0));
+        if (!unit) {
+            if (terms == 0 && (flags & NUM_DIGITS)) {
+                // Bare number such as "delay 30": minutes by convention
+                total = quantity * 60;
+                *unitless = true;
+                terms++;
+            }
+            break;
+        }
+        advance(lx);
+
+        total += quantity * unit;
+        last_unit = unit;
+        terms++;
+    }
+
+    *seconds = total;
+    return terms > 0;
+}
+
+static time_t next_occurrence(time_t now, int hour, int minute) {
+    struct tm tm = *localtime(&now);
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    time_t t = mktime(&tm);
+    if (t <= now) {
+        tm = *localtime(&now);
+        tm.tm_mday += 1;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        t = mktime(&tm);
+    }
+    return t;
+}
+
+// Resolve a wall-clock time to the next matching instant. Without am/pm a
+// 12-hour reading ("until 3") picks whichever of 03:00/15:00 comes first.
+static time_t resolve_clock(time_t now, int hour, int minute, int meridiem) {
+    if (meridiem == W_AM) {
+        return next_occurrence(now, hour % 12, minute);
+    }
+    if (meridiem == W_PM) {
+        return next_occurrence(now, hour % 12 + 12, minute);
+    }
+    if (hour == 24) {
+        return next_occurrence(now, 0, minute);
+    }
+    if (hour >= 1 && hour <= 12) {
+        time_t morning = next_occurrence(now, hour % 12, minute);
+        time_t evening = next_occurrence(now, hour % 12 + 12, minute);
+        return morning < evening ? morning : evening;
+    }
+    return next_occurrence(now, hour, minute);
+}
+
+// clock := (H:MM | number) ["oclock"] ["am" | "pm"] | "noon" | "midnight"
+// A bare number only counts as a clock time after "until"/"at" or when
+// followed by am/pm/o'clock.
+static bool parse_clock(Lexer *lx, time_t now, bool context, time_t *deadline) {
+    const Token *tok = peek(lx, 0);
+    int hour, minute = 0;
+
+    if (is_word(tok, W_NOON) || is_word(tok, W_MIDNIGHT)) {
+        *deadline = next_occurrence(now, is_word(tok, W_NOON) ? 12 : 0, 0);
+        advance(lx);
+        return true;
+    }
+
+    if (tok->kind == TOK_CLOCK) {
+        hour = tok->hour;
+        minute = tok->minute;
+        if (tok->flags & CLOCK_24H) {
+            // Already unambiguous: pick the next 24-hour occurrence
+            if (hour > 23 || minute > 59) {
+                return false;
+            }
+            int k = is_word(peek(lx, 1), W_OCLOCK) ? 2 : 1;
+            for (int i = 0; i < k; i++) {
+                advance(lx);
+            }
+            *deadline = next_occurrence(now, hour, minute);
+            return true;
+        }
+    } else if (tok->kind == TOK_NUMBER && !(tok->flags & NUM_ARTICLE)
+            && tok->value == (int)tok->value) {
+        hour = (int)tok->value;
+    } else {
+        return false;
+    }
+
+    const Token *next = peek(lx, 1);
+    int k = 1;
+    if (is_word(next, W_OCLOCK)) {
+        next = peek(lx, ++k);
+    }
+    int meridiem = 0;
+    if (is_word(next, W_AM) || is_word(next, W_PM)) {
+        meridiem = next->word;
+        k++;
+    }
+
+    bool explicit_clock = tok->kind == TOK_CLOCK || meridiem || k > 1;
+    if (!context && !explicit_clock) {
+        return false;
+    }
+    if (hour > 24 || minute > 59 || (meridiem && (hour < 1 || hour > 12))) {
+        return false;
+    }
+
+    for (int i = 0; i < k; i++) {
+        advance(lx);
+    }
+    *deadline = resolve_clock(now, hour, minute, meridiem);
+    return true;
+}
+
+bool nl_parse_time(const char *text, time_t now, NLTimeExpr *out) {
+    Lexer lx = {0};
+    NLTimeExpr unitless = {0};
+    bool slot = false;      // the previous token expects a duration
+
+    memset(out, 0, sizeof(*out));
+    if (!text) {
+        return false;
+    }
+    lx.p = text;
+
+    while (peek(&lx, 0)->kind != TOK_END) {
+        const Token *tok = peek(&lx, 0);
+        time_t deadline;
+        double seconds;
+        bool bare;
+
+        // "until 3pm", "at 15:30", "till noon". "by" only introduces an
+        // explicit clock time, since "reschedule by 5" means five minutes.
+        if (is_word(tok, W_UNTIL) || is_word(tok, W_AT) || is_word(tok, W_BY)) {
+            bool context = !is_word(tok, W_BY);
+            slot = !context;
+            const Token *arg = peek(&lx, 1);
+            bool is_duration = arg->kind == TOK_NUMBER && unit_seconds(peek(&lx, 2));
+            if (!is_duration) {
+                advance(&lx);
+                if (parse_clock(&lx, now, context, &deadline)) {
+                    out->kind = NL_TIME_DEADLINE;
+                    out->deadline = deadline;
+                    out->duration_seconds = (int)(deadline - now);
+                    return true;
+                }
+                continue;
+            }
+            advance(&lx);
+            continue;
+        }
+
+        // "1:30 hours" is a duration, any other H:MM is a clock time
+        if (tok->kind == TOK_CLOCK && unit_seconds(peek(&lx, 1)) == 3600) {
+            seconds = tok->hour * 3600.0 + tok->minute * 60.0;
+            advance(&lx);
+            advance(&lx);
+            if (seconds > NL_MAX_SECONDS) seconds = NL_MAX_SECONDS;
+            out->kind = NL_TIME_DURATION;
+            out->duration_seconds = (int)seconds;
+            out->deadline = now + out->duration_seconds;
+            return true;
+        }
+
+        if (parse_clock(&lx, now, false, &deadline)) {
+            out->kind = NL_TIME_DEADLINE;
+            out->deadline = deadline;
+            out->duration_seconds = (int)(deadline - now);
+            return true;
+        }
+
+        if (tok->kind == TOK_NUMBER || is_fraction(tok)) {
+            bool after_slot = slot;
+            slot = false;
+            if (parse_duration(&lx, &seconds, &bare)) {
+                if (seconds > NL_MAX_SECONDS) seconds = NL_MAX_SECONDS;
+                if (seconds < 0) seconds = 0;
+                if (!bare) {
+                    out->kind = NL_TIME_DURATION;
+                    out->duration_seconds = (int)(seconds + 0.5);
+                    out->deadline = now + out->duration_seconds;
+                    return true;
+                }
+                // Keep scanning: a number with a unit later wins over a bare one.
+                // A bare number only counts where a duration is expected, so
+                // "set volume to 40" has none.
+                if (after_slot && unitless.kind == NL_TIME_NONE) {
+                    unitless.kind = NL_TIME_DURATION;
+                    unitless.duration_seconds = (int)(seconds + 0.5);
+                    unitless.deadline = now + unitless.duration_seconds;
+                    unitless.unitless = true;
+                }
+            }
+            continue;
+        }
+
+        slot = is_word(tok, W_SLOT);
+        advance(&lx);
+    }
+
+    *out = unitless;
+    return out->kind != NL_TIME_NONE;
+}
+
+int nl_time_minutes(const NLTimeExpr *expr) {
+    if (expr->duration_seconds <= 0) {
+        return 0;
+    }
+    return (expr->duration_seconds + 59) / 60;
+}
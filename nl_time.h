@@ -0,0 +1,30 @@
+#ifndef NL_TIME_H
+#define NL_TIME_H
+
+#include <stdbool.h>
+#include <time.h>
+
+// Kind of time expression found in a natural language command
+typedef enum {
+    NL_TIME_NONE = 0,
+    NL_TIME_DURATION,   // "1h30m", "half an hour", "for twenty five minutes"
+    NL_TIME_DEADLINE    // "until 3pm", "till 15:30", "by noon"
+} NLTimeKind;
+
+typedef struct {
+    NLTimeKind kind;
+    int duration_seconds;   // normalized length; for deadlines, seconds from now
+    time_t deadline;        // absolute end time (now + duration for durations)
+    bool unitless;          // bare number without a unit ("delay 30", "for 20"), taken as
+                            // minutes; only after "for", "in", "by" or a timer verb
+} NLTimeExpr;
+
+// Parse the first duration or clock-time expression in text.
+// Runs in a single pass over the input and never allocates.
+// Returns true and fills out if an expression was found.
+bool nl_parse_time(const char *text, time_t now, NLTimeExpr *out);
+
+// Parsed length rounded up to whole minutes
+int nl_time_minutes(const NLTimeExpr *expr);
+
+#endif
@@ -0,0 +1,87 @@
+// Corpus test for the NL time-expression grammar.
+// Usage: nl_time_test [corpus.tsv]
+//
+// Each corpus line is "<expected>\t<phrase>", where expected is one of
+//   -            no time expression
+//   D<seconds>   duration with an explicit unit
+//   U<seconds>   bare number, read as minutes
+//   T<HH:MM>     deadline later today, T<HH:MM>+1 for tomorrow
+// Phrases are parsed as if it were 2025-06-11 10:00 local time.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "nl_time.h"
+
+#define MAX_LINE_LENGTH 512
+
+static time_t corpus_now(void) {
+    struct tm tm = {0};
+    tm.tm_year = 2025 - 1900;
+    tm.tm_mon = 5;
+    tm.tm_mday = 11;
+    tm.tm_hour = 10;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static void describe(const NLTimeExpr *expr, time_t now, char *buf, size_t size) {
+    if (expr->kind == NL_TIME_NONE) {
+        snprintf(buf, size, "-");
+    } else if (expr->kind == NL_TIME_DURATION) {
+        snprintf(buf, size, "%c%d", expr->unitless ? 'U' : 'D', expr->duration_seconds);
+    } else {
+        struct tm today = *localtime(&now);
+        struct tm due = *localtime(&expr->deadline);
+        int days = due.tm_yday - today.tm_yday;
+        if (days > 0) {
+            snprintf(buf, size, "T%02d:%02d+%d", due.tm_hour, due.tm_min, days);
+        } else {
+            snprintf(buf, size, "T%02d:%02d", due.tm_hour, due.tm_min);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "nl_time_corpus.tsv";
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+
+    time_t now = corpus_now();
+    char line[MAX_LINE_LENGTH];
+    int total = 0, failed = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        char *tab = strchr(line, '\t');
+        if (!tab) {
+            fprintf(stderr, "malformed corpus line: %s\n", line);
+            failed++;
+            continue;
+        }
+        *tab = '\0';
+        const char *expected = line;
+        const char *phrase = tab + 1;
+
+        NLTimeExpr expr;
+        char actual[32];
+        nl_parse_time(phrase, now, &expr);
+        describe(&expr, now, actual, sizeof(actual));
+
+        total++;
+        if (strcmp(expected, actual) != 0) {
+            printf("FAIL: \"%s\": expected %s, got %s\n", phrase, expected, actual);
+            failed++;
+        }
+    }
+    fclose(file);
+
+    printf("nl_time: %d/%d phrasings passed\n", total - failed, total);
+    return failed ? 1 : 0;
+}
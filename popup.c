@@ -1,90 +1,557 @@
-#include <gtk/gtk.h>
-#include <unistd.h>
-#include <sys/wait.h>
+#define _DEFAULT_SOURCE
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
 #include "popup.h"
+#include "popup_protocol.h"
+#include "popup_dbus.h"
+#include "event_loop.h"
+
+// One long-lived renderer keeps its GTK display connection, window and CSS,
+// so a popup costs one message instead of a fork and gtk_init. It is a
+// separate binary, so the daemon itself never loads GTK.
+static int renderer_fd = -1;
+
+// Renderer processes are supervised from the event loop: a pidfd per child
+// reaps it the moment it exits, and one timerfd drives both the hang
+// watchdog and the grace period of a child asked to stop. Nothing waits.
+#define MAX_CHILDREN 4                  // the running renderer plus ones still exiting
+#define RENDERER_HANG_GRACE_MS 2000     // after the last popup's end, before the ping
+#define RENDERER_PING_TIMEOUT_MS 2000   // no pong by then: hung, killed
+#define RENDERER_STOP_GRACE_MS 2000     // to exit after losing its socket, then SIGKILL
+
+typedef struct {
+    pid_t pid;                  // 0 for a free slot
+    int pidfd;                  // -1 without pidfd_open (Linux < 5.3): reaped by the watchdog
+    int signal_sent;            // what we stopped it with, 0 if we did not
+    int64_t kill_at_ns;         // SIGKILL if still running then, 0 while it is the renderer
+} Child;
+
+static Child children[MAX_CHILDREN];
+static Child *renderer = NULL;
+static int watchdog_fd = -1;
+static int64_t busy_until_ns = 0;       // end of the last popup sent, plus grace
+static int64_t ping_deadline_ns = 0;    // 0 while no ping is outstanding
+static uint32_t ping_id = 0;
+
+// Routines queued or playing in the renderer, so each gets exactly one
+// callback even if the renderer is lost
+#define MAX_OPEN_ROUTINES 4
+
+typedef struct {
+    unsigned int id;            // 0 for a free slot
+    int64_t started_ns;
+    PopupRoutineCallback callback;
+} OpenRoutine;
+
+static OpenRoutine open_routines[MAX_OPEN_ROUTINES];
+static unsigned int last_routine_id = 0;
+
+const long long popup_latency_bounds_us[POPUP_LATENCY_BUCKETS - 1] = {
+    1000, 2000, 4000, 8000, 16000, 32000, 64000, 128000, 256000, 512000, 1024000, 2048000, 4096000
+};
+
+static PopupBackend backend = POPUP_BACKEND_GTK;
+static bool dbus_tried = false;     // the bus is given one chance per run
+
+static PopupStats stats = { .renderer_last_status = -1 };
+static int64_t renderer_forked_ns = 0;
+static PopupShownCallback shown_callback = NULL;
+
+static void record_shown(const PopupEvent *event) {
+    long long latency_us = (event->drawn_ns - event->requested_ns) / 1000;
+    if (latency_us < 0) {
+        latency_us = 0;
+    }
+
+    int bucket = 0;
+    while (bucket < POPUP_LATENCY_BUCKETS - 1 && latency_us > popup_latency_bounds_us[bucket]) {
+        bucket++;
+    }
+    stats.buckets[bucket]++;
+    stats.shown++;
+    stats.latency_sum_us += latency_us;
+    stats.queued_sum_us += (event->received_ns - event->requested_ns) / 1000;
+    if (latency_us > stats.latency_max_us) {
+        stats.latency_max_us = latency_us;
+    }
+
+    if (shown_callback) {
+        PopupKind kind = event->kind < POPUP_KIND_COUNT ? (PopupKind)event->kind : POPUP_KIND_STATUS;
+        shown_callback(kind, latency_us, event->mapped_ns != 0);
+    }
+}
+
+void popup_get_stats(PopupStats *out) {
+    *out = stats;
+    out->renderer_pid = renderer ? renderer->pid : 0;
+    out->backend = popup_dbus_is_open() ? POPUP_BACKEND_DBUS : POPUP_BACKEND_GTK;
+}
+
+static const char *const backend_names[] = {"gtk", "dbus", "auto"};
+
+void popup_set_backend(PopupBackend choice) {
+    backend = choice;
+}
+
+bool popup_backend_from_name(const char *name, PopupBackend *out) {
+    for (int i = 0; i <= POPUP_BACKEND_AUTO; i++) {
+        if (strcmp(name, backend_names[i]) == 0) {
+            *out = (PopupBackend)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *popup_backend_name(PopupBackend which) {
+    return which <= POPUP_BACKEND_AUTO ? backend_names[which] : "?";
+}
+
+long long popup_latency_percentile_us(const PopupStats *from, int percentile) {
+    if (from->shown == 0) {
+        return -1;
+    }
+    unsigned long long target = ((unsigned long long)from->shown * percentile + 99) / 100;
+    unsigned long long seen = 0;
+    for (int i = 0; i < POPUP_LATENCY_BUCKETS - 1; i++) {
+        seen += from->buckets[i];
+        if (seen >= target) {
+            return popup_latency_bounds_us[i];
+        }
+    }
+    return from->latency_max_us;
+}
+
+void popup_set_shown_callback(PopupShownCallback callback) {
+    shown_callback = callback;
+}
+
+static void finish_routine(OpenRoutine *routine, bool completed, int elapsed_seconds) {
+    PopupRoutineCallback callback = routine->callback;
+    unsigned int id = routine->id;
+    routine->id = 0;
+    routine->callback = NULL;
+    if (callback) {
+        callback(id, completed, elapsed_seconds);
+    }
+}
+
+static OpenRoutine *find_routine(unsigned int id) {
+    for (int i = 0; i < MAX_OPEN_ROUTINES; i++) {
+        if (open_routines[i].id == id && id != 0) {
+            return &open_routines[i];
+        }
+    }
+    return NULL;
+}
+
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static void arm_watchdog(void) {
+    int64_t next = 0;
+    if (renderer) {
+        next = ping_deadline_ns ? ping_deadline_ns : busy_until_ns;
+    }
+    for (int i = 0; i < MAX_CHILDREN; i++) {
+        if (children[i].pid && children[i].kill_at_ns && (!next || children[i].kill_at_ns < next)) {
+            next = children[i].kill_at_ns;
+        }
+    }
+
+    // it_value of zero would disarm, so a deadline already past fires in 1ms
+    struct itimerspec spec = {0};
+    if (next) {
+        int64_t delay_ns = next - popup_now_ns();
+        if (delay_ns < 1000000) {
+            delay_ns = 1000000;
+        }
+        spec.it_value.tv_sec = delay_ns / 1000000000LL;
+        spec.it_value.tv_nsec = delay_ns % 1000000000LL;
+    }
+    timerfd_settime(watchdog_fd, 0, &spec, NULL);
+}
+
+static void lose_renderer_socket(void) {
+    if (renderer_fd >= 0) {
+        event_loop_remove(renderer_fd);
+        close(renderer_fd);
+        renderer_fd = -1;
+    }
+    busy_until_ns = 0;
+    ping_deadline_ns = 0;
+    for (int i = 0; i < MAX_OPEN_ROUTINES; i++) {
+        if (open_routines[i].id) {
+            finish_routine(&open_routines[i], false,
+                           (int)((popup_now_ns() - open_routines[i].started_ns) / 1000000000LL));
+        }
+    }
+}
+
+// Exit status of a child; false while it is still running
+static bool reap_child(Child *child) {
+    int status;
+    pid_t pid = waitpid(child->pid, &status, WNOHANG);
+    if (pid == 0 || (pid < 0 && errno == EINTR)) {
+        return false;
+    }
+    if (pid == child->pid) {
+        stats.renderer_exits++;
+        stats.renderer_last_status = status;
+        // A crash: killed by a signal we did not send, or a failing exit
+        // (display gone, exec failed) that nobody asked for
+        if ((WIFSIGNALED(status) && WTERMSIG(status) != child->signal_sent) ||
+            (WIFEXITED(status) && WEXITSTATUS(status) != 0 && !child->signal_sent)) {
+            stats.renderer_crashes++;
+        }
+    }
+    if (child->pidfd >= 0) {
+        event_loop_remove(child->pidfd);
+        close(child->pidfd);
+    }
+    if (child == renderer) {
+        // Died under us; its socket may not have reported the hangup yet
+        renderer = NULL;
+        lose_renderer_socket();
+    }
+    memset(child, 0, sizeof(*child));
+    child->pidfd = -1;
+    return true;
+}
+
+static void on_child_exit(int fd, short revents, void *data) {
+    (void)fd;
+    (void)revents;
+    reap_child(data);
+}
+
+// Let the renderer go: close its socket, which makes it quit, and keep the
+// process supervised until it is reaped. With signo it is also signalled.
+static void stop_renderer(int signo) {
+    lose_renderer_socket();
+    if (!renderer) {
+        return;
+    }
+    Child *child = renderer;
+    renderer = NULL;
+    if (signo) {
+        child->signal_sent = signo;
+        kill(child->pid, signo);
+    }
+    if (!reap_child(child)) {
+        child->kill_at_ns = popup_now_ns() + RENDERER_STOP_GRACE_MS * 1000000LL;
+    }
+    arm_watchdog();
+}
 
-static pid_t current_popup_pid = 0;
+static void on_watchdog(int fd, short revents, void *data) {
+    (void)revents;
+    (void)data;
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        return;
+    }
+    int64_t now = popup_now_ns();
+
+    for (int i = 0; i < MAX_CHILDREN; i++) {
+        Child *child = &children[i];
+        if (!child->pid || !child->kill_at_ns || reap_child(child) || now < child->kill_at_ns) {
+            continue;
+        }
+        // Did not exit in time; without a pidfd, come back to reap it
+        if (child->signal_sent != SIGKILL) {
+            stats.renderer_hangs++;
+            child->signal_sent = SIGKILL;
+            kill(child->pid, SIGKILL);
+        }
+        child->kill_at_ns = now + RENDERER_STOP_GRACE_MS * 1000000LL;
+    }
+
+    if (renderer && ping_deadline_ns && now >= ping_deadline_ns) {
+        // Its main loop has not run for the whole timeout
+        stats.renderer_hangs++;
+        fprintf(stderr, "Popup renderer %d stopped responding, restarting it\n", (int)renderer->pid);
+        stop_renderer(SIGKILL);
+        return;
+    }
+    if (renderer && !ping_deadline_ns && busy_until_ns && now >= busy_until_ns) {
+        // Every popup sent should be over: check the renderer is still with us
+        PopupRequest ping = {0};
+        ping.type = POPUP_REQUEST_PING;
+        ping.id = ++ping_id;
+        busy_until_ns = 0;
+        if (send(renderer_fd, &ping, POPUP_REQUEST_HEADER_SIZE + 1, MSG_DONTWAIT | MSG_NOSIGNAL) > 0) {
+            ping_deadline_ns = now + RENDERER_PING_TIMEOUT_MS * 1000000LL;
+        }
+    }
+    arm_watchdog();
+}
+
+// Events from either backend
+static void handle_event(const PopupEvent *event) {
+    OpenRoutine *routine;
+    switch (event->type) {
+        case POPUP_EVENT_ROUTINE_DONE:
+            if ((routine = find_routine(event->id))) {
+                finish_routine(routine, event->completed != 0, (int)(event->elapsed_ms / 1000));
+            }
+            break;
+        case POPUP_EVENT_SHOWN:
+            record_shown(event);
+            break;
+        case POPUP_EVENT_READY:
+            stats.renderer_starts++;
+            stats.renderer_child_us = (event->received_ns - renderer_forked_ns) / 1000;
+            stats.renderer_ready_us = (event->drawn_ns - renderer_forked_ns) / 1000;
+            break;
+        case POPUP_EVENT_PONG:
+            if (event->id == ping_id) {
+                ping_deadline_ns = 0;
+                arm_watchdog();
+            }
+            break;
+    }
+}
+
+static void on_renderer_readable(int fd, short revents, void *data) {
+    (void)data;
+    PopupEvent event;
+    ssize_t n = recv(fd, &event, sizeof(event), MSG_DONTWAIT);
+
+    if (n == (ssize_t)sizeof(event)) {
+        handle_event(&event);
+        return;
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR) || (revents & (POLLHUP | POLLERR))) {
+        // It closed the socket, so it is on its way out; started again by the next popup
+        stop_renderer(0);
+    }
+}
+
+// Runs in the forked child: restly-popup next to our own binary, else from PATH
+static void exec_renderer(int fd) {
+    char fd_arg[16];
+    snprintf(fd_arg, sizeof(fd_arg), "%d", fd);
 
-static gboolean on_window_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
-    cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.0);
-    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
-    cairo_paint(cr);
-    return FALSE; // allow normal drawing (CSS backgrounds on children)
+    char path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len > 0) {
+        path[len] = '\0';
+        char *slash = strrchr(path, '/');
+        if (slash && (size_t)(slash + 1 - path) + sizeof(POPUP_RENDERER_BINARY) <= sizeof(path)) {
+            memcpy(slash + 1, POPUP_RENDERER_BINARY, sizeof(POPUP_RENDERER_BINARY));
+            execl(path, POPUP_RENDERER_BINARY, "--fd", fd_arg, (char *)NULL);
+        }
+    }
+    execlp(POPUP_RENDERER_BINARY, POPUP_RENDERER_BINARY, "--fd", fd_arg, (char *)NULL);
+    fprintf(stderr, "Failed to run %s: %s\n", POPUP_RENDERER_BINARY, strerror(errno));
 }
 
-void show_popup(const char *message, int gtk_dur) {
-    // Kill previous popup if it exists
-    if (current_popup_pid > 0) {
-        kill(current_popup_pid, SIGTERM);
-        waitpid(current_popup_pid, NULL, 0);
-        current_popup_pid = 0;
+static bool start_renderer(void) {
+    if (renderer_fd >= 0) {
+        return true;
+    }
+
+    Child *child = NULL;
+    for (int i = 0; !child && i < MAX_CHILDREN; i++) {
+        if (!children[i].pid) {
+            child = &children[i];
+        }
+    }
+    if (!child) {
+        // Earlier renderers still exiting; the watchdog will have killed them soon
+        return false;
+    }
+    if (watchdog_fd < 0) {
+        watchdog_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (watchdog_fd < 0) {
+            fprintf(stderr, "Failed to create popup watchdog: %s\n", strerror(errno));
+            return false;
+        }
+        event_loop_add(watchdog_fd, POLLIN, on_watchdog, NULL);
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) {
+        fprintf(stderr, "Failed to create popup socket: %s\n", strerror(errno));
+        return false;
     }
-    
+
+    renderer_forked_ns = popup_now_ns();
     pid_t pid = fork();
-    
     if (pid == 0) {
-        int argc = 0;
-        char **argv = NULL;
-        unsetenv("DESKTOP_STARTUP_ID");
-        gtk_init(&argc, &argv);
-
-        GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
-        // gtk_window_set_title(GTK_WINDOW(window), "Restly Notification");
-        gtk_window_set_default_size(GTK_WINDOW(window), 300, 100);
-        gtk_window_set_resizable(GTK_WINDOW(window), FALSE);
-        gtk_window_set_decorated(GTK_WINDOW(window), FALSE);
-        gtk_window_set_keep_above(GTK_WINDOW(window), TRUE);
-        gtk_window_set_type_hint(GTK_WINDOW(window), GDK_WINDOW_TYPE_HINT_NOTIFICATION);
-        gtk_window_set_skip_taskbar_hint(GTK_WINDOW(window), TRUE);
-        gtk_window_set_skip_pager_hint(GTK_WINDOW(window), TRUE);
-        gtk_window_set_accept_focus(GTK_WINDOW(window), FALSE);
-        gtk_window_set_focus_on_map(GTK_WINDOW(window), FALSE);
-        gtk_widget_set_app_paintable(window, TRUE);
-        g_signal_connect(window, "draw", G_CALLBACK(on_window_draw), NULL);
-
-        GdkScreen *screen = gdk_screen_get_default();
-        GdkVisual *visual = gdk_screen_get_rgba_visual(screen);
-        if (visual != NULL) {
-            gtk_widget_set_visual(window, visual);
-        }
-
-        GtkWidget *label = gtk_label_new(message);
-        gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
-        gtk_widget_set_valign(label, GTK_ALIGN_CENTER);
-
-        GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-        gtk_widget_set_name(box, "toast");
-        gtk_container_add(GTK_CONTAINER(window), box);
-        gtk_box_pack_start(GTK_BOX(box), label, TRUE, TRUE, 10);
-
-        GtkCssProvider *css = gtk_css_provider_new();
-        gtk_css_provider_load_from_data(css,
-            "#toast { background-color: rgba(245, 250, 255, 0.95); border: 5px solid #a0c4ff; border-radius: 12px; padding: 12px; }"
-            "label { color: black; font-size: 16pt; font-weight: bold; }",
-            -1, NULL);
-        gtk_style_context_add_provider_for_screen(screen, GTK_STYLE_PROVIDER(css), GTK_STYLE_PROVIDER_PRIORITY_USER);
-
-        GdkDisplay *display = gdk_display_get_default();
-        GdkMonitor *monitor = gdk_display_get_primary_monitor(display);
-        GdkRectangle geometry;
-        gdk_monitor_get_geometry(monitor, &geometry);
-
-        int screen_width = geometry.width;
-        int screen_height = geometry.height;
-
-        gint x = screen_width - 320;
-        gint y = screen_height - 120;
-        gtk_window_move(GTK_WINDOW(window), x, y);
-
-        gtk_widget_show_all(window);
-        g_timeout_add_seconds(gtk_dur, (GSourceFunc)gtk_main_quit, NULL);
-
-        gtk_main();
-        exit(0);
-    } 
-    else if (pid > 0) {
-        current_popup_pid = pid;
-    }
-}
\ No newline at end of file
+        close(fds[0]);
+        // The only descriptor the renderer inherits
+        fcntl(fds[1], F_SETFD, 0);
+        exec_renderer(fds[1]);
+        _exit(127);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        fprintf(stderr, "Failed to start popup renderer: %s\n", strerror(errno));
+        close(fds[0]);
+        return false;
+    }
+
+    renderer_fd = fds[0];
+    event_loop_add(renderer_fd, POLLIN, on_renderer_readable, NULL);
+
+    memset(child, 0, sizeof(*child));
+    child->pid = pid;
+    child->pidfd = open_pidfd(pid);
+    if (child->pidfd >= 0) {
+        fcntl(child->pidfd, F_SETFD, FD_CLOEXEC);
+        event_loop_add(child->pidfd, POLLIN, on_child_exit, child);
+    }
+    renderer = child;
+    return true;
+}
+
+bool popup_init(void) {
+    if (popup_dbus_is_open() || renderer_fd >= 0) {
+        return true;
+    }
+    if (backend != POPUP_BACKEND_GTK && !dbus_tried) {
+        dbus_tried = true;
+        if (popup_dbus_open(backend == POPUP_BACKEND_AUTO, handle_event)) {
+            return true;
+        }
+    }
+    return start_renderer();
+}
+
+// The renderer is pinged once this popup should be over
+static void expect_busy_until(const PopupRequest *request) {
+    int64_t until = popup_now_ns() + (request->duration_ms + RENDERER_HANG_GRACE_MS) * 1000000LL;
+    if (until > busy_until_ns) {
+        busy_until_ns = until;
+        arm_watchdog();
+    }
+}
+
+static bool send_request(const PopupRequest *request) {
+    size_t size = POPUP_REQUEST_HEADER_SIZE + strlen(request->text) + 1;
+
+    if (!popup_init()) {
+        return false;
+    }
+    if (popup_dbus_is_open()) {
+        if (popup_dbus_send(request)) {
+            return true;
+        }
+        // Bus or notification server lost: the renderer takes over from here
+        popup_dbus_close();
+        if (!start_renderer()) {
+            return false;
+        }
+    }
+    if (send(renderer_fd, request, size, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)size) {
+        expect_busy_until(request);
+        return true;
+    }
+
+    // A full socket means the renderer is busy; drop the popup rather than block
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return false;
+    }
+
+    // Renderer is gone (crashed, display lost): start a new one and retry once
+    stop_renderer(0);
+    if (start_renderer() && send(renderer_fd, request, size, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)size) {
+        expect_busy_until(request);
+        return true;
+    }
+    return false;
+}
+
+void show_popup(const char *message, int gtk_dur, PopupKind kind) {
+    PopupRequest request = {0};
+    request.type = POPUP_REQUEST_SHOW;
+    request.kind = kind;
+    request.duration_ms = gtk_dur > 0 ? (uint32_t)gtk_dur * 1000 : 0;
+    request.requested_ns = popup_now_ns();
+    strncpy(request.text, message ? message : "", sizeof(request.text) - 1);
+
+    send_request(&request);
+}
+
+unsigned int show_routine(const PopupStep *steps, int count, unsigned int flags,
+                          PopupRoutineCallback callback) {
+    PopupRequest request = {0};
+    request.type = POPUP_REQUEST_ROUTINE;
+    request.kind = POPUP_KIND_ROUTINE;
+    request.flags = flags;
+    request.requested_ns = popup_now_ns();
+
+    // Pack the steps; the separators never occur in popup text
+    size_t len = 0;
+    int packed = 0;
+    for (int i = 0; i < count && i < POPUP_ROUTINE_MAX_STEPS; i++) {
+        int n = snprintf(request.text + len, sizeof(request.text) - len, "%d%c%s%c",
+                         steps[i].seconds * 1000, POPUP_FIELD_SEP, steps[i].text, POPUP_STEP_SEP);
+        if (n < 0 || (size_t)n >= sizeof(request.text) - len) {
+            request.text[len] = '\0';
+            break;
+        }
+        len += n;
+        request.duration_ms += steps[i].seconds * 1000;
+        packed++;
+    }
+    if (packed == 0) {
+        return 0;
+    }
+
+    // The renderer reports every routine, even one replaced while queued,
+    // so a slot frees up quickly; with none free the oldest is given up on
+    OpenRoutine *slot = NULL;
+    for (int i = 0; !slot && i < MAX_OPEN_ROUTINES; i++) {
+        if (!open_routines[i].id) {
+            slot = &open_routines[i];
+        }
+    }
+    if (!slot) {
+        slot = &open_routines[0];
+        for (int i = 1; i < MAX_OPEN_ROUTINES; i++) {
+            if (open_routines[i].started_ns < slot->started_ns) {
+                slot = &open_routines[i];
+            }
+        }
+        finish_routine(slot, false, (int)((popup_now_ns() - slot->started_ns) / 1000000000LL));
+    }
+
+    request.id = ++last_routine_id;
+    if (request.id == 0) {
+        request.id = ++last_routine_id;
+    }
+    if (!send_request(&request)) {
+        return 0;
+    }
+
+    slot->id = request.id;
+    slot->started_ns = request.requested_ns;
+    slot->callback = callback;
+    return slot->id;
+}
+
+void popup_shutdown(void) {
+    popup_dbus_close();
+    stop_renderer(SIGTERM);
+}
@@ -1,6 +1,83 @@
 #ifndef POPUP_H
 #define POPUP_H
 
-void show_popup(const char *message, int gtk_dur);
+#include <stdbool.h>
 
-#endif
\ No newline at end of file
+// Popup priority, lowest first. The renderer queues by kind (popup_queue.h).
+typedef enum {
+    POPUP_KIND_STATUS = 0,      // answers to "status", help text
+    POPUP_KIND_CONFIRMATION,    // a command was applied
+    POPUP_KIND_ROUTINE,         // break messages and routine steps
+    POPUP_KIND_COUNT
+} PopupKind;
+
+// Where popups are drawn. Both notification choices fall back to the GTK
+// renderer when the session bus or a notification server is missing or lost.
+typedef enum {
+    POPUP_BACKEND_GTK = 0,      // our own window, drawn by restly-popup
+    POPUP_BACKEND_DBUS,         // desktop notifications; the bus may start a server
+    POPUP_BACKEND_AUTO          // desktop notifications if a server is already running
+} PopupBackend;
+
+// Before popup_init; the default is POPUP_BACKEND_GTK
+void popup_set_backend(PopupBackend backend);
+bool popup_backend_from_name(const char *name, PopupBackend *backend);
+const char *popup_backend_name(PopupBackend backend);
+
+// Connect the backend; show_popup also does it on first use
+bool popup_init(void);
+// Hand a message to the renderer's queue; returns without waiting for the display
+void show_popup(const char *message, int gtk_dur, PopupKind kind);
+
+// One step of a routine played in a single popup window
+typedef struct {
+    const char *text;
+    int seconds;
+} PopupStep;
+
+// Routine display options
+#define POPUP_ROUTINE_COUNTDOWN 0x1  // seconds left in the current step
+#define POPUP_ROUTINE_PROGRESS  0x2  // bar for the whole routine
+#define POPUP_ROUTINE_RING      0x4  // animated ring for the current step (GTK renderer only)
+
+// Called from the event loop when a routine finishes or is cut short
+typedef void (*PopupRoutineCallback)(unsigned int id, bool completed, int elapsed_seconds);
+
+// Play steps back to back in one window. Returns a routine id for the callback, 0 on failure.
+unsigned int show_routine(const PopupStep *steps, int count, unsigned int flags,
+                          PopupRoutineCallback callback);
+void popup_shutdown(void);
+
+// Time-to-visible (request in the daemon -> first draw in the renderer) as
+// a histogram with power-of-two millisecond buckets, the last one open-ended
+#define POPUP_LATENCY_BUCKETS 14
+
+typedef struct {
+    unsigned int shown;
+    unsigned int buckets[POPUP_LATENCY_BUCKETS];
+    long long latency_sum_us;
+    long long latency_max_us;
+    long long queued_sum_us;        // part of it spent before the renderer read the request
+    unsigned int renderer_starts;
+    int renderer_pid;               // 0 while no renderer is running
+    PopupBackend backend;           // the one in use: GTK or DBUS
+    long long renderer_child_us;    // last start: fork -> restly-popup main()
+    long long renderer_ready_us;    // last start: fork -> window built
+    unsigned int renderer_exits;    // renderers reaped
+    unsigned int renderer_crashes;  // of those, died without being asked to
+    unsigned int renderer_hangs;    // killed: no pong after a popup's end, or slow to exit
+    int renderer_last_status;       // wait status of the last one reaped, -1 before any
+} PopupStats;
+
+// Upper bound of each bucket but the last, in microseconds
+extern const long long popup_latency_bounds_us[POPUP_LATENCY_BUCKETS - 1];
+
+void popup_get_stats(PopupStats *out);
+// Approximate percentile (0-100) from the histogram, -1 if nothing was shown
+long long popup_latency_percentile_us(const PopupStats *stats, int percentile);
+
+// Called from the event loop for every popup once it is on screen
+typedef void (*PopupShownCallback)(PopupKind kind, long long latency_us, bool mapped);
+void popup_set_shown_callback(PopupShownCallback callback);
+
+#endif
@@ -0,0 +1,435 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include "popup_dbus.h"
+#include "popup.h"
+#include "dbus_wire.h"
+#include "event_loop.h"
+
+#define NOTIFICATIONS_NAME "org.freedesktop.Notifications"
+#define NOTIFICATIONS_PATH "/org/freedesktop/Notifications"
+#define NOTIFICATION_SUMMARY "Restly"
+#define SETUP_TIMEOUT_MS 500
+
+// NotificationClosed reasons from the specification
+#define CLOSED_EXPIRED 1
+#define CLOSED_DISMISSED 2
+#define CLOSED_BY_CALL 3
+
+// Notify calls waiting for their id
+#define MAX_PENDING_CALLS 16
+
+typedef struct {
+    uint32_t serial;            // 0 for a free slot
+    uint32_t kind;
+    uint32_t popup_id;
+    int64_t requested_ns;       // 0 for in-place updates, which are not reported as shown
+} PendingNotify;
+
+typedef struct {
+    const char *text;
+    uint32_t duration_ms;
+} DBusRoutineStep;
+
+// The routine playing as one notification; step texts point into text
+typedef struct {
+    uint32_t id;                // 0 when none is playing
+    uint32_t flags;
+    char text[POPUP_TEXT_MAX];
+    DBusRoutineStep steps[POPUP_ROUTINE_MAX_STEPS];
+    int step_count;
+    int current;
+    uint32_t total_ms;
+    uint32_t done_ms;
+    int64_t requested_ns;
+    int64_t started_ns;
+    int64_t step_started_ns;
+} DBusRoutine;
+
+static DBusConnection conn = { .fd = -1 };
+static int watched_fd = -1;
+static int timer_fd = -1;
+static PopupDBusEventHandler event_handler = NULL;
+static uint32_t notification_ids[POPUP_KIND_COUNT];   // 0: none on screen
+static PendingNotify pending[MAX_PENDING_CALLS];
+static int next_pending = 0;
+static DBusRoutine routine;
+
+static void emit(const PopupEvent *event) {
+    if (event_handler) {
+        event_handler(event);
+    }
+}
+
+static bool notify(uint32_t kind, uint32_t popup_id, const char *body, int32_t expire_ms,
+                   int progress, int64_t requested_ns) {
+    DBusHeader header = {
+        .type = DBUS_MESSAGE_METHOD_CALL,
+        .destination = NOTIFICATIONS_NAME,
+        .path = NOTIFICATIONS_PATH,
+        .interface = NOTIFICATIONS_NAME,
+        .member = "Notify",
+        .signature = "susssasa{sv}i"
+    };
+    DBusWriter w;
+    dbus_writer_begin(&w, &header);
+    dbus_put_string(&w, "restly");
+    dbus_put_u32(&w, notification_ids[kind]);
+    dbus_put_string(&w, "");
+    dbus_put_string(&w, NOTIFICATION_SUMMARY);
+    dbus_put_string(&w, body);
+    dbus_close_array(&w, dbus_open_array(&w, 4));      // no actions
+
+    DBusArray hints = dbus_open_array(&w, 8);
+    dbus_open_struct(&w);
+    dbus_put_string(&w, "urgency");
+    dbus_put_signature(&w, "y");
+    dbus_put_byte(&w, kind == POPUP_KIND_STATUS ? 0 : 1);
+    if (kind == POPUP_KIND_STATUS) {
+        // Answers to "status" are not worth keeping in the notification history
+        dbus_open_struct(&w);
+        dbus_put_string(&w, "transient");
+        dbus_put_signature(&w, "b");
+        dbus_put_bool(&w, true);
+    }
+    if (progress >= 0) {
+        dbus_open_struct(&w);
+        dbus_put_string(&w, "value");
+        dbus_put_signature(&w, "i");
+        dbus_put_i32(&w, progress);
+    }
+    dbus_close_array(&w, hints);
+    dbus_put_i32(&w, expire_ms);
+
+    uint32_t serial = dbus_wire_send(&conn, &w);
+    if (!serial) {
+        return false;
+    }
+    pending[next_pending] = (PendingNotify){ serial, kind, popup_id, requested_ns };
+    next_pending = (next_pending + 1) % MAX_PENDING_CALLS;
+    return true;
+}
+
+static void send_close(uint32_t id) {
+    DBusHeader header = {
+        .type = DBUS_MESSAGE_METHOD_CALL,
+        .destination = NOTIFICATIONS_NAME,
+        .path = NOTIFICATIONS_PATH,
+        .interface = NOTIFICATIONS_NAME,
+        .member = "CloseNotification",
+        .signature = "u"
+    };
+    DBusWriter w;
+    dbus_writer_begin(&w, &header);
+    dbus_put_u32(&w, id);
+    dbus_wire_send(&conn, &w);
+}
+
+static void close_notification(uint32_t kind) {
+    if (notification_ids[kind]) {
+        send_close(notification_ids[kind]);
+        notification_ids[kind] = 0;
+    }
+}
+
+static void arm_timer(int64_t delay_ns) {
+    if (delay_ns < 1000000) {
+        delay_ns = 1000000;
+    }
+    struct itimerspec spec = {0};
+    spec.it_value.tv_sec = delay_ns / 1000000000LL;
+    spec.it_value.tv_nsec = delay_ns % 1000000000LL;
+    timerfd_settime(timer_fd, 0, &spec, NULL);
+}
+
+static void end_routine(bool completed) {
+    if (!routine.id) {
+        return;
+    }
+    struct itimerspec off = {0};
+    timerfd_settime(timer_fd, 0, &off, NULL);
+    close_notification(POPUP_KIND_ROUTINE);
+
+    PopupEvent event = {
+        .type = POPUP_EVENT_ROUTINE_DONE,
+        .id = routine.id,
+        .completed = completed,
+        .elapsed_ms = (uint32_t)((popup_now_ns() - routine.started_ns) / 1000000)
+    };
+    routine.id = 0;
+    emit(&event);
+}
+
+// (Re)send the current step: text, seconds left and overall progress as
+// asked for, then wake up for the next second or the end of the step
+static bool show_routine_step(bool first) {
+    const DBusRoutineStep *step = &routine.steps[routine.current];
+    int64_t now = popup_now_ns();
+    uint32_t step_elapsed = (uint32_t)((now - routine.step_started_ns) / 1000000);
+    if (step_elapsed > step->duration_ms) {
+        step_elapsed = step->duration_ms;
+    }
+
+    char body[POPUP_TEXT_MAX + 16];
+    if (routine.flags & POPUP_ROUTINE_COUNTDOWN) {
+        snprintf(body, sizeof(body), "%s\n%u s", step->text, (step->duration_ms - step_elapsed + 999) / 1000);
+    } else {
+        snprintf(body, sizeof(body), "%s", step->text);
+    }
+    int progress = -1;
+    if ((routine.flags & POPUP_ROUTINE_PROGRESS) && routine.total_ms > 0) {
+        progress = (int)((uint64_t)(routine.done_ms + step_elapsed) * 100 / routine.total_ms);
+    }
+
+    uint32_t wake_ms = step->duration_ms - step_elapsed;
+    if ((routine.flags & (POPUP_ROUTINE_COUNTDOWN | POPUP_ROUTINE_PROGRESS)) && wake_ms > 1000) {
+        wake_ms = 1000 - step_elapsed % 1000;
+    }
+    arm_timer((int64_t)wake_ms * 1000000);
+
+    return notify(POPUP_KIND_ROUTINE, routine.id, body, 0, progress, first ? routine.requested_ns : 0);
+}
+
+static void on_timer(int fd, short revents, void *data) {
+    (void)revents;
+    (void)data;
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations) || !routine.id) {
+        return;
+    }
+
+    const DBusRoutineStep *step = &routine.steps[routine.current];
+    int64_t step_end = routine.step_started_ns + (int64_t)step->duration_ms * 1000000;
+    if (popup_now_ns() >= step_end) {
+        routine.done_ms += step->duration_ms;
+        if (++routine.current >= routine.step_count) {
+            end_routine(true);
+            return;
+        }
+        routine.step_started_ns = step_end;
+    }
+    show_routine_step(false);
+}
+
+// Unpack "<ms>\x1f<text>\x1e..." into routine steps
+static int parse_routine(const char *packed) {
+    snprintf(routine.text, sizeof(routine.text), "%s", packed);
+    routine.step_count = 0;
+    routine.total_ms = 0;
+
+    char *p = routine.text;
+    while (*p && routine.step_count < POPUP_ROUTINE_MAX_STEPS) {
+        char *field = strchr(p, POPUP_FIELD_SEP);
+        if (!field) break;
+        char *end = strchr(field + 1, POPUP_STEP_SEP);
+        if (end) *end = '\0';
+
+        DBusRoutineStep *step = &routine.steps[routine.step_count++];
+        step->duration_ms = (uint32_t)strtoul(p, NULL, 10);
+        step->text = field + 1;
+        routine.total_ms += step->duration_ms;
+
+        if (!end) break;
+        p = end + 1;
+    }
+    return routine.step_count;
+}
+
+static void on_notify_reply(const DBusMessage *message) {
+    for (int i = 0; i < MAX_PENDING_CALLS; i++) {
+        PendingNotify *call = &pending[i];
+        if (call->serial != message->reply_serial || call->serial == 0) {
+            continue;
+        }
+        call->serial = 0;
+        if (message->type == DBUS_MESSAGE_ERROR) {
+            // Nothing on the bus can show notifications: let popup.c fall back
+            if (message->error_name && strcmp(message->error_name, "org.freedesktop.DBus.Error.ServiceUnknown") == 0) {
+                popup_dbus_close();
+            }
+            return;
+        }
+
+        DBusReader reader;
+        dbus_reader_init(&reader, message);
+        uint32_t id = dbus_read_u32(&reader);
+        if (!reader.error) {
+            if (call->kind == POPUP_KIND_ROUTINE && call->popup_id && routine.id != call->popup_id) {
+                // The routine ended before its notification got an id
+                send_close(id);
+            } else {
+                notification_ids[call->kind] = id;
+            }
+        }
+        if (call->requested_ns) {
+            PopupEvent shown = {
+                .type = POPUP_EVENT_SHOWN,
+                .id = call->popup_id,
+                .kind = call->kind,
+                .requested_ns = call->requested_ns,
+                .received_ns = popup_now_ns()
+            };
+            shown.drawn_ns = shown.received_ns;
+            emit(&shown);
+        }
+        return;
+    }
+}
+
+static void on_notification_closed(const DBusMessage *message) {
+    DBusReader reader;
+    dbus_reader_init(&reader, message);
+    uint32_t id = dbus_read_u32(&reader);
+    uint32_t reason = dbus_read_u32(&reader);
+    if (reader.error || id == 0) {
+        return;
+    }
+    for (int kind = 0; kind < POPUP_KIND_COUNT; kind++) {
+        if (notification_ids[kind] != id) {
+            continue;
+        }
+        notification_ids[kind] = 0;
+        // Dismissed or timed out by the server: the routine is no longer visible
+        if (kind == POPUP_KIND_ROUTINE && routine.id && reason != CLOSED_BY_CALL) {
+            end_routine(false);
+        }
+    }
+}
+
+static void on_bus_readable(int fd, short revents, void *data) {
+    (void)fd;
+    (void)data;
+    bool alive = dbus_wire_receive(&conn) && !(revents & (POLLHUP | POLLERR));
+
+    DBusMessage message;
+    while (dbus_wire_next(&conn, &message)) {
+        if (message.type == DBUS_MESSAGE_METHOD_RETURN || message.type == DBUS_MESSAGE_ERROR) {
+            on_notify_reply(&message);
+        } else if (message.type == DBUS_MESSAGE_SIGNAL && message.member && message.interface
+                   && strcmp(message.interface, NOTIFICATIONS_NAME) == 0
+                   && strcmp(message.member, "NotificationClosed") == 0) {
+            on_notification_closed(&message);
+        }
+        if (conn.fd < 0) {
+            break;
+        }
+    }
+    if (!alive || conn.fd < 0) {
+        popup_dbus_close();
+    }
+}
+
+static bool bus_call(const char *member, const char *signature, const char *argument, DBusMessage *reply) {
+    DBusHeader header = {
+        .type = DBUS_MESSAGE_METHOD_CALL,
+        .destination = "org.freedesktop.DBus",
+        .path = "/org/freedesktop/DBus",
+        .interface = "org.freedesktop.DBus",
+        .member = member,
+        .signature = signature
+    };
+    DBusWriter w;
+    dbus_writer_begin(&w, &header);
+    dbus_put_string(&w, argument);
+    return dbus_wire_call(&conn, &w, reply, SETUP_TIMEOUT_MS);
+}
+
+bool popup_dbus_open(bool require_server, PopupDBusEventHandler handler) {
+    if (conn.fd >= 0) {
+        return true;
+    }
+    if (!dbus_wire_open_session(&conn, SETUP_TIMEOUT_MS)) {
+        return false;
+    }
+
+    DBusMessage reply;
+    if (require_server) {
+        DBusReader reader;
+        bool has_owner = bus_call("NameHasOwner", "s", NOTIFICATIONS_NAME, &reply);
+        if (has_owner) {
+            dbus_reader_init(&reader, &reply);
+            has_owner = dbus_read_bool(&reader) && !reader.error;
+        }
+        if (!has_owner) {
+            dbus_wire_close(&conn);
+            return false;
+        }
+    }
+    if (!bus_call("AddMatch", "s",
+                  "type='signal',interface='" NOTIFICATIONS_NAME "',member='NotificationClosed'", &reply)) {
+        dbus_wire_close(&conn);
+        return false;
+    }
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0 || !event_loop_add(timer_fd, POLLIN, on_timer, NULL)
+        || !event_loop_add(conn.fd, POLLIN, on_bus_readable, NULL)) {
+        if (timer_fd >= 0) {
+            event_loop_remove(timer_fd);
+            close(timer_fd);
+            timer_fd = -1;
+        }
+        dbus_wire_close(&conn);
+        return false;
+    }
+    watched_fd = conn.fd;
+    event_handler = handler;
+    memset(notification_ids, 0, sizeof(notification_ids));
+    memset(pending, 0, sizeof(pending));
+    return true;
+}
+
+bool popup_dbus_is_open(void) {
+    return watched_fd >= 0;
+}
+
+void popup_dbus_close(void) {
+    if (watched_fd < 0) {
+        return;
+    }
+    end_routine(false);
+    for (int kind = 0; kind < POPUP_KIND_COUNT; kind++) {
+        close_notification(kind);
+    }
+
+    event_loop_remove(watched_fd);
+    watched_fd = -1;
+    dbus_wire_close(&conn);
+    event_loop_remove(timer_fd);
+    close(timer_fd);
+    timer_fd = -1;
+}
+
+bool popup_dbus_send(const PopupRequest *request) {
+    if (!popup_dbus_is_open()) {
+        return false;
+    }
+
+    if (request->type == POPUP_REQUEST_ROUTINE) {
+        // A new routine replaces the playing one, as in the renderer's queue
+        end_routine(false);
+        if (parse_routine(request->text) == 0) {
+            PopupEvent done = { .type = POPUP_EVENT_ROUTINE_DONE, .id = request->id };
+            emit(&done);
+            return true;
+        }
+        routine.id = request->id;
+        routine.flags = request->flags;
+        routine.current = 0;
+        routine.done_ms = 0;
+        routine.requested_ns = request->requested_ns;
+        routine.started_ns = routine.step_started_ns = popup_now_ns();
+        return show_routine_step(true);
+    }
+
+    uint32_t kind = request->kind < POPUP_KIND_COUNT ? request->kind : POPUP_KIND_STATUS;
+    if (kind == POPUP_KIND_ROUTINE) {
+        end_routine(false);
+    }
+    return notify(kind, request->id, request->text,
+                  request->duration_ms ? (int32_t)request->duration_ms : -1, -1, request->requested_ns);
+}
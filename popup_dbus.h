@@ -0,0 +1,25 @@
+#ifndef POPUP_DBUS_H
+#define POPUP_DBUS_H
+
+#include <stdbool.h>
+#include "popup_protocol.h"
+
+// Popups as desktop notifications (org.freedesktop.Notifications on the
+// session bus), for desktops whose compositor already draws them. Takes the
+// same requests as the renderer and reports the same events, so popup.c can
+// use either. One notification per popup kind is updated in place through
+// replaces_id; a routine is one notification whose steps replace each other.
+
+typedef void (*PopupDBusEventHandler)(const PopupEvent *event);
+
+// Connect once. With require_server the bus must already have a
+// notification server; otherwise the bus may start one on the first call.
+bool popup_dbus_open(bool require_server, PopupDBusEventHandler handler);
+bool popup_dbus_is_open(void);
+// Closes our notifications; a playing routine is reported as cut short
+void popup_dbus_close(void);
+
+// SHOW and ROUTINE requests; false if the connection is gone
+bool popup_dbus_send(const PopupRequest *request);
+
+#endif
@@ -0,0 +1,241 @@
+// Session-bus test for the desktop-notification popup backend.
+// Usage: dbus-run-session -- ./popup_dbus_test
+//
+// A stub org.freedesktop.Notifications server is forked off and logs every
+// Notify/CloseNotification it gets. The daemon side (popup.c with the auto
+// backend) then shows a popup, plays a short routine, and plays one the stub
+// dismisses. Checked: updates reuse the routine's notification through
+// replaces_id, routines report completion, and auto falls back without a server.
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include "popup.h"
+#include "popup_dbus.h"
+#include "dbus_wire.h"
+#include "event_loop.h"
+
+#define NOTIFICATIONS_NAME "org.freedesktop.Notifications"
+#define MAX_LOG_LINES 256
+
+static int failed = 0, checks = 0;
+
+static void check(int ok, const char *what) {
+    checks++;
+    if (!ok) {
+        failed++;
+        fprintf(stderr, "FAIL: %s\n", what);
+    }
+}
+
+// Stub server
+
+static void reply_id(DBusConnection *conn, const DBusMessage *call, uint32_t id, bool with_id) {
+    DBusHeader header = {
+        .type = DBUS_MESSAGE_METHOD_RETURN,
+        .reply_serial = call->serial,
+        .destination = call->sender,
+        .signature = with_id ? "u" : NULL
+    };
+    DBusWriter w;
+    dbus_writer_begin(&w, &header);
+    if (with_id) {
+        dbus_put_u32(&w, id);
+    }
+    dbus_wire_send(conn, &w);
+}
+
+static void emit_closed(DBusConnection *conn, uint32_t id, uint32_t reason) {
+    DBusHeader header = {
+        .type = DBUS_MESSAGE_SIGNAL,
+        .path = "/org/freedesktop/Notifications",
+        .interface = NOTIFICATIONS_NAME,
+        .member = "NotificationClosed",
+        .signature = "uu"
+    };
+    DBusWriter w;
+    dbus_writer_begin(&w, &header);
+    dbus_put_u32(&w, id);
+    dbus_put_u32(&w, reason);
+    dbus_wire_send(conn, &w);
+}
+
+static int run_stub_server(int log_fd, int ready_fd) {
+    static DBusConnection conn;
+    DBusMessage reply;
+    DBusWriter w;
+    if (!dbus_wire_open_session(&conn, 1000)) {
+        return 1;
+    }
+    DBusHeader request_name = {
+        .type = DBUS_MESSAGE_METHOD_CALL,
+        .destination = "org.freedesktop.DBus",
+        .path = "/org/freedesktop/DBus",
+        .interface = "org.freedesktop.DBus",
+        .member = "RequestName",
+        .signature = "su"
+    };
+    dbus_writer_begin(&w, &request_name);
+    dbus_put_string(&w, NOTIFICATIONS_NAME);
+    dbus_put_u32(&w, 4);    // DBUS_NAME_FLAG_DO_NOT_QUEUE
+    if (!dbus_wire_call(&conn, &w, &reply, 1000)) {
+        return 1;
+    }
+    if (write(ready_fd, "r", 1) != 1) {
+        return 1;
+    }
+
+    uint32_t last_id = 0;
+    FILE *log = fdopen(log_fd, "w");
+    setvbuf(log, NULL, _IOLBF, 0);
+    for (;;) {
+        struct pollfd pfd = { .fd = conn.fd, .events = POLLIN };
+        if (poll(&pfd, 1, -1) < 0 || !dbus_wire_receive(&conn)) {
+            return 0;
+        }
+        DBusMessage m;
+        while (dbus_wire_next(&conn, &m)) {
+            if (m.type != DBUS_MESSAGE_METHOD_CALL || !m.member) continue;
+            DBusReader r;
+            dbus_reader_init(&r, &m);
+            if (strcmp(m.member, "Notify") == 0) {
+                dbus_read_string(&r);
+                uint32_t replaces = dbus_read_u32(&r);
+                dbus_read_string(&r);
+                dbus_read_string(&r);
+                char body[1100];
+                snprintf(body, sizeof(body), "%s", dbus_read_string(&r));
+                for (char *p = body; *p; p++) {
+                    if (*p == '\n') *p = '|';
+                }
+                uint32_t id = replaces ? replaces : ++last_id;
+                fprintf(log, "notify %u %u %s\n", replaces, id, body);
+                reply_id(&conn, &m, id, true);
+                if (strncmp(body, "dismiss me", 10) == 0) {
+                    emit_closed(&conn, id, 2);
+                }
+            } else if (strcmp(m.member, "CloseNotification") == 0) {
+                uint32_t id = dbus_read_u32(&r);
+                fprintf(log, "close %u\n", id);
+                reply_id(&conn, &m, 0, false);
+                emit_closed(&conn, id, 3);
+            }
+        }
+    }
+}
+
+// Daemon side
+
+static int routines_done = 0;
+static int last_completed = -1;
+
+static void on_routine_done(unsigned int id, bool completed, int elapsed_seconds) {
+    (void)id;
+    (void)elapsed_seconds;
+    routines_done++;
+    last_completed = completed;
+}
+
+static void run_until_done(int count, int timeout_ms) {
+    for (int waited = 0; routines_done < count && waited < timeout_ms; waited += 50) {
+        event_loop_run_for(50);
+    }
+}
+
+int main(void) {
+    if (!getenv("DBUS_SESSION_BUS_ADDRESS")) {
+        fprintf(stderr, "no session bus, run under dbus-run-session\n");
+        return 1;
+    }
+
+    int log_pipe[2], ready_pipe[2];
+    if (pipe(log_pipe) < 0 || pipe(ready_pipe) < 0) {
+        perror("pipe");
+        return 1;
+    }
+    pid_t stub = fork();
+    if (stub == 0) {
+        close(log_pipe[0]);
+        close(ready_pipe[0]);
+        _exit(run_stub_server(log_pipe[1], ready_pipe[1]));
+    }
+    close(log_pipe[1]);
+    close(ready_pipe[1]);
+    char ready;
+    if (read(ready_pipe[0], &ready, 1) != 1) {
+        fprintf(stderr, "stub notification server did not start\n");
+        return 1;
+    }
+
+    popup_set_backend(POPUP_BACKEND_AUTO);
+    check(popup_init(), "auto backend connects");
+    PopupStats stats;
+    popup_get_stats(&stats);
+    check(stats.backend == POPUP_BACKEND_DBUS, "auto picks notifications while a server runs");
+
+    show_popup("hello", 2, POPUP_KIND_STATUS);
+
+    PopupStep steps[] = {{"look away", 2}, {"blink", 1}};
+    check(show_routine(steps, 2, POPUP_ROUTINE_COUNTDOWN | POPUP_ROUTINE_PROGRESS, on_routine_done) != 0,
+          "routine accepted");
+    run_until_done(1, 5000);
+    check(routines_done == 1 && last_completed == 1, "routine completes");
+
+    PopupStep dismissed[] = {{"dismiss me", 5}};
+    show_routine(dismissed, 1, 0, on_routine_done);
+    run_until_done(2, 2000);
+    check(routines_done == 2 && last_completed == 0, "dismissed routine reported as cut short");
+
+    popup_get_stats(&stats);
+    check(stats.shown == 3, "three popups reported shown");
+    popup_shutdown();
+
+    kill(stub, SIGTERM);
+    waitpid(stub, NULL, 0);
+
+    // Read back what the stub saw
+    FILE *log = fdopen(log_pipe[0], "r");
+    char lines[MAX_LOG_LINES][1200];
+    int count = 0;
+    while (count < MAX_LOG_LINES && fgets(lines[count], sizeof(lines[count]), log)) {
+        lines[count][strcspn(lines[count], "\n")] = '\0';
+        printf("stub: %s\n", lines[count]);
+        count++;
+    }
+    fclose(log);
+
+    unsigned int routine_id = 0;
+    int updates = 0, bad_updates = 0, saw_hello = 0, saw_blink = 0, saw_close = 0;
+    for (int i = 0; i < count; i++) {
+        unsigned int replaces, id;
+        char body[1100] = "";
+        if (sscanf(lines[i], "notify %u %u %1099[^\n]", &replaces, &id, body) >= 2) {
+            if (strcmp(body, "hello") == 0) {
+                saw_hello = replaces == 0;
+            } else if (strncmp(body, "look away", 9) == 0 && routine_id == 0) {
+                routine_id = id;
+                check(replaces == 0, "routine starts a new notification");
+            } else if (routine_id && strncmp(body, "dismiss me", 10) != 0) {
+                updates++;
+                bad_updates += replaces != routine_id;
+                saw_blink |= strncmp(body, "blink", 5) == 0;
+            }
+        } else if (sscanf(lines[i], "close %u", &id) == 1 && id == routine_id) {
+            saw_close = 1;
+        }
+    }
+    check(saw_hello, "status popup sent as its own notification");
+    check(updates >= 2 && bad_updates == 0, "routine steps and countdown update in place");
+    check(saw_blink, "second step shown");
+    check(saw_close, "finished routine closes its notification");
+
+    check(!popup_dbus_open(true, NULL), "no server: notification backend refuses, GTK is used");
+
+    printf("%d checks, %d failed\n", checks, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "popup_protocol.h"
+
+// restly-popup: the GTK popup renderer, started by the restly daemon with
+// its end of the popup socketpair as "restly-popup --fd <n>"
+int main(int argc, char *argv[])
+{
+    int fd = -1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--fd") == 0 && i + 1 < argc)
+        {
+            fd = atoi(argv[++i]);
+        }
+    }
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "usage: %s --fd <n>\n(started by restly, not meant to be run by hand)\n", argv[0]);
+        return 2;
+    }
+    return popup_renderer_main(fd);
+}
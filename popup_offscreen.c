@@ -0,0 +1,104 @@
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <time.h>
+#include <pango/pangocairo.h>
+#include "popup_offscreen.h"
+#include "popup_style.h"
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void set_source_hex(cairo_t *cr, unsigned int rgb) {
+    cairo_set_source_rgb(cr, ((rgb >> 16) & 0xff) / 255.0, ((rgb >> 8) & 0xff) / 255.0, (rgb & 0xff) / 255.0);
+}
+
+// Rounded rectangle path as GTK draws a CSS border-radius box
+static void rounded_rect(cairo_t *cr, double x, double y, double w, double h, double r) {
+    cairo_new_sub_path(cr);
+    cairo_arc(cr, x + w - r, y + r, r, -M_PI / 2, 0);
+    cairo_arc(cr, x + w - r, y + h - r, r, 0, M_PI / 2);
+    cairo_arc(cr, x + r, y + h - r, r, M_PI / 2, M_PI);
+    cairo_arc(cr, x + r, y + r, r, M_PI, 3 * M_PI / 2);
+    cairo_close_path(cr);
+}
+
+static PangoLayout *create_layout(cairo_t *cr, const char *message) {
+    PangoLayout *layout = pango_cairo_create_layout(cr);
+    PangoFontDescription *font = pango_font_description_new();
+    pango_font_description_set_family(font, POPUP_FONT_FAMILY);
+    pango_font_description_set_weight(font, PANGO_WEIGHT_BOLD);
+    pango_font_description_set_size(font, POPUP_FONT_SIZE_PT * PANGO_SCALE);
+    pango_layout_set_font_description(layout, font);
+    pango_font_description_free(font);
+
+    // GtkLabel defaults: centered lines, no wrapping
+    pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+    pango_layout_set_text(layout, message, -1);
+    return layout;
+}
+
+bool popup_offscreen_render(const char *message, const char *png_path, PopupRenderStats *stats) {
+    // Measure on a scratch surface first: the popup grows to fit its text
+    cairo_surface_t *scratch = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cairo_t *scratch_cr = cairo_create(scratch);
+
+    double start = now_us();
+    PangoLayout *layout = create_layout(scratch_cr, message);
+    pango_layout_get_pixel_size(layout, &stats->text_width, &stats->text_height);
+    stats->layout_us = now_us() - start;
+
+    int frame = POPUP_BORDER_WIDTH + POPUP_PADDING;
+    int content_width = stats->text_width + 2 * frame;
+    int content_height = stats->text_height + 2 * POPUP_LABEL_PADDING + 2 * frame;
+    stats->width = content_width > POPUP_WIDTH ? content_width : POPUP_WIDTH;
+    stats->height = content_height > POPUP_HEIGHT ? content_height : POPUP_HEIGHT;
+
+    start = now_us();
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, stats->width, stats->height);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        g_object_unref(layout);
+        cairo_destroy(scratch_cr);
+        cairo_surface_destroy(scratch);
+        return false;
+    }
+    cairo_t *cr = cairo_create(surface);
+
+    // Transparent window, as in the renderer's draw handler
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba(cr, 0, 0, 0, 0);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+    double half = POPUP_BORDER_WIDTH / 2.0;
+    rounded_rect(cr, half, half, stats->width - POPUP_BORDER_WIDTH, stats->height - POPUP_BORDER_WIDTH,
+                 POPUP_BORDER_RADIUS - half);
+    cairo_set_source_rgba(cr, POPUP_BG_R / 255.0, POPUP_BG_G / 255.0, POPUP_BG_B / 255.0, POPUP_BG_ALPHA);
+    cairo_fill_preserve(cr);
+    set_source_hex(cr, POPUP_HEX(POPUP_BORDER_HEX));
+    cairo_set_line_width(cr, POPUP_BORDER_WIDTH);
+    cairo_stroke(cr);
+
+    // Same font map and options as the target surface
+    pango_cairo_update_layout(cr, layout);
+    set_source_hex(cr, POPUP_HEX(POPUP_TEXT_HEX));
+    cairo_move_to(cr, (stats->width - stats->text_width) / 2.0, (stats->height - stats->text_height) / 2.0);
+    pango_cairo_show_layout(cr, layout);
+    cairo_surface_flush(surface);
+    stats->render_us = now_us() - start;
+
+    bool ok = true;
+    if (png_path) {
+        ok = cairo_surface_write_to_png(surface, png_path) == CAIRO_STATUS_SUCCESS;
+    }
+
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+    g_object_unref(layout);
+    cairo_destroy(scratch_cr);
+    cairo_surface_destroy(scratch);
+    return ok;
+}
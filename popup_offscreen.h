@@ -0,0 +1,22 @@
+#ifndef POPUP_OFFSCREEN_H
+#define POPUP_OFFSCREEN_H
+
+#include <stdbool.h>
+
+// Headless popup backend: lays out and draws a message exactly as the GTK
+// renderer would (popup_style.h), into a cairo image surface. Needs only
+// pango-cairo, no display.
+typedef struct {
+    int width;              // popup size after fitting the text
+    int height;
+    int text_width;         // laid-out label size
+    int text_height;
+    double layout_us;       // pango layout of the text
+    double render_us;       // background, border and text onto the surface
+} PopupRenderStats;
+
+// Render message; writes a PNG to png_path when it is not NULL.
+// Returns false if the surface or the PNG could not be created.
+bool popup_offscreen_render(const char *message, const char *png_path, PopupRenderStats *stats);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef POPUP_PROTOCOL_H
+#define POPUP_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Messages between the daemon and the popup renderer process. They travel
+// over a SOCK_SEQPACKET socketpair, so every send is one whole message.
+// The renderer is a separate binary, the only one linking GTK; the daemon
+// runs it as "restly-popup --fd <n>" with its end of the socketpair.
+#define POPUP_RENDERER_BINARY "restly-popup"
+#define POPUP_TEXT_MAX 1024
+#define POPUP_ROUTINE_MAX_STEPS 16
+
+// Routine steps are packed into text as "<ms>" POPUP_FIELD_SEP "<text>" POPUP_STEP_SEP
+#define POPUP_FIELD_SEP '\x1f'
+#define POPUP_STEP_SEP '\x1e'
+
+typedef enum {
+    POPUP_REQUEST_SHOW = 1,     // show text for duration_ms
+    POPUP_REQUEST_ROUTINE,      // play the packed steps in one window, report back
+    POPUP_REQUEST_PING          // answer with a PONG carrying id, from the main loop
+} PopupRequestType;
+
+typedef struct {
+    uint32_t type;
+    uint32_t duration_ms;
+    uint32_t id;                // routine id, echoed in its PopupEvent
+    uint32_t kind;              // PopupKind, decides queueing in the renderer
+    uint32_t flags;             // POPUP_ROUTINE_* from popup.h
+    int64_t requested_ns;       // CLOCK_MONOTONIC when the daemon asked
+    int64_t received_ns;        // set by the renderer when it reads the request
+    char text[POPUP_TEXT_MAX];  // NUL-terminated, only the used part is sent
+} PopupRequest;
+
+// Renderer -> daemon
+typedef enum {
+    POPUP_EVENT_ROUTINE_DONE = 1,
+    POPUP_EVENT_SHOWN,          // a popup's content was first drawn
+    POPUP_EVENT_READY,          // renderer finished gtk_init and built its window
+    POPUP_EVENT_PONG            // reply to POPUP_REQUEST_PING
+} PopupEventType;
+
+typedef struct {
+    uint32_t type;
+    uint32_t id;                // ROUTINE_DONE, PONG, and SHOWN for routines
+    uint32_t completed;         // ROUTINE_DONE: 0 if another popup cut it short
+    uint32_t elapsed_ms;        // ROUTINE_DONE
+    uint32_t kind;              // SHOWN: PopupKind
+    uint32_t reserved;
+    // SHOWN: the popup's timeline. READY: process start in received_ns and
+    // the moment the window was built in drawn_ns.
+    int64_t requested_ns;       // show_popup called in the daemon
+    int64_t received_ns;        // renderer read the request
+    int64_t mapped_ns;          // window mapped, 0 if it was already up
+    int64_t drawn_ns;           // first draw with the new content
+} PopupEvent;
+
+#define POPUP_REQUEST_HEADER_SIZE offsetof(PopupRequest, text)
+
+// Renderer side (popup_renderer.c): serve requests from fd until it closes
+int popup_renderer_main(int fd);
+
+// Same clock in both processes, so timestamps can be compared directly
+static inline int64_t popup_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#endif
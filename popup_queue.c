@@ -0,0 +1,116 @@
+#define _DEFAULT_SOURCE
+#include <string.h>
+#include "popup_queue.h"
+
+void popup_queue_init(PopupQueue *queue) {
+    memset(queue, 0, sizeof(*queue));
+}
+
+// Append a confirmation to the one already waiting, keeping the longer duration
+static void merge_confirmation(PopupRequest *waiting, const PopupRequest *request) {
+    size_t len = strlen(waiting->text);
+    size_t add = strlen(request->text);
+    if (len + 1 + add < sizeof(waiting->text)) {
+        waiting->text[len] = '\n';
+        memcpy(waiting->text + len + 1, request->text, add + 1);
+    } else {
+        // No room for both: the newer one wins
+        memcpy(waiting->text, request->text, add + 1);
+    }
+    if (request->duration_ms > waiting->duration_ms) {
+        waiting->duration_ms = request->duration_ms;
+    }
+}
+
+uint32_t popup_queue_push(PopupQueue *queue, const PopupRequest *request, int64_t now_ms) {
+    (void)now_ms;
+    PopupKind kind = request->kind < POPUP_KIND_COUNT ? (PopupKind)request->kind : POPUP_KIND_STATUS;
+    uint32_t replaced = 0;
+
+    if (queue->has_waiting[kind]) {
+        queue->coalesced++;
+        if (kind == POPUP_KIND_CONFIRMATION && request->type == POPUP_REQUEST_SHOW
+            && queue->waiting[kind].type == POPUP_REQUEST_SHOW) {
+            merge_confirmation(&queue->waiting[kind], request);
+            return 0;
+        }
+        if (queue->waiting[kind].type == POPUP_REQUEST_ROUTINE) {
+            replaced = queue->waiting[kind].id;
+        }
+    }
+    queue->waiting[kind] = *request;
+    queue->waiting[kind].kind = kind;
+    queue->has_waiting[kind] = true;
+    return replaced;
+}
+
+void popup_queue_finish_current(PopupQueue *queue) {
+    queue->showing = false;
+}
+
+static bool ends_on_timer(const PopupRequest *request) {
+    return request->type != POPUP_REQUEST_ROUTINE;
+}
+
+static int best_waiting(const PopupQueue *queue) {
+    for (int kind = POPUP_KIND_COUNT - 1; kind >= 0; kind--) {
+        if (queue->has_waiting[kind]) return kind;
+    }
+    return -1;
+}
+
+static void take_waiting(PopupQueue *queue, int kind, int64_t now_ms) {
+    queue->current = queue->waiting[kind];
+    queue->has_waiting[kind] = false;
+    queue->showing = true;
+    queue->shown_ms = now_ms;
+}
+
+PopupQueueAction popup_queue_update(PopupQueue *queue, int64_t now_ms, int64_t *wake_ms) {
+    bool was_showing = queue->showing;
+    bool changed = false;
+    *wake_ms = -1;
+
+    if (queue->showing && ends_on_timer(&queue->current)
+        && now_ms >= queue->shown_ms + queue->current.duration_ms) {
+        queue->showing = false;
+    }
+
+    int best = best_waiting(queue);
+    if (!queue->showing) {
+        if (best < 0) {
+            return was_showing ? POPUP_QUEUE_HIDE : POPUP_QUEUE_KEEP;
+        }
+        take_waiting(queue, best, now_ms);
+        changed = true;
+    } else if (best >= 0 && best >= (int)queue->current.kind) {
+        int64_t allowed_ms = queue->shown_ms + POPUP_MIN_VISIBLE_MS;
+        if (now_ms < allowed_ms) {
+            *wake_ms = allowed_ms;
+        } else {
+            // A preempted message comes back afterwards with the time it had left
+            int64_t left_ms = queue->shown_ms + queue->current.duration_ms - now_ms;
+            PopupKind kind = (PopupKind)queue->current.kind;
+            if (best > (int)kind && ends_on_timer(&queue->current)
+                && left_ms > POPUP_MIN_VISIBLE_MS && !queue->has_waiting[kind]) {
+                queue->waiting[kind] = queue->current;
+                queue->waiting[kind].duration_ms = (uint32_t)left_ms;
+                queue->has_waiting[kind] = true;
+            }
+            if (best > (int)kind) {
+                queue->preempted++;
+            }
+            take_waiting(queue, best, now_ms);
+            changed = true;
+        }
+    }
+
+    if (queue->showing && ends_on_timer(&queue->current)) {
+        int64_t end_ms = queue->shown_ms + queue->current.duration_ms;
+        if (*wake_ms < 0 || end_ms < *wake_ms) {
+            *wake_ms = end_ms;
+        }
+    }
+
+    return changed ? POPUP_QUEUE_SHOW : POPUP_QUEUE_KEEP;
+}
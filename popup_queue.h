@@ -0,0 +1,48 @@
+#ifndef POPUP_QUEUE_H
+#define POPUP_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "popup.h"
+#include "popup_protocol.h"
+
+// What the renderer shows next. Pure C with the clock passed in, so the
+// policy does not depend on GTK.
+//
+// - Priority: a waiting routine step beats a confirmation beats a status.
+//   A higher kind preempts what is up; a lower kind waits for it to end.
+// - Coalescing: one waiting slot per kind. Confirmations arriving together
+//   are merged into one popup; a newer status or routine replaces the older.
+// - Nothing is replaced before it has been up POPUP_MIN_VISIBLE_MS.
+#define POPUP_MIN_VISIBLE_MS 1500
+
+typedef enum {
+    POPUP_QUEUE_KEEP,       // leave the window as it is
+    POPUP_QUEUE_SHOW,       // show queue->current (new or preempting)
+    POPUP_QUEUE_HIDE        // nothing left to show
+} PopupQueueAction;
+
+typedef struct {
+    PopupRequest current;
+    bool showing;
+    int64_t shown_ms;
+    PopupRequest waiting[POPUP_KIND_COUNT];
+    bool has_waiting[POPUP_KIND_COUNT];
+    unsigned int coalesced;     // requests merged into or replaced by another
+    unsigned int preempted;     // popups cut short by a higher kind
+} PopupQueue;
+
+void popup_queue_init(PopupQueue *queue);
+
+// Add a request (request->kind says which slot). Returns the id of a waiting
+// routine it replaced, which will never play, or 0.
+uint32_t popup_queue_push(PopupQueue *queue, const PopupRequest *request, int64_t now_ms);
+
+// Routines end when their last step is done, not on a timer
+void popup_queue_finish_current(PopupQueue *queue);
+
+// Decide what should be up at now_ms. *wake_ms is when to call again,
+// -1 if only a new request or popup_queue_finish_current can change anything.
+PopupQueueAction popup_queue_update(PopupQueue *queue, int64_t now_ms, int64_t *wake_ms);
+
+#endif
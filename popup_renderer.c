@@ -0,0 +1,652 @@
+#define _DEFAULT_SOURCE
+#include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "popup.h"
+#include "popup_protocol.h"
+#include "popup_queue.h"
+#include "popup_ring.h"
+#include "popup_style.h"
+
+#define ROUTINE_TICK_MS 250
+
+typedef struct {
+    const char *text;
+    guint duration_ms;
+} RoutineStep;
+
+// A routine playing in the window; step texts point into text
+typedef struct {
+    guint32 id;                 // 0 when no routine is playing
+    guint32 flags;
+    char text[POPUP_TEXT_MAX];
+    RoutineStep steps[POPUP_ROUTINE_MAX_STEPS];
+    int step_count;
+    int current;
+    guint total_ms;
+    guint done_ms;              // length of the steps already finished
+    gint64 step_started_us;
+    gint64 started_us;
+    guint step_source;
+    guint tick_source;
+    // What the indicators show, so a tick only touches what changed
+    int shown_seconds;
+    int progress_px;
+    int ring_steps;
+    guint ring_draws;           // ring redraws and their cost, for RESTLY_POPUP_TRACE
+    gint64 ring_draw_us;
+} Routine;
+
+// Monitor layout, read once and refreshed only when GDK reports a change,
+// so placing a popup needs no display round trip
+#define MAX_MONITORS 8
+
+typedef struct {
+    GdkMonitor *monitor;
+    GdkRectangle workarea;      // geometry minus panels and docks
+} CachedMonitor;
+
+typedef struct {
+    CachedMonitor monitors[MAX_MONITORS];
+    int count;
+    int primary;                // index used when the active window is unknown
+    int active;                 // monitor of the focused window, -1 if unknown
+    GdkWindow *root;
+    GdkAtom active_window_atom; // _NET_ACTIVE_WINDOW, changes on every focus switch
+} MonitorCache;
+
+// State of the one popup window, built once and reused for every message
+typedef struct {
+    int fd;
+    GtkWidget *window;
+    GtkWidget *label;
+    GtkWidget *countdown;
+    GtkWidget *progress;
+    GtkWidget *ring;
+    PopupQueue queue;
+    guint wake_source;
+    Routine routine;
+    PopupEvent pending_shown;   // timeline of the popup awaiting its first draw
+    bool shown_pending;
+    const char *trace_path;     // RESTLY_POPUP_TRACE: append time-to-visible here
+    MonitorCache monitors;
+    int placed_monitor;         // where the window was last moved, -1 before the first move
+    GdkRectangle placed_on;     // that monitor's workarea at the time
+} Renderer;
+
+static Renderer renderer;
+
+static void send_event(const PopupEvent *event) {
+    send(renderer.fd, event, sizeof(*event), MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+static void trace(const char *format, long long a, long long b) {
+    if (renderer.trace_path) {
+        FILE *file = fopen(renderer.trace_path, "a");
+        if (file) {
+            fprintf(file, format, a, b);
+            fclose(file);
+        }
+    }
+}
+
+// First draw of new content: report the popup's timeline to the daemon
+static void report_shown(void) {
+    PopupEvent *event = &renderer.pending_shown;
+    event->drawn_ns = popup_now_ns();
+    renderer.shown_pending = false;
+    send_event(event);
+
+    trace("time_to_visible_us=%lld queued_us=%lld\n",
+          (long long)((event->drawn_ns - event->requested_ns) / 1000),
+          (long long)((event->received_ns - event->requested_ns) / 1000));
+}
+
+static gboolean on_window_map(GtkWidget *widget, GdkEvent *event, gpointer user_data) {
+    (void)widget;
+    (void)event;
+    (void)user_data;
+    if (renderer.shown_pending) {
+        renderer.pending_shown.mapped_ns = popup_now_ns();
+    }
+    return FALSE;
+}
+
+// True when only the ring is being redrawn, which is every ring frame
+static bool clip_inside_ring(cairo_t *cr) {
+    GdkRectangle clip;
+    GtkAllocation ring;
+    if (!gtk_widget_get_visible(renderer.ring) || !gdk_cairo_get_clip_rectangle(cr, &clip)) {
+        return false;
+    }
+    gtk_widget_get_allocation(renderer.ring, &ring);
+    return clip.x >= ring.x && clip.y >= ring.y &&
+           clip.x + clip.width <= ring.x + ring.width &&
+           clip.y + clip.height <= ring.y + ring.height;
+}
+
+static gboolean on_window_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    (void)widget;
+    (void)user_data;
+    // The ring paints its own background, so its frames skip the clear
+    if (!clip_inside_ring(cr)) {
+        cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.0);
+        cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+        cairo_paint(cr);
+    }
+
+    if (renderer.shown_pending) {
+        report_shown();
+    }
+    return FALSE; // allow normal drawing (CSS backgrounds on children)
+}
+
+static gboolean on_ring_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    (void)widget;
+    (void)user_data;
+    gint64 started_us = g_get_monotonic_time();
+    popup_ring_draw(cr, renderer.routine.ring_steps);
+    renderer.routine.ring_draws++;
+    renderer.routine.ring_draw_us += g_get_monotonic_time() - started_us;
+    return TRUE;
+}
+
+static void build_window(void) {
+    GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_default_size(GTK_WINDOW(window), POPUP_WIDTH, POPUP_HEIGHT);
+    gtk_window_set_resizable(GTK_WINDOW(window), FALSE);
+    gtk_window_set_decorated(GTK_WINDOW(window), FALSE);
+    gtk_window_set_keep_above(GTK_WINDOW(window), TRUE);
+    gtk_window_set_type_hint(GTK_WINDOW(window), GDK_WINDOW_TYPE_HINT_NOTIFICATION);
+    gtk_window_set_skip_taskbar_hint(GTK_WINDOW(window), TRUE);
+    gtk_window_set_skip_pager_hint(GTK_WINDOW(window), TRUE);
+    gtk_window_set_accept_focus(GTK_WINDOW(window), FALSE);
+    gtk_window_set_focus_on_map(GTK_WINDOW(window), FALSE);
+    gtk_window_set_gravity(GTK_WINDOW(window), GDK_GRAVITY_SOUTH_EAST);
+    gtk_widget_set_app_paintable(window, TRUE);
+    g_signal_connect(window, "draw", G_CALLBACK(on_window_draw), NULL);
+    g_signal_connect(window, "map-event", G_CALLBACK(on_window_map), NULL);
+
+    GdkScreen *screen = gdk_screen_get_default();
+    GdkVisual *visual = gdk_screen_get_rgba_visual(screen);
+    if (visual != NULL) {
+        gtk_widget_set_visual(window, visual);
+    }
+
+    GtkWidget *label = gtk_label_new("");
+    gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
+    gtk_widget_set_valign(label, GTK_ALIGN_CENTER);
+
+    // Only shown while a routine asks for them
+    GtkWidget *countdown = gtk_label_new("");
+    gtk_widget_set_name(countdown, "countdown");
+    gtk_label_set_width_chars(GTK_LABEL(countdown), 5);  // "99 s" to "1 s" without a relayout
+    GtkWidget *progress = gtk_progress_bar_new();
+    GtkWidget *ring = gtk_drawing_area_new();
+    gtk_widget_set_size_request(ring, POPUP_RING_SIZE, POPUP_RING_SIZE);
+    gtk_widget_set_halign(ring, GTK_ALIGN_CENTER);
+    g_signal_connect(ring, "draw", G_CALLBACK(on_ring_draw), NULL);
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, POPUP_BOX_SPACING);
+    gtk_widget_set_name(box, "toast");
+    gtk_container_add(GTK_CONTAINER(window), box);
+    gtk_box_pack_start(GTK_BOX(box), label, TRUE, TRUE, POPUP_LABEL_PADDING);
+    gtk_box_pack_start(GTK_BOX(box), ring, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(box), countdown, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(box), progress, FALSE, FALSE, 0);
+    gtk_widget_show(box);
+    gtk_widget_show(label);
+
+    GtkCssProvider *css = gtk_css_provider_new();
+    gtk_css_provider_load_from_data(css, POPUP_CSS, -1, NULL);
+    gtk_style_context_add_provider_for_screen(screen, GTK_STYLE_PROVIDER(css), GTK_STYLE_PROVIDER_PRIORITY_USER);
+    g_object_unref(css);
+
+    renderer.window = window;
+    renderer.label = label;
+    renderer.countdown = countdown;
+    renderer.progress = progress;
+    renderer.ring = ring;
+}
+
+static int find_monitor(GdkMonitor *monitor) {
+    for (int i = 0; i < renderer.monitors.count; i++) {
+        if (renderer.monitors.monitors[i].monitor == monitor) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Ask which monitor holds the focused window; only on focus changes (X11
+// only, elsewhere the primary monitor is used)
+static void update_active_monitor(void) {
+    MonitorCache *cache = &renderer.monitors;
+    cache->active = -1;
+
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+    GdkWindow *active = gdk_screen_get_active_window(gdk_screen_get_default());
+G_GNUC_END_IGNORE_DEPRECATIONS
+    if (active != NULL) {
+        cache->active = find_monitor(gdk_display_get_monitor_at_window(gdk_display_get_default(), active));
+        g_object_unref(active);
+    }
+}
+
+// Rebuild the cache; gone is a monitor being removed that GDK may still list
+static void refresh_monitors(GdkMonitor *gone) {
+    GdkDisplay *display = gdk_display_get_default();
+    MonitorCache *cache = &renderer.monitors;
+    cache->count = 0;
+    cache->primary = 0;
+
+    int n = gdk_display_get_n_monitors(display);
+    for (int i = 0; i < n && cache->count < MAX_MONITORS; i++) {
+        GdkMonitor *monitor = gdk_display_get_monitor(display, i);
+        if (monitor == NULL || monitor == gone) {
+            continue;
+        }
+        if (gdk_monitor_is_primary(monitor)) {
+            cache->primary = cache->count;
+        }
+        CachedMonitor *cached = &cache->monitors[cache->count++];
+        cached->monitor = monitor;
+        gdk_monitor_get_workarea(monitor, &cached->workarea);
+    }
+    update_active_monitor();
+}
+
+static void position_window(void);
+
+static void on_monitor_changed(GObject *monitor, GParamSpec *pspec, gpointer user_data) {
+    (void)monitor;
+    (void)pspec;
+    (void)user_data;
+    refresh_monitors(NULL);
+    if (gtk_widget_get_visible(renderer.window)) {
+        position_window();
+    }
+}
+
+static void watch_monitor(GdkMonitor *monitor) {
+    g_signal_connect(monitor, "notify::workarea", G_CALLBACK(on_monitor_changed), NULL);
+    g_signal_connect(monitor, "notify::geometry", G_CALLBACK(on_monitor_changed), NULL);
+}
+
+static void on_monitor_added(GdkDisplay *display, GdkMonitor *monitor, gpointer user_data) {
+    (void)display;
+    (void)user_data;
+    watch_monitor(monitor);
+    on_monitor_changed(NULL, NULL, NULL);
+}
+
+static void on_monitor_removed(GdkDisplay *display, GdkMonitor *monitor, gpointer user_data) {
+    (void)display;
+    (void)user_data;
+    refresh_monitors(monitor);
+    renderer.placed_monitor = -1;
+    if (gtk_widget_get_visible(renderer.window)) {
+        position_window();
+    }
+}
+
+// Sees every GDK event before GTK does; picks out focus changes on the root window
+static void on_gdk_event(GdkEvent *event, gpointer user_data) {
+    (void)user_data;
+    if (event->type == GDK_PROPERTY_NOTIFY && event->property.window == renderer.monitors.root
+        && event->property.atom == renderer.monitors.active_window_atom) {
+        update_active_monitor();
+    }
+    gtk_main_do_event(event);
+}
+
+static void init_monitors(void) {
+    GdkDisplay *display = gdk_display_get_default();
+    MonitorCache *cache = &renderer.monitors;
+
+    refresh_monitors(NULL);
+    for (int i = 0; i < cache->count; i++) {
+        watch_monitor(cache->monitors[i].monitor);
+    }
+    g_signal_connect(display, "monitor-added", G_CALLBACK(on_monitor_added), NULL);
+    g_signal_connect(display, "monitor-removed", G_CALLBACK(on_monitor_removed), NULL);
+
+    cache->root = gdk_screen_get_root_window(gdk_screen_get_default());
+    cache->active_window_atom = gdk_atom_intern_static_string("_NET_ACTIVE_WINDOW");
+    gdk_window_set_events(cache->root, gdk_window_get_events(cache->root) | GDK_PROPERTY_CHANGE_MASK);
+    gdk_event_handler_set(on_gdk_event, NULL, NULL);
+    renderer.placed_monitor = -1;
+}
+
+// Bottom-right corner of the workarea of the active window's monitor; the
+// window's gravity keeps that corner fixed when a long message grows it
+static void position_window(void) {
+    MonitorCache *cache = &renderer.monitors;
+    if (cache->count == 0) {
+        return;
+    }
+    int index = cache->active >= 0 ? cache->active : cache->primary;
+    const GdkRectangle *workarea = &cache->monitors[index].workarea;
+
+    // Already there: no request to the window manager at all
+    if (index == renderer.placed_monitor && memcmp(workarea, &renderer.placed_on, sizeof(*workarea)) == 0) {
+        return;
+    }
+    renderer.placed_monitor = index;
+    renderer.placed_on = *workarea;
+
+    gint x = workarea->x + workarea->width - POPUP_SCREEN_MARGIN;
+    gint y = workarea->y + workarea->height - POPUP_SCREEN_MARGIN;
+    gtk_window_move(GTK_WINDOW(renderer.window), x, y);
+}
+
+static void send_routine_done(guint32 id, bool completed, guint32 elapsed_ms) {
+    PopupEvent event = {
+        .type = POPUP_EVENT_ROUTINE_DONE,
+        .id = id,
+        .completed = completed,
+        .elapsed_ms = elapsed_ms
+    };
+    send_event(&event);
+}
+
+static void run_queue(void);
+
+// Stop the playing routine, if any, and tell the daemon how it ended
+static void end_routine(bool completed) {
+    Routine *routine = &renderer.routine;
+    if (routine->id == 0) {
+        return;
+    }
+    if (routine->step_source) {
+        g_source_remove(routine->step_source);
+    }
+    if (routine->tick_source) {
+        g_source_remove(routine->tick_source);
+    }
+    send_routine_done(routine->id, completed,
+                      (guint32)((g_get_monotonic_time() - routine->started_us) / 1000));
+    if (routine->flags & POPUP_ROUTINE_RING) {
+        trace("ring_draws=%lld ring_draw_us=%lld\n", (long long)routine->ring_draws, (long long)routine->ring_draw_us);
+    }
+    routine->id = 0;
+    routine->step_source = 0;
+    routine->tick_source = 0;
+    gtk_widget_hide(renderer.countdown);
+    gtk_widget_hide(renderer.progress);
+    gtk_widget_hide(renderer.ring);
+}
+
+static void update_routine_indicators(void) {
+    Routine *routine = &renderer.routine;
+    guint step_elapsed = (guint)((g_get_monotonic_time() - routine->step_started_us) / 1000);
+    guint step_ms = routine->steps[routine->current].duration_ms;
+    if (step_elapsed > step_ms) {
+        step_elapsed = step_ms;
+    }
+
+    // Each indicator is touched only when what it shows would change; the
+    // ring invalidates just the wedge its arc moved through
+    if (routine->flags & POPUP_ROUTINE_COUNTDOWN) {
+        int seconds = (int)((step_ms - step_elapsed + 999) / 1000);
+        if (seconds != routine->shown_seconds) {
+            char text[16];
+            snprintf(text, sizeof(text), "%d s", seconds);
+            gtk_label_set_text(GTK_LABEL(renderer.countdown), text);
+            routine->shown_seconds = seconds;
+        }
+    }
+    if ((routine->flags & POPUP_ROUTINE_PROGRESS) && routine->total_ms > 0) {
+        double fraction = (double)(routine->done_ms + step_elapsed) / routine->total_ms;
+        int px = (int)(fraction * gtk_widget_get_allocated_width(renderer.progress));
+        if (px != routine->progress_px) {
+            gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(renderer.progress), fraction);
+            routine->progress_px = px;
+        }
+    }
+    if (routine->flags & POPUP_ROUTINE_RING) {
+        int steps = popup_ring_steps(step_ms > 0 ? (double)(step_ms - step_elapsed) / step_ms : 0.0);
+        PopupRingRect damage;
+        if (popup_ring_damage(routine->ring_steps, steps, &damage)) {
+            routine->ring_steps = steps;
+            gtk_widget_queue_draw_area(renderer.ring, damage.x, damage.y, damage.width, damage.height);
+        }
+    }
+}
+
+static gboolean on_routine_tick(gpointer user_data) {
+    (void)user_data;
+    update_routine_indicators();
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_routine_step_done(gpointer user_data);
+
+// Show the current step in place: same window, new label text
+static void play_routine_step(void) {
+    Routine *routine = &renderer.routine;
+    const RoutineStep *step = &routine->steps[routine->current];
+
+    gtk_label_set_text(GTK_LABEL(renderer.label), step->text);
+    routine->step_started_us = g_get_monotonic_time();
+    update_routine_indicators();
+
+    // The ring wants a tick per pixel of arc, so the rate follows the step
+    // length; draws still land on the frame clock, never above the refresh rate
+    if (routine->tick_source) {
+        g_source_remove(routine->tick_source);
+        routine->tick_source = 0;
+    }
+    if (routine->flags & POPUP_ROUTINE_RING) {
+        routine->tick_source = g_timeout_add(popup_ring_tick_ms(step->duration_ms, ROUTINE_TICK_MS),
+                                             on_routine_tick, NULL);
+    } else if (routine->flags & (POPUP_ROUTINE_COUNTDOWN | POPUP_ROUTINE_PROGRESS)) {
+        routine->tick_source = g_timeout_add(ROUTINE_TICK_MS, on_routine_tick, NULL);
+    }
+    routine->step_source = g_timeout_add(step->duration_ms, on_routine_step_done, NULL);
+}
+
+static gboolean on_routine_step_done(gpointer user_data) {
+    (void)user_data;
+    Routine *routine = &renderer.routine;
+    routine->step_source = 0;
+    routine->done_ms += routine->steps[routine->current].duration_ms;
+
+    if (++routine->current < routine->step_count) {
+        play_routine_step();
+    } else {
+        end_routine(true);
+        popup_queue_finish_current(&renderer.queue);
+        run_queue();
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// Unpack "<ms>\x1f<text>\x1e..." into routine steps
+static int parse_routine(Routine *routine, const char *packed) {
+    g_strlcpy(routine->text, packed, sizeof(routine->text));
+    routine->step_count = 0;
+    routine->total_ms = 0;
+
+    char *p = routine->text;
+    while (*p && routine->step_count < POPUP_ROUTINE_MAX_STEPS) {
+        char *field = strchr(p, POPUP_FIELD_SEP);
+        if (!field) break;
+        char *end = strchr(field + 1, POPUP_STEP_SEP);
+        if (end) *end = '\0';
+
+        RoutineStep *step = &routine->steps[routine->step_count++];
+        step->duration_ms = (guint)strtoul(p, NULL, 10);
+        step->text = field + 1;
+        routine->total_ms += step->duration_ms;
+
+        if (!end) break;
+        p = end + 1;
+    }
+    return routine->step_count;
+}
+
+static void present_window(const PopupRequest *request) {
+    // Shrink back to the default size after a longer message
+    gtk_window_resize(GTK_WINDOW(renderer.window), POPUP_WIDTH, POPUP_HEIGHT);
+    position_window();
+
+    // A popup replaced before it was drawn is never reported
+    PopupEvent *shown = &renderer.pending_shown;
+    memset(shown, 0, sizeof(*shown));
+    shown->type = POPUP_EVENT_SHOWN;
+    shown->id = request->id;
+    shown->kind = request->kind;
+    shown->requested_ns = request->requested_ns;
+    shown->received_ns = request->received_ns;
+    renderer.shown_pending = true;
+
+    gtk_widget_show(renderer.window);
+    gtk_widget_queue_draw(renderer.window);
+}
+
+static void show_message(const PopupRequest *request) {
+    end_routine(false);
+    gtk_label_set_text(GTK_LABEL(renderer.label), request->text);
+    present_window(request);
+}
+
+static bool start_routine(const PopupRequest *request) {
+    end_routine(false);
+
+    Routine *routine = &renderer.routine;
+    if (parse_routine(routine, request->text) == 0) {
+        send_routine_done(request->id, false, 0);
+        return false;
+    }
+    routine->id = request->id;
+    routine->flags = request->flags;
+    routine->current = 0;
+    routine->done_ms = 0;
+    routine->started_us = g_get_monotonic_time();
+    routine->shown_seconds = -1;
+    routine->progress_px = -1;
+    routine->ring_steps = 0;
+    routine->ring_draws = 0;
+    routine->ring_draw_us = 0;
+
+    gtk_widget_set_visible(renderer.countdown, (routine->flags & POPUP_ROUTINE_COUNTDOWN) != 0);
+    gtk_widget_set_visible(renderer.progress, (routine->flags & POPUP_ROUTINE_PROGRESS) != 0);
+    gtk_widget_set_visible(renderer.ring, (routine->flags & POPUP_ROUTINE_RING) != 0);
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(renderer.progress), 0.0);
+
+    present_window(request);
+    play_routine_step();
+    return true;
+}
+
+static gint64 now_ms(void) {
+    return g_get_monotonic_time() / 1000;
+}
+
+static gboolean on_queue_wake(gpointer user_data) {
+    (void)user_data;
+    renderer.wake_source = 0;
+    run_queue();
+    return G_SOURCE_REMOVE;
+}
+
+// Apply the queue's decision, then sleep until it can change again
+static void run_queue(void) {
+    gint64 now = now_ms();
+    int64_t wake_ms;
+
+    switch (popup_queue_update(&renderer.queue, now, &wake_ms)) {
+        case POPUP_QUEUE_SHOW:
+            if (renderer.queue.current.type != POPUP_REQUEST_ROUTINE) {
+                show_message(&renderer.queue.current);
+            } else if (!start_routine(&renderer.queue.current)) {
+                // Nothing playable in it; move on to whatever waits
+                popup_queue_finish_current(&renderer.queue);
+                run_queue();
+                return;
+            }
+            break;
+        case POPUP_QUEUE_HIDE:
+            end_routine(false);
+            gtk_widget_hide(renderer.window);
+            // GTK forgets the requested position on unmap
+            renderer.placed_monitor = -1;
+            break;
+        case POPUP_QUEUE_KEEP:
+            break;
+    }
+
+    if (renderer.wake_source) {
+        g_source_remove(renderer.wake_source);
+        renderer.wake_source = 0;
+    }
+    if (wake_ms >= 0) {
+        renderer.wake_source = g_timeout_add((guint)MAX(wake_ms - now, 0), on_queue_wake, NULL);
+    }
+}
+
+static gboolean on_request(gint fd, GIOCondition condition, gpointer user_data) {
+    (void)condition;
+    (void)user_data;
+    PopupRequest request;
+
+    ssize_t n = recv(fd, &request, sizeof(request), 0);
+    if (n <= 0) {
+        // The daemon exited or restarted us
+        gtk_main_quit();
+        return G_SOURCE_REMOVE;
+    }
+    if ((size_t)n <= POPUP_REQUEST_HEADER_SIZE) {
+        return G_SOURCE_CONTINUE;
+    }
+    request.text[MIN((size_t)n - POPUP_REQUEST_HEADER_SIZE, sizeof(request.text) - 1)] = '\0';
+    request.received_ns = popup_now_ns();
+
+    if (request.type == POPUP_REQUEST_PING) {
+        // Answered from the main loop, so a stuck loop stays silent
+        PopupEvent pong = { .type = POPUP_EVENT_PONG, .id = request.id };
+        send_event(&pong);
+    } else if (request.type == POPUP_REQUEST_SHOW || request.type == POPUP_REQUEST_ROUTINE) {
+        // A routine replaced before it started still gets its report
+        guint32 replaced = popup_queue_push(&renderer.queue, &request, now_ms());
+        if (replaced) {
+            send_routine_done(replaced, false, 0);
+        }
+        run_queue();
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+int popup_renderer_main(int fd) {
+    int64_t started_ns = popup_now_ns();
+
+    unsetenv("DESKTOP_STARTUP_ID");
+
+    int argc = 0;
+    char **argv = NULL;
+    if (!gtk_init_check(&argc, &argv)) {
+        return 1;
+    }
+
+    memset(&renderer, 0, sizeof(renderer));
+    renderer.fd = fd;
+    popup_queue_init(&renderer.queue);
+    renderer.trace_path = getenv("RESTLY_POPUP_TRACE");
+    build_window();
+    init_monitors();
+    g_unix_fd_add(fd, G_IO_IN | G_IO_HUP | G_IO_ERR, on_request, NULL);
+
+    PopupEvent ready = {
+        .type = POPUP_EVENT_READY,
+        .received_ns = started_ns,
+        .drawn_ns = popup_now_ns()
+    };
+    send_event(&ready);
+
+    gtk_main();
+    return 0;
+}
@@ -0,0 +1,101 @@
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include "popup_ring.h"
+#include "popup_style.h"
+
+#define RING_CENTER (POPUP_RING_SIZE / 2.0)
+#define RING_RADIUS ((POPUP_RING_SIZE - POPUP_RING_WIDTH) / 2.0 - 1.0)
+#define RING_TOP (3 * M_PI / 2)     // where the arc ends, clockwise from 3 o'clock
+
+// The arc runs clockwise from its moving end to 12 o'clock
+static double arc_start(int steps) {
+    return RING_TOP - steps * (2 * M_PI / POPUP_RING_STEPS);
+}
+
+static void set_source_hex(cairo_t *cr, unsigned int rgb, double alpha) {
+    cairo_set_source_rgba(cr, ((rgb >> 16) & 0xff) / 255.0, ((rgb >> 8) & 0xff) / 255.0,
+                          (rgb & 0xff) / 255.0, alpha);
+}
+
+int popup_ring_steps(double remaining) {
+    if (remaining <= 0) return 0;
+    if (remaining >= 1) return POPUP_RING_STEPS;
+    // Round up: the ring only empties when the step is over
+    return (int)ceil(remaining * POPUP_RING_STEPS);
+}
+
+unsigned int popup_ring_tick_ms(unsigned int step_ms, unsigned int max_ms) {
+    unsigned int tick_ms = step_ms / POPUP_RING_STEPS;
+    if (tick_ms < 1000 / POPUP_RING_MAX_FPS) tick_ms = 1000 / POPUP_RING_MAX_FPS;
+    if (tick_ms > max_ms) tick_ms = max_ms;
+    return tick_ms;
+}
+
+static void extend(double *box, double angle, double radius) {
+    double x = RING_CENTER + radius * cos(angle);
+    double y = RING_CENTER + radius * sin(angle);
+    if (x < box[0]) box[0] = x;
+    if (y < box[1]) box[1] = y;
+    if (x > box[2]) box[2] = x;
+    if (y > box[3]) box[3] = y;
+}
+
+bool popup_ring_damage(int from, int to, PopupRingRect *rect) {
+    if (from == to) {
+        return false;
+    }
+    double a = arc_start(from > to ? from : to);
+    double b = arc_start(from > to ? to : from);
+    double inner = RING_RADIUS - POPUP_RING_WIDTH / 2.0;
+    double outer = RING_RADIUS + POPUP_RING_WIDTH / 2.0;
+
+    // Bounding box of the annulus sector a..b: its four corners, plus the
+    // outer edge wherever the sector crosses an axis
+    double box[4] = { POPUP_RING_SIZE, POPUP_RING_SIZE, 0, 0 };
+    extend(box, a, inner);
+    extend(box, a, outer);
+    extend(box, b, inner);
+    extend(box, b, outer);
+    for (int quarter = -1; quarter <= 3; quarter++) {
+        double axis = quarter * (M_PI / 2);
+        if (axis > a && axis < b) {
+            extend(box, axis, outer);
+        }
+    }
+
+    // One pixel of slack for antialiasing, then whole pixels inside the ring
+    int x0 = (int)floor(box[0]) - 1, y0 = (int)floor(box[1]) - 1;
+    int x1 = (int)ceil(box[2]) + 1, y1 = (int)ceil(box[3]) + 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > POPUP_RING_SIZE) x1 = POPUP_RING_SIZE;
+    if (y1 > POPUP_RING_SIZE) y1 = POPUP_RING_SIZE;
+    rect->x = x0;
+    rect->y = y0;
+    rect->width = x1 - x0;
+    rect->height = y1 - y0;
+    return true;
+}
+
+void popup_ring_draw(cairo_t *cr, int steps) {
+    cairo_save(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba(cr, POPUP_BG_R / 255.0, POPUP_BG_G / 255.0, POPUP_BG_B / 255.0, POPUP_BG_ALPHA);
+    cairo_rectangle(cr, 0, 0, POPUP_RING_SIZE, POPUP_RING_SIZE);
+    cairo_fill(cr);
+
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    cairo_set_line_width(cr, POPUP_RING_WIDTH);
+    set_source_hex(cr, POPUP_HEX(POPUP_BORDER_HEX), POPUP_RING_TRACK_ALPHA);
+    cairo_new_path(cr);
+    cairo_arc(cr, RING_CENTER, RING_CENTER, RING_RADIUS, 0, 2 * M_PI);
+    cairo_stroke(cr);
+
+    if (steps > 0) {
+        set_source_hex(cr, POPUP_HEX(POPUP_ACCENT_HEX), 1.0);
+        cairo_new_path(cr);
+        cairo_arc(cr, RING_CENTER, RING_CENTER, RING_RADIUS, arc_start(steps), RING_TOP);
+        cairo_stroke(cr);
+    }
+    cairo_restore(cr);
+}
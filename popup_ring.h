@@ -0,0 +1,35 @@
+#ifndef POPUP_RING_H
+#define POPUP_RING_H
+
+#include <stdbool.h>
+#include <cairo.h>
+
+// Countdown ring for routine steps: a POPUP_RING_SIZE square with an arc for
+// the time left in the step. The arc is quantised to about one pixel along
+// its centre line, so it only needs a redraw when that step count changes,
+// and then only over the wedge between the old and the new end. Plain cairo,
+// shared by the renderer and the offscreen benchmark.
+#define POPUP_RING_STEPS 106        // length of the centre line (radius 17) in pixels
+#define POPUP_RING_MAX_FPS 30       // redraws never come closer than this
+
+typedef struct {
+    int x, y, width, height;
+} PopupRingRect;
+
+// Arc length in steps for the fraction of the step left, 0..POPUP_RING_STEPS
+int popup_ring_steps(double remaining);
+
+// Interval at which to check a step of step_ms for a change: about one
+// pixel of arc, no faster than POPUP_RING_MAX_FPS, no slower than max_ms
+unsigned int popup_ring_tick_ms(unsigned int step_ms, unsigned int max_ms);
+
+// Area, in ring coordinates, that changes between two arc lengths;
+// false if they look the same
+bool popup_ring_damage(int from, int to, PopupRingRect *rect);
+
+// Draw the ring at the origin: its own background, the track, then the arc.
+// Background is painted with OPERATOR_SOURCE, so the window need not be
+// cleared under it; the current clip limits the work to the damaged area.
+void popup_ring_draw(cairo_t *cr, int steps);
+
+#endif
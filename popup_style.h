@@ -0,0 +1,43 @@
+#ifndef POPUP_STYLE_H
+#define POPUP_STYLE_H
+
+// Popup look, shared by the GTK renderer (as CSS) and the offscreen
+// backend (drawn with cairo), so both produce the same layout
+#define POPUP_WIDTH 300
+#define POPUP_HEIGHT 100
+#define POPUP_SCREEN_MARGIN 20      // gap to the screen's right and bottom edge
+
+#define POPUP_BORDER_WIDTH 5
+#define POPUP_BORDER_RADIUS 12
+#define POPUP_PADDING 12
+#define POPUP_LABEL_PADDING 10      // gtk_box_pack_start padding around the label
+#define POPUP_BOX_SPACING 10
+
+#define POPUP_BG_R 245
+#define POPUP_BG_G 250
+#define POPUP_BG_B 255
+#define POPUP_BG_ALPHA 0.95
+#define POPUP_BORDER_HEX a0c4ff     // bare hex digits: CSS "#a0c4ff", C 0xa0c4ff
+#define POPUP_TEXT_HEX 000000
+#define POPUP_ACCENT_HEX 4a6fa5     // countdown text and ring
+#define POPUP_FONT_FAMILY "Sans"
+#define POPUP_FONT_SIZE_PT 16
+
+#define POPUP_RING_SIZE 40          // countdown ring, square
+#define POPUP_RING_WIDTH 4          // stroke of the arc
+#define POPUP_RING_TRACK_ALPHA 0.35 // full circle under the arc, in the border colour
+
+#define POPUP_STR_(x) #x
+#define POPUP_STR(x) POPUP_STR_(x)
+#define POPUP_HEX_(x) 0x##x
+#define POPUP_HEX(x) POPUP_HEX_(x)
+
+#define POPUP_CSS \
+    "#toast { background-color: rgba(" POPUP_STR(POPUP_BG_R) ", " POPUP_STR(POPUP_BG_G) ", " \
+    POPUP_STR(POPUP_BG_B) ", " POPUP_STR(POPUP_BG_ALPHA) "); border: " POPUP_STR(POPUP_BORDER_WIDTH) \
+    "px solid #" POPUP_STR(POPUP_BORDER_HEX) "; border-radius: " POPUP_STR(POPUP_BORDER_RADIUS) "px; padding: " \
+    POPUP_STR(POPUP_PADDING) "px; }" \
+    "label { color: #" POPUP_STR(POPUP_TEXT_HEX) "; font-size: " POPUP_STR(POPUP_FONT_SIZE_PT) "pt; font-weight: bold; }" \
+    "#countdown { font-size: 11pt; font-weight: normal; color: #" POPUP_STR(POPUP_ACCENT_HEX) "; }"
+
+#endif
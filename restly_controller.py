@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 import json
 import os
+import socket
 import sys
 import subprocess
 import tempfile
@@ -22,6 +23,7 @@ except Exception:
 APP_ID = "restly-controller"
 QUEUE_DIR = os.path.expanduser("~/.config/restly/commands")
 QUEUE_FILE = os.path.join(QUEUE_DIR, "queue.jsonl")
+SOCKET_PATH = os.path.expanduser("~/.config/restly/restly.sock")
 
 
 def ensure_dirs():
@@ -93,6 +95,53 @@ class SummaryDialog(Gtk.Dialog):
         return buffer.get_text(buffer.get_start_iter(), buffer.get_end_iter(), False)
 
 
+class CompletionClient:
+    """Asks the daemon's control socket for palette completions.
+
+    One connection is kept open for the dialog's lifetime; if the daemon is
+    not running the palette simply shows no suggestions.
+    """
+
+    def __init__(self, path=SOCKET_PATH, timeout=0.05):
+        self.path = path
+        self.timeout = timeout
+        self.sock = None
+        self.reader = None
+
+    def _connect(self):
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.settimeout(self.timeout)
+        sock.connect(self.path)
+        self.sock = sock
+        self.reader = sock.makefile("rb")
+
+    def complete(self, prefix):
+        request = "complete " + prefix.replace("\n", " ") + "\n"
+        try:
+            if self.sock is None:
+                self._connect()
+            self.sock.sendall(request.encode("utf-8"))
+            suggestions = []
+            while True:
+                line = self.reader.readline().decode("utf-8", "replace").rstrip("\n")
+                if not line:
+                    break
+                suggestions.append(line.split("\t", 1)[0])
+            return suggestions
+        except OSError:
+            self.close()
+            return []
+
+    def close(self):
+        if self.sock is not None:
+            try:
+                self.sock.close()
+            except OSError:
+                pass
+        self.sock = None
+        self.reader = None
+
+
 class CommandDialog(Gtk.Dialog):
     def __init__(self, parent):
         super().__init__(title="Restly Command", transient_for=parent, flags=0)
@@ -105,12 +154,35 @@ class CommandDialog(Gtk.Dialog):
 
         self.entry = Gtk.Entry()
         self.entry.set_placeholder_text("e.g., Set a 45-minute deep work session")
+        self.entry.set_activates_default(True)
         box.pack_start(self.entry, True, True, 0)
 
+        # Suggestions come from the daemon, already ranked; show them as-is
+        self.completions = CompletionClient()
+        self.suggestions = Gtk.ListStore(str)
+        completion = Gtk.EntryCompletion()
+        completion.set_model(self.suggestions)
+        completion.set_text_column(0)
+        completion.set_minimum_key_length(1)
+        completion.set_match_func(lambda *_args: True, None)
+        self.entry.set_completion(completion)
+        self.entry.connect("changed", self.on_entry_changed)
+        self.connect("destroy", lambda *_args: self.completions.close())
+
         self.add_button("Cancel", Gtk.ResponseType.CANCEL)
         self.add_button("Send", Gtk.ResponseType.OK)
+        self.set_default_response(Gtk.ResponseType.OK)
         self.show_all()
 
+    def on_entry_changed(self, entry):
+        text = entry.get_text()
+        self.suggestions.clear()
+        if not text.strip():
+            return
+        for suggestion in self.completions.complete(text):
+            if suggestion != text.strip().lower():
+                self.suggestions.append([suggestion])
+
     def get_text(self):
         return self.entry.get_text().strip()
 
@@ -0,0 +1,62 @@
+// restly-log: read activity logs in either on-disk format.
+// Usage: restly-log cat --json FILE...
+//
+// Prints every event as the JSON line the daemon would have written, so
+// tools that read activity_DATE.jsonl can be pointed at binary logs (.rlog)
+// through a pipe. JSONL input is passed through; gzipped archives of either
+// are read as they are. Damaged binary records are reported and skipped,
+// and the events around them still printed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "activity_log.h"
+#include "rlog.h"
+
+static void usage(void) {
+    fprintf(stderr, "Usage: restly-log cat --json FILE...\n");
+}
+
+static int cat_json(const char* path) {
+    size_t len;
+    unsigned char* data = rlog_load_file(path, &len);
+    if (!data) {
+        fprintf(stderr, "restly-log: cannot read %s\n", path);
+        return 1;
+    }
+    if (!rlog_is_rlog(data, len)) {
+        fwrite(data, 1, len, stdout);
+        free(data);
+        return 0;
+    }
+
+    RlogReader reader;
+    ActivityEvent event;
+    RlogResult result;
+    char line[2048];
+    rlog_reader_init(&reader, data, len);
+    while ((result = rlog_read_event(&reader, &event)) == RLOG_EVENT) {
+        size_t n = activity_event_to_json(&event, line, sizeof(line));
+        fwrite(line, 1, n, stdout);
+    }
+    free(data);
+    if (reader.skipped) {
+        fprintf(stderr, "restly-log: %s: skipped %zu damaged bytes\n", path, reader.skipped);
+    }
+    if (result == RLOG_TRUNCATED) {
+        fprintf(stderr, "restly-log: %s: truncated record at byte %zu\n", path, reader.pos);
+    }
+    return reader.skipped || result != RLOG_END;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4 || strcmp(argv[1], "cat") != 0 || strcmp(argv[2], "--json") != 0) {
+        usage();
+        return 2;
+    }
+    int failed = 0;
+    for (int i = 3; i < argc; i++) {
+        failed |= cat_json(argv[i]);
+    }
+    return failed;
+}
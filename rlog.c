@@ -0,0 +1,489 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <zlib.h>
+#include "crc32c.h"
+#include "rlog.h"
+
+static const uint8_t rlog_magic[5] = { 0, 'R', 'L', 'O', 'G' };
+
+// Encoding
+
+typedef struct {
+    uint8_t* buf;
+    size_t len;
+    size_t size;
+    bool overflow;
+} Writer;
+
+static void put_byte(Writer* w, uint8_t byte) {
+    if (w->len < w->size) {
+        w->buf[w->len++] = byte;
+    } else {
+        w->overflow = true;
+    }
+}
+
+static void put_varint(Writer* w, uint64_t value) {
+    while (value >= 0x80) {
+        put_byte(w, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put_byte(w, (uint8_t)value);
+}
+
+static void put_svarint(Writer* w, int64_t value) {
+    put_varint(w, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void put_bytes(Writer* w, const void* data, size_t len) {
+    if (w->len + len <= w->size) {
+        memcpy(w->buf + w->len, data, len);
+        w->len += len;
+    } else {
+        w->overflow = true;
+    }
+}
+
+static void put_u32(Writer* w, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        put_byte(w, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+static void put_string(Writer* w, const char* value) {
+    size_t len = strlen(value);
+    put_varint(w, len);
+    put_bytes(w, value, len);
+}
+
+static bool same_state(const ActivityEvent* a, const ActivityEvent* b) {
+    return a->system_state.is_paused == b->system_state.is_paused
+        && a->system_state.in_deep_work_session == b->system_state.in_deep_work_session
+        && a->system_state.next_break_in_minutes == b->system_state.next_break_in_minutes
+        && a->system_state.total_breaks_today == b->system_state.total_breaks_today
+        && a->system_state.total_work_minutes_today == b->system_state.total_work_minutes_today;
+}
+
+size_t rlog_write_header(RlogContext* ctx, time_t base, uint8_t* buf, size_t size) {
+    Writer w = { buf, 0, size, false };
+    put_bytes(&w, rlog_magic, sizeof(rlog_magic));
+    put_byte(&w, RLOG_VERSION);
+    put_varint(&w, (uint64_t)base);
+    if (w.overflow) {
+        return 0;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->timestamp = base;
+    return w.len;
+}
+
+size_t rlog_write_event(RlogContext* ctx, const ActivityEvent* event, uint8_t* buf, size_t size) {
+    uint8_t body[RLOG_RECORD_MAX];
+    Writer w = { body, 0, sizeof(body), false };
+    bool has_state = !ctx->have_state || !same_state(event, &ctx->state);
+
+    put_byte(&w, (uint8_t)((event->event_type & RLOG_TYPE_MASK)
+                           | (event->group_id ? RLOG_HAS_GROUP : 0)
+                           | (has_state ? RLOG_HAS_STATE : 0)));
+    put_svarint(&w, (int64_t)event->timestamp - (int64_t)ctx->timestamp);
+    if (event->group_id) {
+        put_svarint(&w, (int64_t)event->group_id - (int64_t)ctx->group_id);
+    }
+    if (has_state) {
+        put_byte(&w, (uint8_t)(event->system_state.is_paused | event->system_state.in_deep_work_session << 1));
+        put_svarint(&w, event->system_state.next_break_in_minutes);
+        put_svarint(&w, event->system_state.total_breaks_today);
+        put_svarint(&w, event->system_state.total_work_minutes_today);
+    }
+
+    switch (event->event_type) {
+        case EVENT_BREAK_SHOWN:
+        case EVENT_BREAK_COMPLETED:
+            put_svarint(&w, event->event_data.break_event.break_type);
+            put_svarint(&w, event->event_data.break_event.duration_seconds);
+            put_byte(&w, event->event_data.break_event.user_dismissed);
+            break;
+        case EVENT_SESSION_STARTED:
+        case EVENT_SESSION_ENDED:
+            put_svarint(&w, event->event_data.session_event.session_type);
+            put_svarint(&w, event->event_data.session_event.duration_minutes);
+            break;
+        case EVENT_PAUSE_TOGGLED:
+            put_byte(&w, event->event_data.pause_event.is_paused);
+            break;
+        case EVENT_BREAK_RESCHEDULED:
+            put_svarint(&w, event->event_data.reschedule_event.delay_minutes);
+            break;
+        case EVENT_COMMAND_RECEIVED:
+            put_string(&w, event->event_data.command_event.command_text);
+            put_string(&w, event->event_data.command_event.intent);
+            put_string(&w, event->event_data.command_event.intent_source);
+            put_svarint(&w, lroundf(event->event_data.command_event.confidence * 1000));
+            break;
+        case EVENT_COMMAND_CORRECTED:
+            put_string(&w, event->event_data.correction_event.typo);
+            put_string(&w, event->event_data.correction_event.correction);
+            put_svarint(&w, event->event_data.correction_event.distance);
+            break;
+        case EVENT_POPUP_SHOWN:
+            put_string(&w, event->event_data.popup_event.kind);
+            put_svarint(&w, event->event_data.popup_event.latency_ms);
+            put_byte(&w, event->event_data.popup_event.mapped);
+            break;
+        default:
+            break;
+    }
+
+    if (w.overflow) {
+        return 0;
+    }
+
+    Writer out = { buf, 0, size, false };
+    put_varint(&out, w.len);
+    put_bytes(&out, body, w.len);
+    if (!out.overflow) {
+        put_u32(&out, crc32c(buf, out.len));
+    }
+    if (out.overflow || out.len > RLOG_RECORD_MAX) {
+        return 0;
+    }
+
+    ctx->timestamp = event->timestamp;
+    if (event->group_id) {
+        ctx->group_id = event->group_id;
+    }
+    if (has_state) {
+        ctx->state.system_state = event->system_state;
+        ctx->have_state = true;
+    }
+    return out.len;
+}
+
+// Decoding
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool bad;
+} Cursor;
+
+static uint8_t get_byte(Cursor* c) {
+    if (c->p >= c->end) {
+        c->bad = true;
+        return 0;
+    }
+    return *c->p++;
+}
+
+static uint64_t get_varint(Cursor* c) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = get_byte(c);
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    c->bad = true;
+    return 0;
+}
+
+static int64_t get_svarint(Cursor* c) {
+    uint64_t value = get_varint(c);
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static int get_int(Cursor* c) {
+    return (int)get_svarint(c);
+}
+
+static void get_string(Cursor* c, char* out, size_t size) {
+    uint64_t len = get_varint(c);
+    if (c->bad || len >= size || len > (uint64_t)(c->end - c->p)) {
+        c->bad = true;
+        out[0] = '\0';
+        return;
+    }
+    memcpy(out, c->p, len);
+    out[len] = '\0';
+    c->p += len;
+}
+
+bool rlog_is_rlog(const void* data, size_t len) {
+    return len >= sizeof(rlog_magic) && memcmp(data, rlog_magic, sizeof(rlog_magic)) == 0;
+}
+
+void rlog_reader_init(RlogReader* reader, const void* data, size_t len) {
+    memset(reader, 0, sizeof(*reader));
+    reader->data = data;
+    reader->len = len;
+}
+
+typedef enum {
+    SPAN_WHOLE,
+    SPAN_SHORT,                     // the data ends first
+    SPAN_BAD
+} Span;
+
+// Segment header at p, magic included: its length, version and base
+static Span header_span(const uint8_t* p, const uint8_t* end, size_t* len, int* version, time_t* base) {
+    size_t have = (size_t)(end - p);
+    if (memcmp(p, rlog_magic, have < sizeof(rlog_magic) ? have : sizeof(rlog_magic)) != 0) {
+        return SPAN_BAD;
+    }
+    if (have < sizeof(rlog_magic) + 1) {
+        return SPAN_SHORT;
+    }
+    *version = p[sizeof(rlog_magic)];
+    if (*version < 1 || *version > RLOG_VERSION) {
+        return SPAN_BAD;
+    }
+    Cursor c = { p + sizeof(rlog_magic) + 1, end, false };
+    *base = (time_t)get_varint(&c);
+    if (c.bad) {
+        return c.p >= end ? SPAN_SHORT : SPAN_BAD;
+    }
+    *len = (size_t)(c.p - p);
+    return SPAN_WHOLE;
+}
+
+// Record at p in a segment of version: its whole length, and where its
+// bytes start and how many there are
+static Span record_span(const uint8_t* p, const uint8_t* end, int version,
+                        size_t* len, size_t* body, size_t* body_len) {
+    Cursor c = { p, end, false };
+    uint64_t n = get_varint(&c);
+    if (c.bad) {
+        return c.p >= end ? SPAN_SHORT : SPAN_BAD;
+    }
+    size_t crc_len = version >= 2 ? 4 : 0;
+    if (n == 0 || n > RLOG_RECORD_MAX || (size_t)(c.p - p) + n + crc_len > RLOG_RECORD_MAX) {
+        return SPAN_BAD;
+    }
+    size_t total = (size_t)(c.p - p) + n + crc_len;
+    if (total > (size_t)(end - p)) {
+        return SPAN_SHORT;
+    }
+    if (crc_len) {
+        const uint8_t* q = p + total - 4;
+        uint32_t crc = (uint32_t)q[0] | (uint32_t)q[1] << 8 | (uint32_t)q[2] << 16 | (uint32_t)q[3] << 24;
+        if (crc != crc32c(p, total - 4)) {
+            return SPAN_BAD;
+        }
+    }
+    *len = total;
+    *body = (size_t)(c.p - p);
+    *body_len = n;
+    return SPAN_WHOLE;
+}
+
+size_t rlog_whole_records(const void* data, size_t len, int version) {
+    const uint8_t* p = data;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t n, body, body_len;
+        time_t base;
+        if (p[pos] == 0) {
+            if (header_span(p + pos, p + len, &n, &version, &base) != SPAN_WHOLE) {
+                break;
+            }
+        } else if (version == 0 || record_span(p + pos, p + len, version, &n, &body, &body_len) != SPAN_WHOLE) {
+            break;
+        }
+        pos += n;
+    }
+    return pos;
+}
+
+int rlog_version_at_end(const void* data, size_t len) {
+    const uint8_t* p = data;
+    for (size_t i = len; i-- > 0;) {
+        if (p[i] == 0 && len - i > sizeof(rlog_magic) && memcmp(p + i, rlog_magic, sizeof(rlog_magic)) == 0
+            && rlog_whole_records(p + i, len - i, 0) == len - i) {
+            return p[i + sizeof(rlog_magic)];
+        }
+    }
+    return 0;
+}
+
+// Where the next segment header after the reader's position starts, 0 if
+// there is none
+static size_t next_segment(const RlogReader* reader) {
+    const uint8_t* p = reader->data + reader->pos + 1;
+    const uint8_t* end = reader->data + reader->len;
+    while (p < end && (p = memchr(p, 0, (size_t)(end - p))) != NULL) {
+        if ((size_t)(end - p) >= sizeof(rlog_magic) && memcmp(p, rlog_magic, sizeof(rlog_magic)) == 0) {
+            return (size_t)(p - reader->data);
+        }
+        p++;
+    }
+    return 0;
+}
+
+// Damage at the reader's position: skip to the next segment, or to the end
+static void resync(RlogReader* reader) {
+    size_t next = next_segment(reader);
+    if (next == 0) {
+        next = reader->len;
+    }
+    reader->skipped += next - reader->pos;
+    reader->pos = next;
+    reader->in_segment = false;
+}
+
+RlogResult rlog_read_event(RlogReader* reader, ActivityEvent* event) {
+    for (;;) {
+        if (reader->pos >= reader->len) {
+            return RLOG_END;
+        }
+        const uint8_t* p = reader->data + reader->pos;
+        const uint8_t* end = reader->data + reader->len;
+        size_t len, body, body_len;
+        Span span;
+        if (*p == 0) {
+            // Zero length: the header of the next segment
+            time_t base;
+            span = header_span(p, end, &len, &reader->version, &base);
+            if (span == SPAN_WHOLE) {
+                memset(&reader->ctx, 0, sizeof(reader->ctx));
+                reader->ctx.timestamp = base;
+                reader->in_segment = true;
+                reader->pos += len;
+                continue;
+            }
+        } else if (!reader->in_segment) {
+            span = SPAN_BAD;
+        } else {
+            span = record_span(p, end, reader->version, &len, &body, &body_len);
+        }
+        if (span == SPAN_SHORT && next_segment(reader) == 0) {
+            return RLOG_TRUNCATED;
+        }
+        if (span != SPAN_WHOLE) {
+            resync(reader);
+            continue;
+        }
+
+        Cursor c = { p + body, p + body + body_len, false };
+        size_t next = reader->pos + len;
+
+        memset(event, 0, sizeof(*event));
+        uint8_t flags = get_byte(&c);
+        event->event_type = flags & RLOG_TYPE_MASK;
+        event->timestamp = reader->ctx.timestamp + (time_t)get_svarint(&c);
+        if (flags & RLOG_HAS_GROUP) {
+            event->group_id = (unsigned int)((int64_t)reader->ctx.group_id + get_svarint(&c));
+        }
+        if (flags & RLOG_HAS_STATE) {
+            uint8_t bits = get_byte(&c);
+            reader->ctx.state.system_state.is_paused = bits & 1;
+            reader->ctx.state.system_state.in_deep_work_session = (bits >> 1) & 1;
+            reader->ctx.state.system_state.next_break_in_minutes = get_int(&c);
+            reader->ctx.state.system_state.total_breaks_today = get_int(&c);
+            reader->ctx.state.system_state.total_work_minutes_today = get_int(&c);
+            reader->ctx.have_state = true;
+        }
+        if (c.bad) {
+            resync(reader);
+            continue;
+        }
+        reader->ctx.timestamp = event->timestamp;
+        if (flags & RLOG_HAS_GROUP) {
+            reader->ctx.group_id = event->group_id;
+        }
+        event->system_state = reader->ctx.state.system_state;
+
+        bool known = true;
+        switch (event->event_type) {
+            case EVENT_BREAK_SHOWN:
+            case EVENT_BREAK_COMPLETED:
+                event->event_data.break_event.break_type = get_int(&c);
+                event->event_data.break_event.duration_seconds = get_int(&c);
+                event->event_data.break_event.user_dismissed = get_byte(&c) != 0;
+                break;
+            case EVENT_SESSION_STARTED:
+            case EVENT_SESSION_ENDED:
+                event->event_data.session_event.session_type = get_int(&c);
+                event->event_data.session_event.duration_minutes = get_int(&c);
+                break;
+            case EVENT_PAUSE_TOGGLED:
+                event->event_data.pause_event.is_paused = get_byte(&c) != 0;
+                break;
+            case EVENT_BREAK_RESCHEDULED:
+                event->event_data.reschedule_event.delay_minutes = get_int(&c);
+                break;
+            case EVENT_COMMAND_RECEIVED:
+                get_string(&c, event->event_data.command_event.command_text,
+                           sizeof(event->event_data.command_event.command_text));
+                get_string(&c, event->event_data.command_event.intent,
+                           sizeof(event->event_data.command_event.intent));
+                get_string(&c, event->event_data.command_event.intent_source,
+                           sizeof(event->event_data.command_event.intent_source));
+                event->event_data.command_event.confidence = get_int(&c) / 1000.0f;
+                break;
+            case EVENT_COMMAND_CORRECTED:
+                get_string(&c, event->event_data.correction_event.typo,
+                           sizeof(event->event_data.correction_event.typo));
+                get_string(&c, event->event_data.correction_event.correction,
+                           sizeof(event->event_data.correction_event.correction));
+                event->event_data.correction_event.distance = get_int(&c);
+                break;
+            case EVENT_POPUP_SHOWN:
+                get_string(&c, event->event_data.popup_event.kind,
+                           sizeof(event->event_data.popup_event.kind));
+                event->event_data.popup_event.latency_ms = get_int(&c);
+                event->event_data.popup_event.mapped = get_byte(&c) != 0;
+                break;
+            case EVENT_APP_STARTED:
+            case EVENT_APP_STOPPED:
+                break;
+            default:
+                known = false;
+                break;
+        }
+        if (c.bad) {
+            resync(reader);
+            continue;
+        }
+        reader->pos = next;
+        if (!known) {
+            // A newer writer's event: its deltas and state are taken, its
+            // fields skipped
+            continue;
+        }
+        return RLOG_EVENT;
+    }
+}
+
+// Files
+
+unsigned char* rlog_load_file(const char* path, size_t* len) {
+    gzFile file = gzopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    size_t size = 1 << 16;
+    unsigned char* data = malloc(size);
+    *len = 0;
+    int n;
+    while (data && (n = gzread(file, data + *len, (unsigned)(size - *len))) > 0) {
+        *len += n;
+        if (*len == size) {
+            unsigned char* bigger = realloc(data, size * 2);
+            if (!bigger) {
+                free(data);
+                data = NULL;
+                break;
+            }
+            data = bigger;
+            size *= 2;
+        }
+    }
+    int status = gzclose(file);
+    if (status != Z_OK && status != Z_BUF_ERROR) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
@@ -0,0 +1,101 @@
+#ifndef RLOG_H
+#define RLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "activity_log.h"
+
+// Binary activity log (.rlog), the same events as the JSON lines in a
+// fraction of the space. A file is one or more segments, each a header and
+// then records:
+//
+//   header   00 'R' 'L' 'O' 'G' version  varint base_timestamp
+//   record   varint length (> 0), then that many bytes:
+//              u8 type | RLOG_HAS_GROUP | RLOG_HAS_STATE
+//              svarint timestamp - previous timestamp (the base for the first)
+//              [svarint group - previous group]
+//              [u8 is_paused | in_deep_work_session << 1,
+//               svarint next_break_in_minutes, total_breaks_today,
+//               total_work_minutes_today]
+//              event_data fields in struct order: integers and enums as
+//              svarints, bools as a byte, strings as varint length + bytes,
+//              confidence as svarint thousandths
+//            then u32 CRC32C of the length and the bytes (little-endian)
+//
+// varints are LEB128, svarints zigzag-encoded first. system_state is only
+// stored when it differs from the previous record's. A zero length starts
+// a new segment, which resets the deltas: a writer starts one whenever it
+// opens a file, so appending after a restart needs no earlier state, and
+// at least every RLOG_SEGMENT_RECORDS records. Readers skip the event_data
+// of event types they do not know.
+//
+// A record that fails its CRC (or will not decode) leaves the deltas after
+// it unknown, so readers pass over the rest of its segment and carry on
+// from the next header. Version 1 segments have no CRCs and are still read.
+#define RLOG_VERSION 2
+#define RLOG_HEADER_MAX 16
+#define RLOG_RECORD_MAX 512         // varint length and CRC included
+#define RLOG_SEGMENT_RECORDS 256
+#define RLOG_SEGMENT_MAX (RLOG_HEADER_MAX + RLOG_SEGMENT_RECORDS * RLOG_RECORD_MAX)
+
+#define RLOG_HAS_GROUP 0x20
+#define RLOG_HAS_STATE 0x40
+#define RLOG_TYPE_MASK 0x1f
+
+// Delta state shared by the writer and the reader of one segment
+typedef struct {
+    time_t timestamp;
+    unsigned int group_id;
+    bool have_state;
+    ActivityEvent state;            // only system_state is used
+} RlogContext;
+
+// Start a segment at base: writes its header into buf and resets ctx.
+// Returns the header length, 0 if size is too small.
+size_t rlog_write_header(RlogContext* ctx, time_t base, uint8_t* buf, size_t size);
+
+// Append one record; returns its length, or 0 (ctx untouched) if it does
+// not fit in size
+size_t rlog_write_event(RlogContext* ctx, const ActivityEvent* event, uint8_t* buf, size_t size);
+
+typedef enum {
+    RLOG_END,                       // no more data
+    RLOG_EVENT,                     // *event filled in
+    RLOG_TRUNCATED                  // data ends inside a record
+} RlogResult;
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    size_t pos;                     // start of the next record
+    bool in_segment;
+    int version;                    // of the current segment
+    size_t skipped;                 // bytes passed over as damaged
+    RlogContext ctx;
+} RlogReader;
+
+// Read from an in-memory .rlog image; data must stay valid while reading
+void rlog_reader_init(RlogReader* reader, const void* data, size_t len);
+RlogResult rlog_read_event(RlogReader* reader, ActivityEvent* event);
+
+// True if data starts like an .rlog file
+bool rlog_is_rlog(const void* data, size_t len);
+
+// Version of the segment the end of data is in: that of the last header
+// in data followed by nothing but whole records, 0 if there is none. Only
+// version 2 segments are bounded (RLOG_SEGMENT_MAX), so a version 1 header
+// may be further back than a caller's window.
+int rlog_version_at_end(const void* data, size_t len);
+
+// Length of the whole records and segment headers that data starts with;
+// data begins at a record boundary, inside a segment of the given version
+// (0 if before any). What follows them is a torn or damaged tail.
+size_t rlog_whole_records(const void* data, size_t len, int version);
+
+// Read a whole file into memory, gunzipping it if it is gzipped; the
+// caller frees the result. NULL if it cannot be read.
+unsigned char* rlog_load_file(const char* path, size_t* len);
+
+#endif
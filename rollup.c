@@ -0,0 +1,218 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "rollup.h"
+
+#define DAY_WORDS (1 + ROLLUP_FIELDS + 24 * ROLLUP_FIELDS)
+#define WEEK_WORDS (1 + ROLLUP_FIELDS)
+#define ROLLUP_FILE_SIZE (ROLLUP_HEADER_SIZE + 4 * (ROLLUP_WEEKS * WEEK_WORDS + ROLLUP_DAYS * DAY_WORDS))
+
+static const uint8_t rollup_magic[4] = { 'R', 'R', 'U', 'P' };
+
+// Days since 1970-01-01 of a civil date, and back (Howard Hinnant's algorithms)
+static long days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long year_of_era = year - era * 400;
+    long day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+static uint32_t civil_date(long days) {
+    days += 719468;
+    long era = (days >= 0 ? days : days - 146096) / 146097;
+    long day_of_era = days - era * 146097;
+    long year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    long day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    long mp = (5 * day_of_year + 2) / 153;
+    long day = day_of_year - (153 * mp + 2) / 5 + 1;
+    long month = mp < 10 ? mp + 3 : mp - 9;
+    long year = year_of_era + era * 400 + (month <= 2);
+    return (uint32_t)(year * 10000 + month * 100 + day);
+}
+
+static long local_day(time_t timestamp, int* hour) {
+    struct tm local_time;
+    localtime_r(&timestamp, &local_time);
+    if (hour) {
+        *hour = local_time.tm_hour;
+    }
+    return days_from_civil(local_time.tm_year + 1900, local_time.tm_mon + 1, local_time.tm_mday);
+}
+
+static RollupDay* day_slot(Rollup* rollup, long day) {
+    RollupDay* slot = &rollup->days[day % ROLLUP_DAYS];
+    uint32_t date = civil_date(day);
+    if (slot->date != date) {
+        memset(slot, 0, sizeof(*slot));
+        slot->date = date;
+    }
+    return slot;
+}
+
+static void count(RollupDay* day, int hour, RollupField field, uint32_t n) {
+    day->totals[field] += n;
+    day->hours[hour][field] += n;
+}
+
+void rollup_add(Rollup* rollup, const ActivityEvent* event) {
+    int hour;
+    RollupDay* day = day_slot(rollup, local_day(event->timestamp, &hour));
+    count(day, hour, ROLLUP_EVENTS, 1);
+    switch (event->event_type) {
+        case EVENT_BREAK_SHOWN:
+            count(day, hour, ROLLUP_BREAKS_SHOWN, 1);
+            count(day, hour, event->event_data.break_event.break_type == BREAK_TYPE_EYE_CARE
+                                 ? ROLLUP_EYE_CARE_BREAKS : ROLLUP_CUSTOM_MESSAGE_BREAKS, 1);
+            break;
+        case EVENT_BREAK_COMPLETED:
+            count(day, hour, ROLLUP_BREAKS_COMPLETED, 1);
+            break;
+        case EVENT_SESSION_STARTED:
+            count(day, hour, ROLLUP_SESSIONS, 1);
+            if (event->event_data.session_event.session_type == SESSION_TYPE_DEEP_WORK) {
+                count(day, hour, ROLLUP_DEEP_WORK_SESSIONS, 1);
+            }
+            break;
+        case EVENT_PAUSE_TOGGLED:
+            count(day, hour, ROLLUP_PAUSES, 1);
+            break;
+        case EVENT_BREAK_RESCHEDULED:
+            count(day, hour, ROLLUP_RESCHEDULES, 1);
+            break;
+        case EVENT_COMMAND_RECEIVED:
+            count(day, hour, ROLLUP_COMMANDS, 1);
+            break;
+        default:
+            break;
+    }
+
+    // Work minutes go to the hour in which the running total grew, so the
+    // day's total is the last total_work_minutes_today
+    int work_minutes = event->system_state.total_work_minutes_today;
+    if (work_minutes > 0 && (uint32_t)work_minutes > day->totals[ROLLUP_WORK_MINUTES]) {
+        count(day, hour, ROLLUP_WORK_MINUTES, (uint32_t)work_minutes - day->totals[ROLLUP_WORK_MINUTES]);
+    }
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+    return p + 4;
+}
+
+static const uint8_t* get_u32(const uint8_t* p, uint32_t* value) {
+    *value = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    return p + 4;
+}
+
+bool rollup_save(const Rollup* rollup, const char* path, time_t now) {
+    static uint8_t buf[ROLLUP_FILE_SIZE];
+    memcpy(buf, rollup_magic, sizeof(rollup_magic));
+    buf[4] = ROLLUP_VERSION;
+    buf[5] = ROLLUP_FIELDS;
+    buf[6] = ROLLUP_DAYS;
+    buf[7] = ROLLUP_WEEKS;
+
+    uint8_t* p = buf + ROLLUP_HEADER_SIZE;
+    long today = local_day(now, NULL);
+    long monday = today - (today + 3) % 7;      // 1970-01-01 was a Thursday
+    for (int week = 0; week < ROLLUP_WEEKS; week++, monday -= 7) {
+        uint32_t totals[ROLLUP_FIELDS] = {0};
+        for (long day = monday; day < monday + 7; day++) {
+            const RollupDay* slot = &rollup->days[day % ROLLUP_DAYS];
+            if (slot->date != civil_date(day)) {
+                continue;
+            }
+            for (int field = 0; field < ROLLUP_FIELDS; field++) {
+                totals[field] += slot->totals[field];
+            }
+        }
+        p = put_u32(p, civil_date(monday));
+        for (int field = 0; field < ROLLUP_FIELDS; field++) {
+            p = put_u32(p, totals[field]);
+        }
+    }
+    for (int i = 0; i < ROLLUP_DAYS; i++) {
+        const RollupDay* slot = &rollup->days[i];
+        p = put_u32(p, slot->date);
+        for (int field = 0; field < ROLLUP_FIELDS; field++) {
+            p = put_u32(p, slot->totals[field]);
+        }
+        for (int hour = 0; hour < 24; hour++) {
+            for (int field = 0; field < ROLLUP_FIELDS; field++) {
+                p = put_u32(p, slot->hours[hour][field]);
+            }
+        }
+    }
+    put_u32(buf + 8, (uint32_t)crc32(0, buf + ROLLUP_HEADER_SIZE, ROLLUP_FILE_SIZE - ROLLUP_HEADER_SIZE));
+
+    char partial[512];
+    snprintf(partial, sizeof(partial), "%s.tmp", path);
+    int fd = open(partial, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    size_t done = 0;
+    while (done < sizeof(buf)) {
+        ssize_t n = write(fd, buf + done, sizeof(buf) - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    // On disk before the rename, so a crash leaves the old file or the new
+    bool ok = done == sizeof(buf) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok && rename(partial, path) == 0;
+    if (!ok) {
+        unlink(partial);
+    }
+    return ok;
+}
+
+bool rollup_load(Rollup* rollup, const char* path) {
+    static uint8_t buf[ROLLUP_FILE_SIZE];
+    memset(rollup, 0, sizeof(*rollup));
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    size_t len = fread(buf, 1, sizeof(buf), file);
+    bool whole = len == sizeof(buf) && fgetc(file) == EOF;
+    fclose(file);
+
+    uint32_t crc;
+    if (!whole || memcmp(buf, rollup_magic, sizeof(rollup_magic)) != 0 || buf[4] != ROLLUP_VERSION
+        || buf[5] != ROLLUP_FIELDS || buf[6] != ROLLUP_DAYS || buf[7] != ROLLUP_WEEKS) {
+        return false;
+    }
+    get_u32(buf + 8, &crc);
+    if (crc != (uint32_t)crc32(0, buf + ROLLUP_HEADER_SIZE, ROLLUP_FILE_SIZE - ROLLUP_HEADER_SIZE)) {
+        return false;
+    }
+
+    // Weekly sums are derived; only the days are kept
+    const uint8_t* p = buf + ROLLUP_HEADER_SIZE + 4 * ROLLUP_WEEKS * WEEK_WORDS;
+    for (int i = 0; i < ROLLUP_DAYS; i++) {
+        RollupDay* slot = &rollup->days[i];
+        p = get_u32(p, &slot->date);
+        for (int field = 0; field < ROLLUP_FIELDS; field++) {
+            p = get_u32(p, &slot->totals[field]);
+        }
+        for (int hour = 0; hour < 24; hour++) {
+            for (int field = 0; field < ROLLUP_FIELDS; field++) {
+                p = get_u32(p, &slot->hours[hour][field]);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "activity_log.h"
+
+// Daily and weekly activity totals, kept up to date by the logger in
+// activity/rollup so the dashboard and summaries need not read the logs.
+// The file is rewritten whole (to rollup.tmp, synced, then renamed over it) and
+// all of it is little-endian u32s after the header:
+//
+//   header   'R' 'R' 'U' 'P' version fields days weeks, crc32 of the rest
+//   weeks    weeks x { Monday as YYYYMMDD, totals[fields] }, this week first
+//   days     days x { YYYYMMDD or 0 if unused, totals[fields], hours[24][fields] }
+//
+// A date's slot is its day number since 1970-01-01 modulo days, so a day
+// is found without a search; hours are local. Fields, in order:
+typedef enum {
+    ROLLUP_EVENTS,
+    ROLLUP_BREAKS_SHOWN,
+    ROLLUP_BREAKS_COMPLETED,
+    ROLLUP_EYE_CARE_BREAKS,         // shown, by type
+    ROLLUP_CUSTOM_MESSAGE_BREAKS,
+    ROLLUP_SESSIONS,
+    ROLLUP_DEEP_WORK_SESSIONS,
+    ROLLUP_PAUSES,
+    ROLLUP_RESCHEDULES,
+    ROLLUP_COMMANDS,
+    ROLLUP_WORK_MINUTES,            // growth of total_work_minutes_today
+    ROLLUP_FIELDS
+} RollupField;
+
+#define ROLLUP_VERSION 1
+#define ROLLUP_DAYS 28              // enough for this week and the three before
+#define ROLLUP_WEEKS 4
+#define ROLLUP_HEADER_SIZE 12
+
+typedef struct {
+    uint32_t date;
+    uint32_t totals[ROLLUP_FIELDS];
+    uint32_t hours[24][ROLLUP_FIELDS];
+} RollupDay;
+
+typedef struct {
+    RollupDay days[ROLLUP_DAYS];
+} Rollup;
+
+// Fill rollup from path; false, with rollup empty, if the file is missing
+// or damaged
+bool rollup_load(Rollup* rollup, const char* path);
+
+// Count event in its day and hour, starting the day's slot afresh if it
+// held an older day
+void rollup_add(Rollup* rollup, const ActivityEvent* event);
+
+// Replace path with rollup, weekly sums taken for the weeks up to now's
+bool rollup_save(const Rollup* rollup, const char* path, time_t now);
+
+#endif
@@ -4,12 +4,16 @@
 #include <time.h>
 #include <string.h>
 #include <unistd.h>
-#include <ctype.h>
 #include "timer.h"
 #include "config.h"
 #include "popup.h"
 #include "command_queue.h"
 #include "activity_log.h"
+#include "nl_parser.h"
+#include "nl_classify.h"
+#include "event_loop.h"
+#include "control_socket.h"
+#include "completion.h"
 
 // Global state for the timer (exposed for activity logging)
 bool is_paused = false;
@@ -17,15 +21,78 @@ time_t next_break_time = 0;
 bool in_deep_work_session = false;
 static time_t session_end_time = 0;
 static time_t deep_work_start_time = 0;
+static time_t pause_until = 0;            // 0: paused until resumed
+static int break_interval_seconds = 20 * 60;
+
+// Steps of a multi-intent command that start later ("... then focus 90 min")
+#define MAX_PENDING_ACTIONS 8
+typedef struct {
+    time_t due;
+    NLCommand command;
+} PendingAction;
+
+static PendingAction pending_actions[MAX_PENDING_ACTIONS];
+static int pending_count = 0;
+
+static void run_pending_actions(time_t current_time);
+
+// Eye care break, played step by step in a single popup window
+static const PopupStep eye_care_steps[] = {
+    {"Break Time ദ്ദി( • ᗜ - ) ✧", 3},
+    {"Let's unwind your eyes \n and neck (˶ᵔ ᵕ ᵔ˶)", 3},
+    {"Close your eyes for 5 sec \n and roll them (˶ᵔ ᵕ ᵔ˶)", 6},
+    {"Look at smth far away \n for 20 sec (˶ᵔ ᵕ ᵔ˶)", 21},
+    {"Stretch your neck to the left (˶ᵔ ᵕ ᵔ˶)", 3},
+    {"Now to the right (˶ᵔ ᵕ ᵔ˶)", 3},
+    {"Now look up for 3 sec (˶ᵔ ᵕ ᵔ˶)", 3},
+    {"Now look down for 3 sec (˶ᵔ ᵕ ᵔ˶)", 3},
+    {"Good job! wait for me again!ദ്ദി(˵ •̀ ᴗ - ˵ ) ✧", 2},
+};
+#define EYE_CARE_STEP_COUNT ((int)(sizeof(eye_care_steps) / sizeof(eye_care_steps[0])))
+
+static int eye_care_duration(void) {
+    int total = 0;
+    for (int i = 0; i < EYE_CARE_STEP_COUNT; i++) {
+        total += eye_care_steps[i].seconds;
+    }
+    return total;
+}
+
+static void on_eye_care_done(unsigned int id, bool completed, int elapsed_seconds) {
+    (void)id;
+    log_break_completed(BREAK_TYPE_EYE_CARE, completed ? eye_care_duration() : elapsed_seconds, false);
+}
+
+static void on_popup_shown(PopupKind kind, long long latency_us, bool mapped) {
+    static const char *kind_names[POPUP_KIND_COUNT] = {"status", "confirmation", "routine"};
+    log_popup_shown(kind_names[kind], (int)(latency_us / 1000), mapped);
+}
 
 void start_timer(AppConfig config)
 {
     // Initialize activity logging
+    activity_log_set_format(config.log_format);
+    activity_log_set_db(config.activity_db);
     init_activity_logging();
     
+    // Optional offline intent model; keyword rules are used without it
+    nl_classifier_load(get_intent_model_path());
+    
+    // Start the popup renderer, or connect to the desktop's notification server
+    popup_set_backend(config.popup_backend);
+    popup_init();
+    if (config.log_popups) {
+        popup_set_shown_callback(on_popup_shown);
+    }
+    
+    // Palette completions, served on the control socket between ticks
+    completion_init();
+    control_socket_init();
+    
     time_t ctime = time(NULL);
     struct tm *lt = localtime(&ctime);
     int inter_sec = config.interval_minutes * 60;
+    break_interval_seconds = inter_sec;
     int s_hour, e_hour, s_min, e_min;
     sscanf(config.start_time, "%2d:%2d", &s_hour, &s_min);
     sscanf(config.end_time, "%2d:%2d", &e_hour, &e_min);
@@ -33,12 +100,22 @@ void start_timer(AppConfig config)
     // Initialize next break time
     next_break_time = time(NULL) + inter_sec;
 
-    while (true)
+    while (!event_loop_stopped())
     {   
-        // Check for commands from controller every 5 seconds
+        // Check for commands from controller every tick
         process_command_queue();
         
         time_t current_time = time(NULL);
+        
+        // End timed pauses ("pause for 30 minutes") and run deferred steps
+        if (is_paused && pause_until != 0 && current_time >= pause_until) {
+            is_paused = false;
+            pause_until = 0;
+            next_break_time = current_time + inter_sec;
+            log_pause_toggled(false);
+        }
+        run_pending_actions(current_time);
+        
         struct tm *lt = localtime(&current_time);
         int c_hour = lt->tm_hour;
         int c_min = lt->tm_min;
@@ -59,7 +136,7 @@ void start_timer(AppConfig config)
         if (active && !is_paused) {
             // Check if deep work session has ended
             if (in_deep_work_session && current_time >= session_end_time) {
-                show_popup("Deep work session complete! Great job! 🎉", 5);
+                show_popup("Deep work session complete! Great job! 🎉", 5, POPUP_KIND_CONFIRMATION);
                 
                 // Log session completion
                 int actual_duration = (current_time - deep_work_start_time) / 60;
@@ -74,32 +151,16 @@ void start_timer(AppConfig config)
             if (!in_deep_work_session && current_time >= next_break_time) {
                 if (config.eye_care == 0) {
                     log_break_shown(BREAK_TYPE_CUSTOM_MESSAGE, 5);
-                    show_popup(config.message, 5);
+                    show_popup(config.message, 5, POPUP_KIND_ROUTINE);
                     log_break_completed(BREAK_TYPE_CUSTOM_MESSAGE, 5, false);
                 } else if (config.eye_care == 1) {
-                    // Log eye care break sequence
-                    int total_duration = 3+3+6+21+3+3+3+3+2; // Total eye care routine duration
+                    // One popup plays the whole routine; completion is
+                    // logged from on_eye_care_done when it reports back
+                    int total_duration = eye_care_duration();
                     log_break_shown(BREAK_TYPE_EYE_CARE, total_duration);
-                    
-                    show_popup("Break Time ദ്ദി( • ᗜ - ) ✧", 3);
-                    sleep(3);
-                    show_popup("Let's unwind your eyes \n and neck (˶ᵔ ᵕ ᵔ˶)", 3);
-                    sleep(3);
-                    show_popup("Close your eyes for 5 sec \n and roll them (˶ᵔ ᵕ ᵔ˶)", 6);
-                    sleep(6);
-                    show_popup("Look at smth far away \n for 20 sec (˶ᵔ ᵕ ᵔ˶)", 21);
-                    sleep(21);
-                    show_popup("Stretch your neck to the left (˶ᵔ ᵕ ᵔ˶)", 3);
-                    sleep(3);
-                    show_popup("Now to the right (˶ᵔ ᵕ ᵔ˶)", 3);
-                    sleep(3);
-                    show_popup("Now look up for 3 sec (˶ᵔ ᵕ ᵔ˶)", 3);
-                    sleep(3);
-                    show_popup("Now look down for 3 sec (˶ᵔ ᵕ ᵔ˶)", 3);
-                    sleep(3);
-                    show_popup("Good job! wait for me again!ദ്ദി(˵ •̀ ᴗ - ˵ ) ✧", 2);
-                    
-                    log_break_completed(BREAK_TYPE_EYE_CARE, total_duration, false);
+                    show_routine(eye_care_steps, EYE_CARE_STEP_COUNT,
+                                 POPUP_ROUTINE_COUNTDOWN | POPUP_ROUTINE_PROGRESS | POPUP_ROUTINE_RING,
+                                 on_eye_care_done);
                 }
                 
                 // Set next break time
@@ -107,11 +168,13 @@ void start_timer(AppConfig config)
             }
         }
         
-        // Sleep for 5 seconds before checking again
-        sleep(5);
+        // Serve socket requests for 5 seconds before checking again
+        event_loop_run_for(5 * 1000);
     }
     
     // Clean up activity logging on exit
+    control_socket_close();
+    popup_shutdown();
     cleanup_activity_logging();
 }
 
@@ -130,22 +193,23 @@ void set_deep_work_session(int duration_minutes) {
     strftime(time_str, sizeof(time_str), "%H:%M", localtime(&session_end_time));
     snprintf(message, sizeof(message), "Starting %d-minute deep work session! 🎯\nBreaks paused until %s", 
              duration_minutes, time_str);
-    show_popup(message, 5);
+    show_popup(message, 5, POPUP_KIND_CONFIRMATION);
 }
 
 void toggle_pause_resume() {
     is_paused = !is_paused;
+    pause_until = 0;
     
     // Log pause state change
     log_pause_toggled(is_paused);
     
     if (is_paused) {
-        show_popup("Restly paused ⏸️\nBreaks disabled until resumed", 3);
+        show_popup("Restly paused ⏸️\nBreaks disabled until resumed", 3, POPUP_KIND_CONFIRMATION);
     } else {
-        show_popup("Restly resumed ▶️\nBreaks re-enabled", 3);
+        show_popup("Restly resumed ▶️\nBreaks re-enabled", 3, POPUP_KIND_CONFIRMATION);
         // Reset break timer when resuming
         time_t current_time = time(NULL);
-        next_break_time = current_time + (20 * 60); // Default 20 min interval
+        next_break_time = current_time + break_interval_seconds;
     }
 }
 
@@ -157,124 +221,242 @@ void reschedule_next_break(int delay_minutes) {
     
     char message[128];
     snprintf(message, sizeof(message), "Break rescheduled by %d minutes ⏰", delay_minutes);
-    show_popup(message, 3);
+    show_popup(message, 3, POPUP_KIND_CONFIRMATION);
 }
 
-// Keyword-based natural language command parser
-void parse_natural_language_command(const char* text) {
-    if (!text || strlen(text) == 0) {
-        show_popup("Empty command received", 2);
-        return;
+// Timer state touched by NL commands. A command is applied to a copy and
+// committed in one step, so a multi-step command is a single transaction.
+typedef struct {
+    bool is_paused;
+    time_t pause_until;
+    time_t next_break_time;
+    bool in_deep_work_session;
+    time_t session_end_time;
+    time_t deep_work_start_time;
+} TimerState;
+
+// Log records produced while applying a transaction, written after commit
+typedef enum {
+    TXN_LOG_PAUSE,
+    TXN_LOG_SESSION_STARTED,
+    TXN_LOG_RESCHEDULE
+} TxnLogKind;
+
+typedef struct {
+    TxnLogKind kind;
+    int value;
+} TxnLog;
+
+#define MAX_TXN_LOGS (NL_MAX_ACTIONS * 2)
+
+static TimerState capture_state(void) {
+    TimerState state = {
+        .is_paused = is_paused,
+        .pause_until = pause_until,
+        .next_break_time = next_break_time,
+        .in_deep_work_session = in_deep_work_session,
+        .session_end_time = session_end_time,
+        .deep_work_start_time = deep_work_start_time
+    };
+    return state;
+}
+
+static void commit_state(const TimerState *state) {
+    is_paused = state->is_paused;
+    pause_until = state->pause_until;
+    next_break_time = state->next_break_time;
+    in_deep_work_session = state->in_deep_work_session;
+    session_end_time = state->session_end_time;
+    deep_work_start_time = state->deep_work_start_time;
+}
+
+static void add_txn_log(TxnLog *logs, int *count, TxnLogKind kind, int value) {
+    if (*count < MAX_TXN_LOGS) {
+        logs[*count].kind = kind;
+        logs[*count].value = value;
+        (*count)++;
     }
-    
-    // Log the command received
-    log_command_received(text);
-    
-    
-    // Convert to lowercase for case-insensitive matching
-    char lower_text[256];
-    strncpy(lower_text, text, sizeof(lower_text) - 1);
-    lower_text[sizeof(lower_text) - 1] = '\0';
-    
-    // Convert to lowercase
-    for (int i = 0; lower_text[i]; i++) {
-        lower_text[i] = tolower(lower_text[i]);
+}
+
+static void write_txn_logs(const TxnLog *logs, int count) {
+    for (int i = 0; i < count; i++) {
+        switch (logs[i].kind) {
+            case TXN_LOG_PAUSE:
+                log_pause_toggled(logs[i].value != 0);
+                break;
+            case TXN_LOG_SESSION_STARTED:
+                log_session_started(SESSION_TYPE_DEEP_WORK, logs[i].value);
+                break;
+            case TXN_LOG_RESCHEDULE:
+                log_break_rescheduled(logs[i].value);
+                break;
+        }
     }
+}
+
+// Apply one step at time `at` to state, describing it in message.
+// Returns how long the confirmation should stay up, 0 if there is nothing to apply.
+static int apply_nl_step(TimerState *state, const NLCommand *command, time_t at, bool toggle_pause,
+                         TxnLog *logs, int *log_count, char *message, size_t size) {
+    const NLTimeExpr *when = &command->time;
+    bool timed = when->kind != NL_TIME_NONE && when->duration_seconds > 0;
+    char time_str[16];
     
-    // Keyword matching patterns
-    if (strstr(lower_text, "reschedule") || strstr(lower_text, "delay") || strstr(lower_text, "postpone")) {
-        // Extract time duration
-        int delay_minutes = 15; // default
-        
-        // Look for numbers followed by time units
-        char* num_start = NULL;
-        for (int i = 0; lower_text[i]; i++) {
-            if (isdigit(lower_text[i])) {
-                num_start = &lower_text[i];
-                break;
+    switch (command->intent) {
+        case NL_INTENT_RESCHEDULE: {
+            // Extract time duration ("delay 1h30m", "reschedule until 3pm")
+            int delay_minutes = 15; // default
+            
+            if (when->kind == NL_TIME_DEADLINE) {
+                // Move the break to the requested clock time
+                int shift = (int)(when->deadline - state->next_break_time);
+                delay_minutes = shift > 0 ? (shift + 59) / 60 : 0;
+            } else if (when->kind == NL_TIME_DURATION) {
+                delay_minutes = nl_time_minutes(when);
             }
+            
+            state->next_break_time += delay_minutes * 60;
+            add_txn_log(logs, log_count, TXN_LOG_RESCHEDULE, delay_minutes);
+            snprintf(message, size, "Break rescheduled by %d minutes ⏰", delay_minutes);
+            return 3;
         }
         
-        if (num_start) {
-            int num = atoi(num_start);
+        case NL_INTENT_PAUSE:
+            // A bare "pause" keeps its old toggle behaviour
+            if (toggle_pause && !timed && state->is_paused) {
+                state->is_paused = false;
+                state->pause_until = 0;
+                state->next_break_time = at + break_interval_seconds;
+                add_txn_log(logs, log_count, TXN_LOG_PAUSE, 0);
+                snprintf(message, size, "Restly resumed ▶️\nBreaks re-enabled");
+                return 3;
+            }
             
-            // Check for time units
-            if (strstr(num_start, "minute") || strstr(num_start, "min")) {
-                delay_minutes = num;
-            } else if (strstr(num_start, "hour") || strstr(num_start, "hr")) {
-                delay_minutes = num * 60;
-            } else if (strstr(num_start, "second") || strstr(num_start, "sec")) {
-                delay_minutes = (num + 59) / 60; // Round up to nearest minute
+            if (!state->is_paused) {
+                add_txn_log(logs, log_count, TXN_LOG_PAUSE, 1);
+            }
+            state->is_paused = true;
+            state->pause_until = timed ? at + when->duration_seconds : 0;
+            if (timed) {
+                strftime(time_str, sizeof(time_str), "%H:%M", localtime(&state->pause_until));
+                snprintf(message, size, "Restly paused ⏸️ for %d minutes\nBreaks resume at %s",
+                         nl_time_minutes(when), time_str);
             } else {
-                // Assume minutes if no unit specified
-                delay_minutes = num;
+                snprintf(message, size, "Restly paused ⏸️\nBreaks disabled until resumed");
             }
-        }
-        
-        reschedule_next_break(delay_minutes);
-        char message[128];
-        snprintf(message, sizeof(message), "Break rescheduled by %d minutes ⏰", delay_minutes);
-        show_popup(message, 3);
-    }
-    else if (strstr(lower_text, "pause") || strstr(lower_text, "stop")) {
-        toggle_pause_resume();
-    }
-    else if (strstr(lower_text, "resume") || strstr(lower_text, "start") || strstr(lower_text, "continue")) {
-        if (is_paused) {
-            toggle_pause_resume();
-        } else {
-            show_popup("Restly is already running ▶️", 2);
-        }
-    }
-    else if (strstr(lower_text, "deep work") || strstr(lower_text, "focus") || strstr(lower_text, "session")) {
-        // Extract duration for deep work session
-        int duration_minutes = 45; // default
+            return 3;
         
-        char* num_start = NULL;
-        for (int i = 0; lower_text[i]; i++) {
-            if (isdigit(lower_text[i])) {
-                num_start = &lower_text[i];
-                break;
+        case NL_INTENT_RESUME:
+            if (!state->is_paused) {
+                snprintf(message, size, "Restly is already running ▶️");
+                return 2;
             }
+            state->is_paused = false;
+            state->pause_until = 0;
+            // Reset break timer when resuming
+            state->next_break_time = at + break_interval_seconds;
+            add_txn_log(logs, log_count, TXN_LOG_PAUSE, 0);
+            snprintf(message, size, "Restly resumed ▶️\nBreaks re-enabled");
+            return 3;
+        
+        case NL_INTENT_DEEP_WORK: {
+            // Extract duration for deep work session ("90 min", "until 5pm")
+            int duration_minutes = timed ? nl_time_minutes(when) : 45;
+            
+            state->in_deep_work_session = true;
+            state->deep_work_start_time = at;
+            state->session_end_time = at + duration_minutes * 60;
+            add_txn_log(logs, log_count, TXN_LOG_SESSION_STARTED, duration_minutes);
+            strftime(time_str, sizeof(time_str), "%H:%M", localtime(&state->session_end_time));
+            snprintf(message, size, "Starting %d-minute deep work session! 🎯\nBreaks paused until %s",
+                     duration_minutes, time_str);
+            return 5;
         }
         
-        if (num_start) {
-            int num = atoi(num_start);
+        case NL_INTENT_BREAK_NOW:
+            // Force immediate break
+            state->next_break_time = at;
+            snprintf(message, size, "Taking break now! 🎯");
+            return 3;
+        
+        case NL_INTENT_STATUS: {
+            // Show current status
+            int minutes_until_break = (state->next_break_time - at) / 60;
             
-            if (strstr(num_start, "minute") || strstr(num_start, "min")) {
-                duration_minutes = num;
-            } else if (strstr(num_start, "hour") || strstr(num_start, "hr")) {
-                duration_minutes = num * 60;
+            if (state->is_paused) {
+                snprintf(message, size, "Restly is paused ⏸️\nResume to restart breaks");
+            } else if (state->in_deep_work_session) {
+                int minutes_left = (state->session_end_time - at) / 60;
+                snprintf(message, size, "Deep work session active 🎯\n%d minutes remaining", minutes_left);
             } else {
-                duration_minutes = num;
+                snprintf(message, size, "Next break in %d minutes ⏰", minutes_until_break);
             }
+            return 4;
         }
         
-        set_deep_work_session(duration_minutes);
-    }
-    else if (strstr(lower_text, "break") && strstr(lower_text, "now")) {
-        // Force immediate break
-        next_break_time = time(NULL);
-        show_popup("Taking break now! 🎯", 3);
+        case NL_INTENT_UNKNOWN:
+        default:
+            message[0] = '\0';
+            return 0;
     }
-    else if (strstr(lower_text, "status") || strstr(lower_text, "how") || strstr(lower_text, "what")) {
-        // Show current status
-        char status_msg[200];
-        time_t current_time = time(NULL);
-        int minutes_until_break = (next_break_time - current_time) / 60;
+}
+
+static void append_line(char *message, size_t size, const char *line) {
+    size_t len = strlen(message);
+    snprintf(message + len, size - len, "%s%s", len ? "\n" : "", line);
+}
+
+// Apply the steps of one command as a single transaction: one state change,
+// one group of log records and one confirmation popup. False if no step
+// was understood, so nothing was applied.
+static bool apply_nl_actions(const NLActionList *list, time_t now) {
+    TimerState state = capture_state();
+    TxnLog logs[MAX_TXN_LOGS];
+    int log_count = 0;
+    PendingAction deferred[NL_MAX_ACTIONS];
+    int deferred_count = 0;
+    char message[512] = "";
+    char step_message[256];
+    int popup_seconds = 0;
+    int understood = 0;
+    bool only_status = true;    // a pure status query queues below confirmations
+    
+    for (int i = 0; i < list->count; i++) {
+        const NLAction *action = &list->actions[i];
+        const NLCommand *command = &action->command;
         
-        if (is_paused) {
-            snprintf(status_msg, sizeof(status_msg), "Restly is paused ⏸️\nResume to restart breaks");
-        } else if (in_deep_work_session) {
-            int minutes_left = (session_end_time - current_time) / 60;
-            snprintf(status_msg, sizeof(status_msg), "Deep work session active 🎯\n%d minutes remaining", minutes_left);
-        } else {
-            snprintf(status_msg, sizeof(status_msg), "Next break in %d minutes ⏰", minutes_until_break);
+        if (command->intent == NL_INTENT_UNKNOWN) {
+            snprintf(step_message, sizeof(step_message), "Skipped \"%s\" 🤔", action->clause);
+            append_line(message, sizeof(message), step_message);
+            continue;
+        }
+        understood++;
+        if (command->intent != NL_INTENT_STATUS) {
+            only_status = false;
         }
         
-        show_popup(status_msg, 4);
+        if (action->offset_seconds > 0) {
+            // Later step: queue it and announce when it will happen
+            time_t due = now + action->offset_seconds;
+            char time_str[16];
+            strftime(time_str, sizeof(time_str), "%H:%M", localtime(&due));
+            deferred[deferred_count].due = due;
+            deferred[deferred_count].command = *command;
+            deferred_count++;
+            snprintf(step_message, sizeof(step_message), "Then at %s: %s", time_str, action->clause);
+            append_line(message, sizeof(message), step_message);
+            continue;
+        }
+        
+        int seconds = apply_nl_step(&state, command, now, list->count == 1,
+                                    logs, &log_count, step_message, sizeof(step_message));
+        append_line(message, sizeof(message), step_message);
+        if (seconds > popup_seconds) {
+            popup_seconds = seconds;
+        }
     }
-    else {
+    
+    if (understood == 0) {
         // Unknown command - show help
         char help_msg[400];
         snprintf(help_msg, sizeof(help_msg), 
@@ -284,8 +466,122 @@ void parse_natural_language_command(const char* text) {
                 "• 'resume' or 'start'\n"
                 "• 'deep work 45 minutes'\n"
                 "• 'break now'\n"
-                "• 'status'", text);
-        show_popup(help_msg, 6);
+                "• 'status'", list->count == 1 ? list->actions[0].clause : "");
+        show_popup(help_msg, 6, POPUP_KIND_STATUS);
+        return false;
+    }
+    
+    commit_state(&state);
+    for (int i = 0; i < deferred_count; i++) {
+        pending_actions[pending_count++] = deferred[i];
+    }
+    
+    write_txn_logs(logs, log_count);
+    
+    if (popup_seconds < 3 && list->count > 1) {
+        popup_seconds = 3;
+    }
+    show_popup(message, popup_seconds + (list->count > 1 ? 2 : 0),
+               only_status ? POPUP_KIND_STATUS : POPUP_KIND_CONFIRMATION);
+    return true;
+}
+
+// Apply deferred steps whose time has come. They were confirmed when the
+// command arrived, so they are logged but show no popup of their own.
+static void run_pending_actions(time_t current_time) {
+    int kept = 0;
+    for (int i = 0; i < pending_count; i++) {
+        if (pending_actions[i].due > current_time) {
+            pending_actions[kept++] = pending_actions[i];
+            continue;
+        }
+        
+        TimerState state = capture_state();
+        TxnLog logs[MAX_TXN_LOGS];
+        int log_count = 0;
+        char message[256];
+        
+        apply_nl_step(&state, &pending_actions[i].command, current_time, false,
+                      logs, &log_count, message, sizeof(message));
+        commit_state(&state);
+        log_group_begin();
+        write_txn_logs(logs, log_count);
+        log_group_end();
+    }
+    pending_count = kept;
+}
+
+// What a step is logged and suggested as: the command itself if it has one
+// step, else its clause
+static const char* step_text(const NLActionList *list, int i, const char *text) {
+    return list->count == 1 ? text : list->actions[i].clause;
+}
+
+// Natural language command handler: classifier or keyword rules pick the
+// intents (see nl_parser.c), this applies them to the timer state
+void parse_natural_language_command(const char* text) {
+    if (!text || strlen(text) == 0) {
+        show_popup("Empty command received", 2, POPUP_KIND_STATUS);
+        return;
+    }
+    
+    time_t current_time = time(NULL);
+    NLActionList actions;
+    if (nl_parse_actions(text, current_time, &actions) == 0) {
+        show_popup("Empty command received", 2, POPUP_KIND_STATUS);
+        return;
+    }
+    if (actions.overflow) {
+        // Running the steps that fit would confirm a command that was cut
+        char error_msg[160];
+        snprintf(error_msg, sizeof(error_msg),
+                 "Command not applied ⚠️\nAt most %d steps of %d characters each",
+                 NL_MAX_ACTIONS, NL_CLAUSE_MAX - 1);
+        show_popup(error_msg, 4, POPUP_KIND_STATUS);
+        return;
+    }
+    
+    // All of it or none: a later step with no room to wait would be
+    // confirmed yet never run. Refused before anything is logged, so the
+    // steps understood in the log are those of applied commands.
+    int later_steps = 0;
+    for (int i = 0; i < actions.count; i++) {
+        later_steps += actions.actions[i].command.intent != NL_INTENT_UNKNOWN
+                       && actions.actions[i].offset_seconds > 0;
+    }
+    if (pending_count + later_steps > MAX_PENDING_ACTIONS) {
+        char error_msg[160];
+        snprintf(error_msg, sizeof(error_msg),
+                 "Command not applied ⚠️\n%d later steps requested, room for %d more",
+                 later_steps, MAX_PENDING_ACTIONS - pending_count);
+        show_popup(error_msg, 4, POPUP_KIND_STATUS);
+        return;
+    }
+    
+    // Everything this command logs shares one record group
+    log_group_begin();
+    
+    // Log each step received along with how it was understood
+    for (int i = 0; i < actions.count; i++) {
+        const NLCommand *command = &actions.actions[i].command;
+        log_command_received(step_text(&actions, i, text),
+                             nl_intent_name(command->intent),
+                             nl_source_name(command->source), command->confidence);
+        for (int j = 0; j < command->correction_count; j++) {
+            log_command_corrected(command->corrections[j].typo, command->corrections[j].correction,
+                                  command->corrections[j].distance);
+        }
+    }
+    
+    bool applied = apply_nl_actions(&actions, current_time);
+    log_group_end();
+    
+    // Steps understood become palette suggestions, as logged, the way
+    // completion_init reads them back from the log
+    for (int i = 0; applied && i < actions.count; i++) {
+        if (actions.actions[i].command.intent != NL_INTENT_UNKNOWN) {
+            completion_record(step_text(&actions, i, text), 1);
+        }
     }
 }
 
@@ -305,7 +601,7 @@ void execute_command(CommandAction* action) {
             break;
             
         case CMD_SUMMARIZE_DAY:
-            show_popup("Day summary feature coming soon! 📊", 3);
+            show_popup("Day summary feature coming soon! 📊", 3, POPUP_KIND_STATUS);
             // TODO: Call AI summary script
             break;
             
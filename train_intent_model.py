@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+"""
+Restly Intent Model Trainer
+
+Trains the offline intent classifier used by the daemon's command palette
+parser. Training examples come from the `command_received` events already in
+the activity logs, plus a small built-in seed set, and the result is written
+in the mmappable layout read by nl_classify.c.
+"""
+
+import gzip
+import io
+import json
+import math
+import random
+import shutil
+import struct
+import subprocess
+import sys
+from collections import Counter
+from pathlib import Path
+from typing import Dict, List, Tuple
+import argparse
+
+
+MODEL_MAGIC = b"RSTLYIC1"
+MODEL_VERSION = 1
+MAX_CLASSES = 16
+CLASS_NAME_LEN = 16
+NORMALIZED_MAX = 257    # NL_TEXT_MAX + 1 in nl_classify.c
+
+# Must match NLIntent names in nl_parser.c
+INTENTS = ["unknown", "reschedule", "pause", "resume", "deep_work", "break_now", "status"]
+
+# Canonical phrasings so a fresh install gets a usable model
+SEED_EXAMPLES = [
+    ("reschedule", "reschedule my break"),
+    ("reschedule", "delay the break 10 minutes"),
+    ("reschedule", "postpone break by half an hour"),
+    ("reschedule", "push my break back 15 min"),
+    ("reschedule", "move the break to 3pm"),
+    ("reschedule", "snooze break for 20 minutes"),
+    ("reschedule", "remind me later"),
+    ("reschedule", "not now, in 10 minutes"),
+    ("reschedule", "reschedule my break for after this zoom call"),
+    ("pause", "pause"),
+    ("pause", "pause restly"),
+    ("pause", "stop reminders"),
+    ("pause", "hold all breaks"),
+    ("pause", "turn off breaks for now"),
+    ("pause", "mute reminders"),
+    ("pause", "disable popups"),
+    ("pause", "i'm in a meeting, stop popups"),
+    ("resume", "resume"),
+    ("resume", "resume breaks"),
+    ("resume", "continue reminders"),
+    ("resume", "unpause"),
+    ("resume", "turn breaks back on"),
+    ("resume", "enable popups again"),
+    ("resume", "i'm back"),
+    ("deep_work", "deep work 45 minutes"),
+    ("deep_work", "start a 90 minute focus session"),
+    ("deep_work", "focus mode for an hour"),
+    ("deep_work", "i need to concentrate for 2 hours"),
+    ("deep_work", "do not disturb until 5pm"),
+    ("deep_work", "heads down for 30 min"),
+    ("deep_work", "focus time"),
+    ("deep_work", "deep work session"),
+    ("break_now", "break now"),
+    ("break_now", "take a break now"),
+    ("break_now", "i want a break"),
+    ("break_now", "start the eye routine"),
+    ("break_now", "rest my eyes now"),
+    ("break_now", "give me a break right away"),
+    ("status", "status"),
+    ("status", "when is my next break"),
+    ("status", "how long until the break"),
+    ("status", "what's the status"),
+    ("status", "am i paused"),
+    ("status", "time left in session"),
+    ("unknown", "hello"),
+    ("unknown", "summarize my day"),
+    ("unknown", "thanks"),
+    ("unknown", "open settings"),
+    ("unknown", "what is the weather"),
+    ("unknown", "asdf"),
+]
+
+# Action events that reveal what an unlabelled command meant
+FOLLOW_UP_INTENTS = {
+    "break_rescheduled": "reschedule",
+    "session_started": "deep_work",
+}
+
+
+def normalize(text: str) -> bytes:
+    """Lowercase ASCII alnum, fold everything else to single spaces, pad with spaces.
+
+    Mirrors normalize_text() in nl_classify.c byte for byte.
+    """
+    out = bytearray(b" ")
+    for byte in text.encode("utf-8"):
+        if len(out) >= NORMALIZED_MAX:
+            break
+        if byte < 0x80 and chr(byte).isalnum():
+            out.append(ord(chr(byte).lower()))
+        elif out[-1] != 0x20:
+            out.append(0x20)
+    if out[-1] != 0x20:
+        out.append(0x20)
+    return bytes(out)
+
+
+def fnv1a(data: bytes) -> int:
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def featurize(text: str, buckets: int, ngram_min: int, ngram_max: int) -> Dict[int, float]:
+    """Hashed character n-gram counts, as summed by nl_classifier_predict()."""
+    norm = normalize(text)
+    features: Dict[int, float] = {}
+    mask = buckets - 1
+    for n in range(ngram_min, ngram_max + 1):
+        for i in range(len(norm) - n + 1):
+            bucket = fnv1a(norm[i:i + n]) & mask
+            features[bucket] = features.get(bucket, 0.0) + 1.0
+    return features
+
+
+def open_log(log_file: Path):
+    """Text stream of JSON lines from a plain, gzipped or binary log."""
+    if ".rlog" in log_file.suffixes:
+        # Binary logs are converted by the daemon's reader
+        tool = shutil.which("restly-log") or str(Path(__file__).resolve().parent / "restly-log")
+        result = subprocess.run([tool, "cat", "--json", str(log_file)],
+                                capture_output=True, text=True, check=False)
+        if result.returncode != 0:
+            print(f"Warning: {log_file}: {result.stderr.strip()}", file=sys.stderr)
+        return io.StringIO(result.stdout)
+    opener = gzip.open if log_file.suffix == ".gz" else open
+    return opener(log_file, 'rt', encoding='utf-8')
+
+
+def load_log_examples(activity_dir: Path) -> List[Tuple[str, str]]:
+    """Label command_received events from the activity logs.
+
+    Newer logs record the intent the keyword rules picked (possibly after
+    typo correction, which teaches the model common misspellings); older ones are
+    labelled by the action event that followed the command.
+    """
+    examples = []
+    # Past days are gzipped; a day may also have a plain file of late events,
+    # and either may be JSON lines or binary (--log-format)
+    log_files = [log_file for pattern in ("activity_*.jsonl.gz", "activity_*.jsonl",
+                                          "activity_*.rlog.gz", "activity_*.rlog")
+                 for log_file in activity_dir.glob(pattern)]
+    for log_file in sorted(log_files):
+        events = []
+        try:
+            with open_log(log_file) as f:
+                for line in f:
+                    line = line.strip()
+                    if not line:
+                        continue
+                    try:
+                        events.append(json.loads(line))
+                    except json.JSONDecodeError:
+                        continue
+        except (IOError, EOFError) as e:
+            print(f"Error reading log file {log_file}: {e}", file=sys.stderr)
+            continue
+
+        for i, event in enumerate(events):
+            if event.get("event_type") != "command_received":
+                continue
+            data = event.get("event_data", {})
+            text = data.get("command_text", "").strip()
+            if not text:
+                continue
+
+            label = None
+            if data.get("intent_source") in ("rules", "fuzzy") and data.get("intent") in INTENTS:
+                label = data["intent"]
+            elif i + 1 < len(events):
+                follow = events[i + 1]
+                follow_type = follow.get("event_type")
+                if follow_type == "pause_toggled":
+                    paused = follow.get("event_data", {}).get("is_paused", True)
+                    label = "pause" if paused else "resume"
+                else:
+                    label = FOLLOW_UP_INTENTS.get(follow_type)
+            if label:
+                examples.append((label, text))
+    return examples
+
+
+def load_label_file(path: Path) -> List[Tuple[str, str]]:
+    """Read hand-labelled examples, one "intent<TAB>text" per line."""
+    examples = []
+    with open(path, 'r', encoding='utf-8') as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not line or line.startswith("#") or "\t" not in line:
+                continue
+            label, text = line.split("\t", 1)
+            if label in INTENTS:
+                examples.append((label, text))
+    return examples
+
+
+def train(examples: List[Tuple[str, str]], buckets: int, ngram_min: int, ngram_max: int,
+          epochs: int, learning_rate: float, l2: float):
+    """Multinomial logistic regression trained with plain SGD."""
+    n_classes = len(INTENTS)
+    bias = [0.0] * n_classes
+    weights: Dict[int, List[float]] = {}
+    data = [(INTENTS.index(label), featurize(text, buckets, ngram_min, ngram_max))
+            for label, text in examples]
+    rng = random.Random(0)
+
+    for epoch in range(epochs):
+        rng.shuffle(data)
+        rate = learning_rate / (1 + epoch * 0.1)
+        for label, features in data:
+            scores = list(bias)
+            for bucket, value in features.items():
+                row = weights.get(bucket)
+                if row:
+                    for c in range(n_classes):
+                        scores[c] += row[c] * value
+            top = max(scores)
+            exps = [math.exp(s - top) for s in scores]
+            total = sum(exps)
+            for c in range(n_classes):
+                grad = exps[c] / total - (1.0 if c == label else 0.0)
+                bias[c] -= rate * grad
+                for bucket, value in features.items():
+                    row = weights.setdefault(bucket, [0.0] * n_classes)
+                    row[c] -= rate * (grad * value + l2 * row[c])
+
+    return bias, weights, data
+
+
+def predict(bias, weights, features) -> int:
+    scores = list(bias)
+    for bucket, value in features.items():
+        row = weights.get(bucket)
+        if row:
+            for c in range(len(scores)):
+                scores[c] += row[c] * value
+    return max(range(len(scores)), key=lambda c: scores[c])
+
+
+def write_model(path: Path, bias, weights, buckets: int, ngram_min: int, ngram_max: int):
+    """Write the NLModelHeader layout from nl_classify.h, then bias and weights."""
+    n_classes = len(INTENTS)
+    header = struct.pack("=8s6I", MODEL_MAGIC, MODEL_VERSION, n_classes, buckets,
+                         ngram_min, ngram_max, 0)
+    names = b"".join(name.encode("ascii").ljust(CLASS_NAME_LEN, b"\0")
+                     for name in INTENTS)
+    names = names.ljust(MAX_CLASSES * CLASS_NAME_LEN, b"\0")
+
+    table = [0.0] * (buckets * n_classes)
+    for bucket, row in weights.items():
+        table[bucket * n_classes:(bucket + 1) * n_classes] = row
+
+    tmp_path = path.with_suffix(".tmp")
+    with open(tmp_path, 'wb') as f:
+        f.write(header)
+        f.write(names)
+        f.write(struct.pack(f"={n_classes}f", *bias))
+        f.write(struct.pack(f"={len(table)}f", *table))
+    tmp_path.replace(path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Train Restly's offline intent classifier")
+    parser.add_argument("--config-dir", type=str,
+                        help="Restly config directory (default: ~/.config/restly)")
+    parser.add_argument("--output", type=str,
+                        help="Model path (default: <config-dir>/intent_model.bin)")
+    parser.add_argument("--labels", type=str,
+                        help="Extra hand-labelled examples, one 'intent<TAB>text' per line")
+    parser.add_argument("--no-seed", action="store_true",
+                        help="Train only on logged and labelled examples")
+    parser.add_argument("--buckets", type=int, default=16384,
+                        help="Hash buckets, power of two (default: 16384)")
+    parser.add_argument("--ngram-min", type=int, default=2)
+    parser.add_argument("--ngram-max", type=int, default=4)
+    parser.add_argument("--epochs", type=int, default=30)
+    parser.add_argument("--learning-rate", type=float, default=0.2)
+    parser.add_argument("--l2", type=float, default=1e-4)
+
+    args = parser.parse_args()
+
+    if args.buckets <= 0 or args.buckets & (args.buckets - 1):
+        print("Error: --buckets must be a power of two", file=sys.stderr)
+        sys.exit(1)
+    if not 1 <= args.ngram_min <= args.ngram_max <= 8:
+        print("Error: need 1 <= --ngram-min <= --ngram-max <= 8", file=sys.stderr)
+        sys.exit(1)
+
+    config_dir = Path(args.config_dir) if args.config_dir else Path.home() / ".config" / "restly"
+    output = Path(args.output) if args.output else config_dir / "intent_model.bin"
+
+    examples = load_log_examples(config_dir / "activity")
+    logged = len(examples)
+    if args.labels:
+        examples += load_label_file(Path(args.labels))
+    if not args.no_seed:
+        examples += SEED_EXAMPLES
+
+    if not examples:
+        print("No training examples found", file=sys.stderr)
+        sys.exit(1)
+
+    bias, weights, data = train(examples, args.buckets, args.ngram_min, args.ngram_max,
+                                args.epochs, args.learning_rate, args.l2)
+    correct = sum(1 for label, features in data if predict(bias, weights, features) == label)
+
+    output.parent.mkdir(parents=True, exist_ok=True)
+    write_model(output, bias, weights, args.buckets, args.ngram_min, args.ngram_max)
+
+    counts = Counter(label for label, _ in examples)
+    print(f"Trained on {len(examples)} examples ({logged} from activity logs)")
+    for intent in INTENTS:
+        print(f"  {intent:<12} {counts.get(intent, 0)}")
+    print(f"Training accuracy: {correct / len(data) * 100:.1f}%")
+    print(f"Model saved to: {output} ({output.stat().st_size} bytes)")
+
+
+if __name__ == "__main__":
+    main()